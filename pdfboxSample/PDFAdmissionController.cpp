@@ -0,0 +1,175 @@
+﻿// PDFAdmissionController.cpp
+#include "PDFAdmissionController.h"
+#include "PDFStructureScanner.h"
+#include <algorithm> // std::max, std::min
+#include <cmath> // std::floor
+
+namespace {
+
+	const int64_t DOCUMENT_BASE_BYTES = 8 * 1024 * 1024;	// PDDocument, 폰트 캐시 등 고정 비용
+	const int64_t DOCUMENT_BYTES_PER_FILE_BYTE = 2;			// COS 오브젝트 트리
+	const int64_t IMAGE_DECODE_RATIO = 8;					// 압축된 이미지 -> 디코딩된 래스터
+	const float LETTER_WIDTH = 612.0f;
+	const float LETTER_HEIGHT = 792.0f;
+	const int CANCEL_POLL_INTERVAL_MS = 50;					// CancelToken 은 알림이 없으므로 기다리는 동안 이 주기로 확인한다.
+
+	int pixelSize(float points, float dpi)
+	{
+		return std::max(static_cast<int>(std::floor(points * dpi / 72.0f)), 1);
+	}
+
+	// 임시 파일로 내보내는 만큼 힙의 COS 오브젝트 트리가 줄어든다.
+	int64_t documentBytes(const PDF::Converter::DocumentStructure& structure, const PDF::Converter::MemoryOptions& memory)
+	{
+		const int64_t streamBytes = structure.fileSize * DOCUMENT_BYTES_PER_FILE_BYTE;
+		switch (memory.policy) {
+		case PDF::Converter::MemoryPolicy::Mixed:
+			return DOCUMENT_BASE_BYTES + std::min(streamBytes, std::max<int64_t>(memory.mainMemoryBytes, 0));
+		case PDF::Converter::MemoryPolicy::TempFile:
+			return DOCUMENT_BASE_BYTES;
+		default:
+			return DOCUMENT_BASE_BYTES + streamBytes;
+		}
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	int64_t EstimateRasterBytes(int width, int height, PixelFormat format)
+	{
+		switch (format) {
+		case PixelFormat::Mono:
+			return static_cast<int64_t>((width + 7) / 8) * height;
+		case PixelFormat::Gray:
+			return static_cast<int64_t>(width) * height;
+		default:
+			return static_cast<int64_t>(width) * height * 4; // TYPE_INT_RGB, TYPE_INT_ARGB
+		}
+	}
+
+	MemoryEstimate EstimateImageMemory(const DocumentStructure& structure, const ImageOptions& options, bool hasBridge)
+	{
+		const bool modulePath = UsesModulePath(options, hasBridge);
+		PixelFormat format = options.format == PixelFormat::Default ? PixelFormat::RGB : options.format;
+		if (!options.variants.empty() && format == PixelFormat::Mono) {
+			format = PixelFormat::Gray;
+		}
+
+		std::vector<PageGeometry> letter(1);
+		letter[0].cropBox[2] = LETTER_WIDTH;
+		letter[0].cropBox[3] = LETTER_HEIGHT;
+		const std::vector<PageGeometry>& pages = structure.pages.empty() ? letter : structure.pages;
+
+		int64_t pageBytes = 0;
+		for (const PageGeometry& page : pages) {
+			const float width = page.Width();
+			const float height = page.Height();
+			float dpi = static_cast<float>(options.dpi);
+			if (!options.variants.empty()) {
+				// 변형은 가장 큰 해상도로 한번 렌더링하고 C++ 쪽에 복사본을 만든다.
+				dpi = 0.0f;
+				for (const ImageVariant& variant : options.variants) {
+					dpi = std::max(dpi, variant.dpi > 0 ? variant.dpi : variant.maxSize * 72.0f / std::max(std::max(width, height), 1.0f));
+				}
+				pageBytes = std::max(pageBytes, EstimateRasterBytes(pixelSize(width, dpi), pixelSize(height, dpi), format) * 2);
+				continue;
+			}
+
+			const int widthPx = pixelSize(width, dpi);
+			const int heightPx = pixelSize(height, dpi);
+			const bool tiled = !modulePath && (options.tileMode == TileMode::Always || options.tileSink
+				|| (options.tileMode == TileMode::Auto && static_cast<int64_t>(widthPx) * heightPx > options.tilePixelThreshold));
+			if (tiled) {
+				pageBytes = std::max(pageBytes, EstimateRasterBytes(std::min(options.tileSize, widthPx), std::min(options.tileSize, heightPx), format));
+			} else {
+				// 중복 검출, 빈 페이지 검출, 자동 자르기는 C++ 쪽에 페이지 복사본을 만든다.
+				const int copies = (!modulePath && (options.duplicates || options.blankPages.detect || options.autoCrop.enabled)) ? 2 : 1;
+				pageBytes = std::max(pageBytes, EstimateRasterBytes(widthPx, heightPx, format) * copies);
+			}
+		}
+
+		MemoryEstimate estimate;
+		estimate.documentBytes = documentBytes(structure, options.memory);
+		estimate.pageBytes = pageBytes;
+		if (structure.imageCount > 0) {
+			estimate.pageBytes += structure.imageBytes / structure.imageCount * IMAGE_DECODE_RATIO;
+		}
+		return estimate;
+	}
+
+	MemoryEstimate EstimateTextMemory(const DocumentStructure& structure, const MemoryOptions& memory /*= MemoryOptions()*/)
+	{
+		// 텍스트 추출은 이미지를 디코딩하지 않지만 문서 전체의 글자 위치를 모은다.
+		MemoryEstimate estimate;
+		estimate.documentBytes = documentBytes(structure, memory);
+		estimate.pageBytes = std::max<int64_t>(structure.fileSize - structure.imageBytes, 0);
+		return estimate;
+	}
+
+	AdmissionController::AdmissionController(int64_t budgetBytes)
+	: m_Budget(budgetBytes)
+	, m_InUse(0)
+	, m_Peak(0)
+	, m_Running(0)
+	, m_NextTicket(0)
+	, m_Serving(0)
+	{
+	}
+
+	bool AdmissionController::Acquire(int64_t bytes, const CancelToken* cancelToken /*= nullptr*/)
+	{
+		// 도착 순서대로 허가해서 큰 작업이 작은 작업들에 밀려 굶지 않게 한다.
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		const uint64_t ticket = m_NextTicket++;
+		auto admissible = [&]() {
+			return ticket == m_Serving && (m_Running == 0 || m_InUse + bytes <= m_Budget);
+		};
+		while (!admissible()) {
+			if (!cancelToken) {
+				m_Released.wait(lock);
+			} else if (cancelToken->IsCancelled()) {
+				// 차례가 된 순번이면 넘기고, 아니면 차례가 올 때 건너뛰도록 남긴다.
+				if (ticket == m_Serving) {
+					nextTicket();
+				} else {
+					m_Abandoned.insert(ticket);
+				}
+				m_Released.notify_all();
+				return false;
+			} else {
+				m_Released.wait_for(lock, std::chrono::milliseconds(CANCEL_POLL_INTERVAL_MS));
+			}
+		}
+		nextTicket();
+		m_Running++;
+		m_InUse += bytes;
+		m_Peak = std::max(m_Peak, m_InUse);
+		m_Released.notify_all(); // 다음 순번이 들어올 수 있는지 확인하게 한다.
+		return true;
+	}
+
+	void AdmissionController::nextTicket()
+	{
+		m_Serving++;
+		while (m_Abandoned.erase(m_Serving) > 0) {
+			m_Serving++;
+		}
+	}
+
+	void AdmissionController::Release(int64_t bytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_InUse -= bytes;
+			m_Running--;
+		}
+		m_Released.notify_all();
+	}
+
+	int64_t AdmissionController::Peak() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Peak;
+	}
+
+}} // PDF::Converter
@@ -0,0 +1,87 @@
+﻿// PDFAdmissionController.h
+#pragma once
+#include <mutex> // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <set> // std::set
+#include <stdint.h> // int64_t
+#include "PDFBoxConverter.h"
+
+namespace PDF { namespace Converter {
+
+	struct DocumentStructure;
+
+	// 변환 한 건이 자바 힙에서 동시에 차지하는 메모리 추정치
+	struct MemoryEstimate
+	{
+		int64_t documentBytes = 0;	// 파싱된 문서 (파일 크기 비례)
+		int64_t pageBytes = 0;		// 가장 큰 페이지의 렌더링 버퍼 (타일이면 타일 하나)
+
+		int64_t Total() const { return documentBytes + pageBytes; }
+	}; // struct MemoryEstimate
+
+	// 가로 x 세로 x 픽셀 포맷 크기로 렌더링 버퍼 크기를 구한다. (BufferedImage 기준)
+	int64_t EstimateRasterBytes(int width, int height, PixelFormat format);
+	// structure 가 유효하지 않으면 (pageCount < 0) 파일 크기와 Letter 크기로 추정한다.
+	// hasBridge 는 PDFBox 직접 렌더링을 사용할 수 있는지 (UsesModulePath())
+	MemoryEstimate EstimateImageMemory(const DocumentStructure& structure, const ImageOptions& options, bool hasBridge);
+	MemoryEstimate EstimateTextMemory(const DocumentStructure& structure, const MemoryOptions& memory = MemoryOptions());
+
+	// 메모리 예산 안에서만 변환을 시작시킨다. 예산을 넘으면 다른 변환이 끝날 때까지 기다린다.
+	// 예산보다 큰 작업 하나는 실행 중인 작업이 없을 때 단독으로 시작한다.
+	// 기다리는 동안 취소되면 순번을 포기하므로 뒤의 작업을 막지 않는다.
+	class AdmissionController
+	{
+	public:
+		explicit AdmissionController(int64_t budgetBytes);
+
+	public:
+		bool Acquire(int64_t bytes, const CancelToken* cancelToken = nullptr); // 허가 전에 취소되면 false (Release 하지 않는다)
+		void Release(int64_t bytes);
+
+		int64_t Budget() const { return m_Budget; }
+		int64_t Peak() const; // 동시에 허가된 메모리의 최대값
+
+	private:
+		void nextTicket(); // m_Mutex 를 잡고 호출한다.
+
+	private:
+		const int64_t m_Budget;
+		int64_t m_InUse;
+		int64_t m_Peak;
+		int m_Running;
+		uint64_t m_NextTicket;	// 대기 순번
+		uint64_t m_Serving;
+		std::set<uint64_t> m_Abandoned; // 차례가 오기 전에 취소된 순번
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Released;
+	}; // class AdmissionController
+
+	// 범위를 벗어나면 Release 한다.
+	class AdmissionTicket
+	{
+	public:
+		AdmissionTicket(AdmissionController* controller, int64_t bytes, const CancelToken* cancelToken = nullptr)
+		: m_Controller(controller)
+		, m_Bytes(bytes)
+		{
+			if (m_Controller && !m_Controller->Acquire(m_Bytes, cancelToken)) {
+				m_Controller = nullptr; // 허가받지 못했다.
+			}
+		}
+		~AdmissionTicket()
+		{
+			if (m_Controller) {
+				m_Controller->Release(m_Bytes);
+			}
+		}
+
+	private:
+		AdmissionTicket(const AdmissionTicket&) = delete;
+		AdmissionTicket& operator=(const AdmissionTicket&) = delete;
+
+	private:
+		AdmissionController* m_Controller;
+		int64_t m_Bytes;
+	}; // class AdmissionTicket
+
+}} // PDF::Converter
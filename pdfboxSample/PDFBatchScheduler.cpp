@@ -0,0 +1,370 @@
+﻿// PDFBatchScheduler.cpp
+#include "PDFBatchScheduler.h"
+#include "PDFStructureScanner.h"
+#include "pdf_assert.h"
+#include "pdf_utils.h"
+#include <thread> // std::thread
+#include <chrono> // std::chrono
+#include <algorithm> // std::max, std::sort
+#include <cmath> // std::floor, std::fabs, std::ceil
+#include <stdio.h> // fopen, fprintf
+#include <limits.h> // INT_MIN
+
+namespace {
+
+	const double BYTES_PER_MB = 1024.0 * 1024.0;
+	const float LETTER_WIDTH = 612.0f;
+	const float LETTER_HEIGHT = 792.0f;
+	const int64_t BYTES_PER_UNSCANNED_PAGE = 100 * 1024; // 구조 분석 실패 시 페이지 수 추정
+
+	// 초기 가중치 (초) : 고정, 페이지, 메가픽셀, 이미지 MB, 나머지 MB
+	const double IMAGE_WEIGHTS[] = { 0.3, 0.01, 0.04, 0.05, 0.02 };
+	const double TEXT_WEIGHTS[] = { 0.3, 0.005, 0.0, 0.001, 0.05 };
+	const double LEARNING_RATE = 0.5;
+	const double MIN_QUEUE_WEIGHT = 0.01; // 가중치 0 인 큐도 결국 실행되도록 한다.
+	const double MIN_QUANTUM_SECONDS = 0.001;
+
+	double pageMegaPixels(float width, float height, int dpi)
+	{
+		const double widthPx = std::max(std::floor(width * dpi / 72.0), 1.0);
+		const double heightPx = std::max(std::floor(height * dpi / 72.0), 1.0);
+		return widthPx * heightPx / 1000000.0;
+	}
+
+	const char* policyName(PDF::Converter::SchedulePolicy policy)
+	{
+		switch (policy) {
+		case PDF::Converter::SchedulePolicy::FIFO: return "fifo";
+		case PDF::Converter::SchedulePolicy::ShortestFirst: return "sjf";
+		case PDF::Converter::SchedulePolicy::LongestFirst: return "ljf";
+		}
+		return "";
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	CostModel::CostModel(bool text)
+	{
+		const double* weights = text ? TEXT_WEIGHTS : IMAGE_WEIGHTS;
+		for (int i = 0; i < FEATURE_COUNT; i++) {
+			m_Weights[i] = weights[i];
+		}
+	}
+
+	void CostModel::features(const BatchJob& job, double x[FEATURE_COUNT]) const
+	{
+		x[0] = 1.0;
+		x[1] = job.pageCount;
+		x[2] = job.megaPixels;
+		x[3] = job.imageBytes / BYTES_PER_MB;
+		x[4] = std::max<int64_t>(job.fileSize - job.imageBytes, 0) / BYTES_PER_MB;
+	}
+
+	double CostModel::Predict(const BatchJob& job) const
+	{
+		double x[FEATURE_COUNT];
+		features(job, x);
+		double seconds = 0.0;
+		for (int i = 0; i < FEATURE_COUNT; i++) {
+			seconds += m_Weights[i] * x[i];
+		}
+		return seconds;
+	}
+
+	void CostModel::Update(const BatchJob& job, double actualSeconds)
+	{
+		double x[FEATURE_COUNT];
+		features(job, x);
+		double norm = 1e-9;
+		for (int i = 0; i < FEATURE_COUNT; i++) {
+			norm += x[i] * x[i];
+		}
+		// 예측 오차를 특징 크기로 정규화해 반영하고 음수 비용은 허용하지 않는다.
+		const double error = actualSeconds - Predict(job);
+		for (int i = 0; i < FEATURE_COUNT; i++) {
+			m_Weights[i] = std::max(m_Weights[i] + LEARNING_RATE * error * x[i] / norm, 0.0);
+		}
+	}
+
+	BatchScheduler::BatchScheduler(const BatchOptions& options)
+	: m_Options(options)
+	, m_Model(options.dpi <= 0)
+	, m_Current(0)
+	, m_QuantumAdded(false)
+	, m_Makespan(0.0)
+	{
+	}
+
+	void BatchScheduler::AddQueue(const BatchQueue& queue)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		BatchQueue& target = m_Queues[queueIndex(queue.name)];
+		target = queue;
+		target.weight = std::max(queue.weight, MIN_QUEUE_WEIGHT);
+	}
+
+	int BatchScheduler::queueIndex(const std::string& name)
+	{
+		for (size_t i = 0; i < m_Queues.size(); i++) {
+			if (m_Queues[i].name == name) {
+				return static_cast<int>(i);
+			}
+		}
+		BatchQueue queue;
+		queue.name = name;
+		m_Queues.push_back(queue);
+		m_Pending.push_back(std::vector<int>());
+		m_Deficit.push_back(0.0);
+		return static_cast<int>(m_Queues.size() - 1);
+	}
+
+	bool BatchScheduler::Add(const std::wstring& sourceFile, const std::string& queue /*= std::string()*/)
+	{
+		BatchJob job;
+		job.sourceFile = sourceFile;
+		job.queue = queue;
+
+		DocumentStructure structure;
+		job.scanned = ScanStructure(sourceFile.c_str(), structure);
+		if (job.scanned) {
+			job.fileSize = structure.fileSize;
+			job.pageCount = structure.pageCount;
+			job.imageBytes = structure.imageBytes;
+			if (m_Options.dpi > 0) {
+				for (const PageGeometry& page : structure.pages) {
+					job.megaPixels += pageMegaPixels(page.Width(), page.Height(), m_Options.dpi);
+				}
+				if (!structure.pagesComplete) {
+					job.megaPixels = job.pageCount * pageMegaPixels(LETTER_WIDTH, LETTER_HEIGHT, m_Options.dpi);
+				}
+			}
+		} else {
+			AutoFilePtr fp(fopen(_U2A(sourceFile).c_str(), "rb"));
+			if (fp) {
+				fseek(fp.get(), 0, SEEK_END);
+				job.fileSize = ftell(fp.get());
+			}
+			job.pageCount = static_cast<int>(std::max<int64_t>(job.fileSize / BYTES_PER_UNSCANNED_PAGE, 1));
+			if (m_Options.dpi > 0) {
+				job.megaPixels = job.pageCount * pageMegaPixels(LETTER_WIDTH, LETTER_HEIGHT, m_Options.dpi);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_Pending[queueIndex(queue)].push_back(static_cast<int>(m_Jobs.size()));
+		m_Jobs.push_back(job);
+		return job.scanned;
+	}
+
+	size_t BatchScheduler::pickInQueue(const std::vector<int>& pending, double* cost) const
+	{
+		// 모델이 계속 보정되므로 꺼낼 때마다 남은 작업을 다시 평가한다.
+		size_t best = 0;
+		double bestCost = m_Model.Predict(m_Jobs[pending[0]]);
+		if (m_Options.policy != SchedulePolicy::FIFO) {
+			for (size_t i = 1; i < pending.size(); i++) {
+				const double cost = m_Model.Predict(m_Jobs[pending[i]]);
+				if (m_Options.policy == SchedulePolicy::ShortestFirst ? cost < bestCost : cost > bestCost) {
+					best = i;
+					bestCost = cost;
+				}
+			}
+		}
+		*cost = bestCost;
+		return best;
+	}
+
+	int BatchScheduler::takeNext()
+	{
+		// 대기 작업이 있는 큐 중 가장 높은 우선순위만 후보로 삼는다.
+		int topPriority = INT_MIN;
+		for (size_t q = 0; q < m_Queues.size(); q++) {
+			if (!m_Pending[q].empty()) {
+				topPriority = std::max(topPriority, m_Queues[q].priority);
+			}
+		}
+		if (topPriority == INT_MIN) {
+			return -1;
+		}
+
+		// 몫의 단위는 후보 큐들의 다음 작업 중 가장 큰 예상 시간이므로 가중치 1 인 큐는 차례가 올 때마다
+		// 적어도 한 작업을 실행한다. 모델이 보정되어도 남은 몫이 유지되도록 이 단위로 환산해서 쌓는다.
+		double quantum = MIN_QUANTUM_SECONDS;
+		for (size_t q = 0; q < m_Queues.size(); q++) {
+			if (!m_Pending[q].empty() && m_Queues[q].priority == topPriority) {
+				double cost = 0.0;
+				pickInQueue(m_Pending[q], &cost);
+				quantum = std::max(quantum, cost);
+			}
+		}
+
+		auto advance = [&]() {
+			m_Current = (m_Current + 1) % m_Queues.size();
+			m_QuantumAdded = false;
+		};
+		for (;;) {
+			const size_t q = m_Current % m_Queues.size();
+			std::vector<int>& pending = m_Pending[q];
+			if (pending.empty() || m_Queues[q].priority != topPriority) {
+				advance();
+				continue;
+			}
+			if (!m_QuantumAdded) {
+				m_Deficit[q] += m_Queues[q].weight;
+				m_QuantumAdded = true;
+			}
+			double cost = 0.0;
+			const size_t best = pickInQueue(pending, &cost);
+			if (m_Deficit[q] < cost / quantum) {
+				advance();
+				continue;
+			}
+
+			m_Deficit[q] -= cost / quantum;
+			const int jobIndex = pending[best];
+			pending.erase(pending.begin() + best);
+			if (pending.empty()) {
+				m_Deficit[q] = 0.0; // 쉬는 큐는 몫을 쌓아두지 않는다.
+				advance();
+			}
+			m_Jobs[jobIndex].predictedSeconds = cost;
+			return jobIndex;
+		}
+	}
+
+	bool BatchScheduler::Run(const BatchConvert& convert)
+	{
+		_ASSERTE(convert && "convert is not Null");
+		if (!convert) {
+			return false;
+		}
+
+		const std::chrono::steady_clock::time_point batchBegin = std::chrono::steady_clock::now();
+		int nextOrder = 0;
+		bool result = true;
+		auto work = [&]() {
+			for (;;) {
+				int jobIndex = -1;
+				BatchJob job;
+				{
+					std::lock_guard<std::mutex> lock(m_Mutex);
+					jobIndex = takeNext();
+					if (jobIndex < 0) {
+						return;
+					}
+					m_Jobs[jobIndex].order = nextOrder++;
+					m_Jobs[jobIndex].startedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchBegin).count();
+					job = m_Jobs[jobIndex];
+				}
+
+				const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+				const bool jobResult = convert(job);
+				const std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+
+				std::lock_guard<std::mutex> lock(m_Mutex);
+				BatchJob& done = m_Jobs[jobIndex];
+				done.result = jobResult;
+				done.actualSeconds = std::chrono::duration<double>(end - begin).count();
+				done.finishedSeconds = std::chrono::duration<double>(end - batchBegin).count();
+				if (jobResult) {
+					m_Model.Update(done, done.actualSeconds); // 실패한 작업의 시간은 비용을 대표하지 않는다.
+				} else {
+					result = false;
+				}
+			}
+		};
+
+		std::vector<std::thread> workers;
+		for (int i = 1; i < m_Options.workers; i++) {
+			workers.emplace_back(work);
+		}
+		work();
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		m_Makespan = std::chrono::duration<double>(std::chrono::steady_clock::now() - batchBegin).count();
+		return result;
+	}
+
+	bool BatchScheduler::WriteReport(const std::string& reportFile) const
+	{
+		AutoFilePtr fp(fopen(reportFile.c_str(), "wb"));
+		_ASSERTE(fp && "fopen() Failed");
+		if (!fp) {
+			return false;
+		}
+
+		fprintf(fp.get(), "order,source,scanned,file_size,pages,megapixels,image_bytes,predicted_sec,actual_sec,finished_sec,result,queue,started_sec\n");
+		double completionSum = 0.0;
+		double errorSum = 0.0;
+		int measured = 0;
+		for (const BatchJob& job : m_Jobs) {
+			std::string source = _U2UTF8(job.sourceFile);
+			for (size_t pos = source.find('"'); pos != std::string::npos; pos = source.find('"', pos + 2)) {
+				source.insert(pos, 1, '"'); // CSV 따옴표 이스케이프
+			}
+			fprintf(fp.get(), "%d,\"%s\",%d,%lld,%d,%.3f,%lld,%.3f,%.3f,%.3f,%d,\"%s\",%.3f\n",
+				job.order, source.c_str(), job.scanned ? 1 : 0, static_cast<long long>(job.fileSize), job.pageCount,
+				job.megaPixels, static_cast<long long>(job.imageBytes), job.predictedSeconds, job.actualSeconds, job.finishedSeconds, job.result ? 1 : 0,
+				job.queue.c_str(), job.startedSeconds);
+			completionSum += job.finishedSeconds;
+			if (job.order >= 0 && job.actualSeconds > 0.0) {
+				errorSum += std::fabs(job.predictedSeconds - job.actualSeconds) / job.actualSeconds;
+				measured++;
+			}
+		}
+
+		const size_t jobCount = std::max<size_t>(m_Jobs.size(), 1);
+		fprintf(fp.get(), "# policy=%s workers=%d jobs=%d makespan_sec=%.3f mean_completion_sec=%.3f mean_abs_error_pct=%.1f\n",
+			policyName(m_Options.policy), m_Options.workers, static_cast<int>(m_Jobs.size()), m_Makespan,
+			completionSum / jobCount, measured ? errorSum * 100.0 / measured : 0.0);
+		for (const QueueStats& stats : Statistics()) {
+			fprintf(fp.get(), "# queue=\"%s\" priority=%d weight=%.2f jobs=%d failed=%d pages=%d mean_wait_sec=%.3f p95_latency_sec=%.3f jobs_per_sec=%.3f pages_per_sec=%.3f\n",
+				stats.queue.name.c_str(), stats.queue.priority, stats.queue.weight, stats.jobs, stats.failed, stats.pages,
+				stats.meanWaitSeconds, stats.p95LatencySeconds, stats.jobsPerSecond, stats.pagesPerSecond);
+		}
+		return true;
+	}
+
+	std::vector<QueueStats> BatchScheduler::Statistics() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		std::vector<QueueStats> statistics;
+		for (const BatchQueue& queue : m_Queues) {
+			QueueStats stats;
+			stats.queue = queue;
+			std::vector<double> latencies;
+			double waitSum = 0.0;
+			double lastFinished = 0.0;
+			for (const BatchJob& job : m_Jobs) {
+				if (job.queue != queue.name || job.order < 0) {
+					continue; // 실행하지 않은 작업
+				}
+				stats.jobs++;
+				if (job.result) {
+					stats.pages += std::max(job.pageCount, 0);
+				} else {
+					stats.failed++;
+				}
+				waitSum += job.startedSeconds;
+				latencies.push_back(job.finishedSeconds);
+				lastFinished = std::max(lastFinished, job.finishedSeconds);
+			}
+			if (stats.jobs > 0) {
+				std::sort(latencies.begin(), latencies.end());
+				const size_t p95 = static_cast<size_t>(std::ceil(latencies.size() * 0.95)) - 1;
+				stats.meanWaitSeconds = waitSum / stats.jobs;
+				stats.p95LatencySeconds = latencies[std::min(p95, latencies.size() - 1)];
+			}
+			if (lastFinished > 0.0) {
+				stats.jobsPerSecond = (stats.jobs - stats.failed) / lastFinished;
+				stats.pagesPerSecond = stats.pages / lastFinished;
+			}
+			statistics.push_back(stats);
+		}
+		return statistics;
+	}
+
+}} // PDF::Converter
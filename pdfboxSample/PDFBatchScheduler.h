@@ -0,0 +1,122 @@
+﻿// PDFBatchScheduler.h
+#pragma once
+#include <string> // std::string, std::wstring
+#include <vector> // std::vector
+#include <functional> // std::function
+#include <mutex> // std::mutex
+#include <stdint.h> // int64_t
+
+namespace PDF { namespace Converter {
+
+	// 배치 작업 실행 순서
+	enum class SchedulePolicy
+	{
+		FIFO,			// 입력 순서
+		ShortestFirst,	// 예상 시간이 짧은 작업부터 (평균 완료 시간 최소화)
+		LongestFirst	// 예상 시간이 긴 작업부터 (작업자가 여럿일 때 전체 완료 시간 최소화)
+	}; // enum class SchedulePolicy
+
+	// 작업 큐 (테넌트). 우선순위가 높은 큐의 작업을 먼저 실행하고
+	// 우선순위가 같은 큐끼리는 가중치 비율로 실행 시간을 나눈다. (예상 시간 기준 Deficit Round Robin)
+	struct BatchQueue
+	{
+		std::string name;
+		int priority = 0;		// 클수록 먼저 실행한다.
+		double weight = 1.0;	// 같은 우선순위 안에서의 몫
+	}; // struct BatchQueue
+
+	// 큐별 지연 시간, 처리량
+	struct QueueStats
+	{
+		BatchQueue queue;
+		int jobs = 0;
+		int failed = 0;
+		int pages = 0;
+		double meanWaitSeconds = 0.0;	// 배치 시작부터 실행 시작까지
+		double p95LatencySeconds = 0.0;	// 배치 시작부터 완료까지
+		double jobsPerSecond = 0.0;		// 큐의 마지막 완료 시점 기준
+		double pagesPerSecond = 0.0;
+	}; // struct QueueStats
+
+	struct BatchJob
+	{
+		std::wstring sourceFile;
+		std::string queue;				// BatchQueue::name
+		// 비용 신호 (PDFStructureScanner)
+		int64_t fileSize = 0;
+		int pageCount = 0;
+		double megaPixels = 0.0;		// 렌더링할 전체 픽셀 수 (백만 단위), 텍스트 변환은 0
+		int64_t imageBytes = 0;			// 이미지 스트림 크기 합계
+		bool scanned = false;			// 구조 분석 실패 시 파일 크기로 추정한 값이다.
+		// 실행 결과
+		int order = -1;					// 실행 순서
+		double predictedSeconds = 0.0;	// 실행 직전 모델의 예측
+		double startedSeconds = 0.0;	// 배치 시작부터 실행 시작까지
+		double actualSeconds = 0.0;
+		double finishedSeconds = 0.0;	// 배치 시작부터 완료까지
+		bool result = false;
+	}; // struct BatchJob
+
+	struct BatchOptions
+	{
+		SchedulePolicy policy = SchedulePolicy::ShortestFirst; // 큐 안에서의 순서
+		int workers = 1;	// 동시에 실행할 변환 수
+		int dpi = 96;		// 0 이면 텍스트 변환 (렌더링 비용 없음)
+	}; // struct BatchOptions
+
+	// 작업 시간 = 문서 고정 비용 + 페이지 수 + 렌더링 픽셀 + 이미지 바이트 + 나머지 바이트 의 선형 모델
+	// 작업이 끝날 때마다 측정한 시간으로 가중치를 보정한다. (NLMS)
+	class CostModel
+	{
+	public:
+		explicit CostModel(bool text);
+
+	public:
+		double Predict(const BatchJob& job) const;
+		void Update(const BatchJob& job, double actualSeconds);
+
+	private:
+		static const int FEATURE_COUNT = 5;
+		void features(const BatchJob& job, double x[FEATURE_COUNT]) const;
+
+	private:
+		double m_Weights[FEATURE_COUNT];
+	}; // class CostModel
+
+	// 변환 함수는 작업자 스레드에서 동시에 호출된다.
+	using BatchConvert = std::function<bool(const BatchJob& job)>;
+
+	class BatchScheduler
+	{
+	public:
+		explicit BatchScheduler(const BatchOptions& options);
+
+	public:
+		void AddQueue(const BatchQueue& queue); // 같은 이름이 있으면 설정을 바꾼다.
+		bool Add(const std::wstring& sourceFile, const std::string& queue = std::string()); // 구조 분석으로 비용 신호를 모은다. 분석에 실패해도 작업은 추가된다.
+		bool Run(const BatchConvert& convert);
+		bool WriteReport(const std::string& reportFile) const; // CSV
+
+		const std::vector<BatchJob>& Jobs() const { return m_Jobs; }
+		double Makespan() const { return m_Makespan; }
+		std::vector<QueueStats> Statistics() const;
+
+	private:
+		int queueIndex(const std::string& name); // 없으면 기본 설정으로 만든다.
+		int takeNext(); // m_Mutex 를 잠근 상태에서 호출한다.
+		size_t pickInQueue(const std::vector<int>& pending, double* cost) const;
+
+	private:
+		BatchOptions m_Options;
+		CostModel m_Model;
+		std::vector<BatchJob> m_Jobs;
+		std::vector<BatchQueue> m_Queues;
+		std::vector<std::vector<int>> m_Pending; // 큐별 대기 작업
+		std::vector<double> m_Deficit; // 큐별 남은 실행 몫 (후보 작업 중 가장 긴 예상 시간 단위)
+		size_t m_Current; // 라운드 로빈 위치
+		bool m_QuantumAdded; // m_Current 큐에 이번 차례의 몫을 더했다.
+		mutable std::mutex m_Mutex;
+		double m_Makespan;
+	}; // class BatchScheduler
+
+}} // PDF::Converter
@@ -0,0 +1,1028 @@
+﻿// PDFBoxBridge.cpp
+#include "PDFBoxBridge.h"
+#include "PDFJNIBinding.h"
+#include <algorithm> // std::max, std::min, std::find
+#include "pdf_assert.h"
+
+static const char* const JAVA_FILE_CLASS_NAME = "java/io/File";
+static const char* const PDFBOX_DOCUMENT_CLASS_NAME = "org/apache/pdfbox/pdmodel/PDDocument";
+static const char* const PDFBOX_RENDERER_CLASS_NAME = "org/apache/pdfbox/rendering/PDFRenderer";
+static const char* const PDFBOX_IMAGETYPE_CLASS_NAME = "org/apache/pdfbox/rendering/ImageType";
+static const char* const JAVA_IMAGEIO_CLASS_NAME = "javax/imageio/ImageIO";
+static const char* const PDFBOX_PAGE_CLASS_NAME = "org/apache/pdfbox/pdmodel/PDPage";
+static const char* const PDFBOX_RECTANGLE_CLASS_NAME = "org/apache/pdfbox/pdmodel/common/PDRectangle";
+static const char* const JAVA_BUFFEREDIMAGE_CLASS_NAME = "java/awt/image/BufferedImage";
+static const char* const JAVA_RASTER_CLASS_NAME = "java/awt/image/Raster";
+static const char* const JAVA_DATABUFFERBYTE_CLASS_NAME = "java/awt/image/DataBufferByte";
+static const char* const JAVA_DATABUFFERINT_CLASS_NAME = "java/awt/image/DataBufferInt";
+static const char* const JAVA_GRAPHICS2D_CLASS_NAME = "java/awt/Graphics2D";
+static const char* const JAVA_COLOR_CLASS_NAME = "java/awt/Color";
+static const char* const JAVA_RENDERINGHINTS_CLASS_NAME = "java/awt/RenderingHints";
+static const char* const PDFBOX_TEXTSTRIPPER_CLASS_NAME = "org/apache/pdfbox/text/PDFTextStripper";
+static const char* const PDFBOX_TEXTPOSITION_CLASS_NAME = "org/apache/pdfbox/text/TextPosition";
+static const char* const PDFBOX_FONT_CLASS_NAME = "org/apache/pdfbox/pdmodel/font/PDFont";
+static const char* const JAVA_LIST_CLASS_NAME = "java/util/List";
+static const char* const PDFBOX_DOCUMENTINFO_CLASS_NAME = "org/apache/pdfbox/pdmodel/PDDocumentInformation";
+static const char* const PDFBOX_MEMORYUSAGESETTING_CLASS_NAME = "org/apache/pdfbox/io/MemoryUsageSetting";
+static const char* const PDFBOX_FONTMAPPERS_CLASS_NAME = "org/apache/pdfbox/pdmodel/font/FontMappers";
+static const char* const PDFBOX_FONTMAPPER_CLASS_NAME = "org/apache/pdfbox/pdmodel/font/FontMapper";
+
+// PDDocumentInformation 의 get<Key>() 로 읽는 항목
+static const char* const DOCUMENT_INFO_KEYS[] = { "Title", "Author", "Subject", "Keywords", "Creator", "Producer" };
+
+// TextGlyph 의 x, baseline, width, height, fontSize, spaceWidth 를 읽는 TextPosition 메소드 (()F)
+static const char* const TEXTPOSITION_METRICS[] = { "getXDirAdj", "getYDirAdj", "getWidthDirAdj", "getHeightDir", "getFontSizeInPt", "getWidthOfSpace" };
+
+// java.awt.image.BufferedImage 타입 상수
+static const jint BUFFEREDIMAGE_TYPE_INT_RGB = 1;
+static const jint BUFFEREDIMAGE_TYPE_INT_ARGB = 2;
+static const jint BUFFEREDIMAGE_TYPE_BYTE_GRAY = 10;
+static const jint BUFFEREDIMAGE_TYPE_BYTE_BINARY = 12;
+
+namespace {
+
+	// 자바 예외가 발생했으면 출력하고 지운다.
+	bool checkException(JNIEnv* env)
+	{
+		if (env->ExceptionCheck()) {
+			env->ExceptionDescribe();
+			env->ExceptionClear();
+			return true;
+		}
+		return false;
+	}
+
+	jclass findGlobalClass(JNIEnv* env, const char* className)
+	{
+		jclass localClass = env->FindClass(className);
+		if (checkException(env) || !localClass) {
+			return nullptr;
+		}
+		jclass globalClass = static_cast<jclass>(env->NewGlobalRef(localClass));
+		env->DeleteLocalRef(localClass);
+		return globalClass;
+	}
+
+	jobject getStaticObjectField(JNIEnv* env, jclass targetClass, const char* name, const char* signature)
+	{
+		jfieldID fieldID = env->GetStaticFieldID(targetClass, name, signature);
+		if (checkException(env) || !fieldID) {
+			return nullptr;
+		}
+		jobject localObject = env->GetStaticObjectField(targetClass, fieldID);
+		if (checkException(env) || !localObject) {
+			return nullptr;
+		}
+		jobject globalObject = env->NewGlobalRef(localObject);
+		env->DeleteLocalRef(localObject);
+		return globalObject;
+	}
+
+	// 속도 우선 RenderingHints : 안티앨리어싱 끄기, 최근접 보간
+	jobject newDraftRenderingHints(JNIEnv* env)
+	{
+		jclass hintsClass = env->FindClass(JAVA_RENDERINGHINTS_CLASS_NAME);
+		if (checkException(env) || !hintsClass) {
+			return nullptr;
+		}
+		const char* const hints[][2] = {
+			{ "KEY_ANTIALIASING", "VALUE_ANTIALIAS_OFF" },
+			{ "KEY_TEXT_ANTIALIASING", "VALUE_TEXT_ANTIALIAS_OFF" },
+			{ "KEY_RENDERING", "VALUE_RENDER_SPEED" },
+			{ "KEY_INTERPOLATION", "VALUE_INTERPOLATION_NEAREST_NEIGHBOR" },
+		};
+		jmethodID ctorID = env->GetMethodID(hintsClass, "<init>", "(Ljava/awt/RenderingHints$Key;Ljava/lang/Object;)V");
+		jmethodID putMethodID = env->GetMethodID(hintsClass, "put", "(Ljava/lang/Object;Ljava/lang/Object;)Ljava/lang/Object;");
+		jobject renderingHints = nullptr;
+		for (const auto& hint : hints) {
+			if (checkException(env) || !ctorID || !putMethodID) {
+				break;
+			}
+			jobject key = getStaticObjectField(env, hintsClass, hint[0], "Ljava/awt/RenderingHints$Key;");
+			jobject value = getStaticObjectField(env, hintsClass, hint[1], "Ljava/lang/Object;");
+			if (key && value) {
+				if (!renderingHints) {
+					renderingHints = env->NewObject(hintsClass, ctorID, key, value);
+				} else {
+					jobject previous = env->CallObjectMethod(renderingHints, putMethodID, key, value);
+					if (previous) {
+						env->DeleteLocalRef(previous);
+					}
+				}
+			}
+			if (key) {
+				env->DeleteGlobalRef(key);
+			}
+			if (value) {
+				env->DeleteGlobalRef(value);
+			}
+		}
+		env->DeleteLocalRef(hintsClass);
+		if (checkException(env) || !renderingHints) {
+			return nullptr;
+		}
+		jobject globalHints = env->NewGlobalRef(renderingHints);
+		env->DeleteLocalRef(renderingHints);
+		return globalHints;
+	}
+
+	// 자바 문자열(UTF-16)을 UTF-8 로 덧붙인다. 짝이 없는 서로게이트는 U+FFFD 로 바꾼다.
+	void appendUTF8(const jchar* chars, jsize length, std::string& text)
+	{
+		for (jsize i = 0; i < length; i++) {
+			uint32_t code = chars[i];
+			if (code >= 0xD800 && code <= 0xDBFF && i + 1 < length && chars[i + 1] >= 0xDC00 && chars[i + 1] <= 0xDFFF) {
+				code = 0x10000 + ((code - 0xD800) << 10) + (chars[++i] - 0xDC00);
+			} else if (code >= 0xD800 && code <= 0xDFFF) {
+				code = 0xFFFD;
+			}
+			if (code < 0x80) {
+				text += static_cast<char>(code);
+			} else if (code < 0x800) {
+				text += static_cast<char>(0xC0 | (code >> 6));
+				text += static_cast<char>(0x80 | (code & 0x3F));
+			} else if (code < 0x10000) {
+				text += static_cast<char>(0xE0 | (code >> 12));
+				text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (code & 0x3F));
+			} else {
+				text += static_cast<char>(0xF0 | (code >> 18));
+				text += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+				text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+				text += static_cast<char>(0x80 | (code & 0x3F));
+			}
+		}
+	}
+
+	bool appendStringUTF8(JNIEnv* env, jstring string, std::string& text)
+	{
+		const jsize length = env->GetStringLength(string);
+		const jchar* chars = env->GetStringChars(string, nullptr);
+		if (!chars) {
+			return false;
+		}
+		appendUTF8(chars, length, text);
+		env->ReleaseStringChars(string, chars);
+		return true;
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	// 선택 기능의 메소드는 PDFBox 버전마다 있거나 없으므로 시그니처를 타입에서 만들어 틀리지 않게 한다.
+	using JFile = JObject<JNIChars<'j', 'a', 'v', 'a', '/', 'i', 'o', '/', 'F', 'i', 'l', 'e'>>*;
+	using JList = JObject<JNIChars<'j', 'a', 'v', 'a', '/', 'u', 't', 'i', 'l', '/', 'L', 'i', 's', 't'>>*;
+	using JDocument = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'P', 'D', 'D', 'o', 'c', 'u', 'm', 'e', 'n', 't'>>*;
+	using JDocumentInformation = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'P', 'D', 'D', 'o', 'c', 'u', 'm', 'e', 'n', 't', 'I', 'n', 'f', 'o', 'r', 'm', 'a', 't', 'i', 'o', 'n'>>*;
+	using JMemoryUsageSetting = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'i', 'o', '/', 'M', 'e', 'm', 'o', 'r', 'y', 'U', 's', 'a', 'g', 'e', 'S', 'e', 't', 't', 'i', 'n', 'g'>>*;
+	using JFont = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'f', 'o', 'n', 't', '/', 'P', 'D', 'F', 'o', 'n', 't'>>*;
+	using JFontDescriptor = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'f', 'o', 'n', 't', '/', 'P', 'D', 'F', 'o', 'n', 't', 'D', 'e', 's', 'c', 'r', 'i', 'p', 't', 'o', 'r'>>*;
+	using JFontMapper = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'f', 'o', 'n', 't', '/', 'F', 'o', 'n', 't', 'M', 'a', 'p', 'p', 'e', 'r'>>*;
+	using JFontMapping = JObject<JNIChars<'o', 'r', 'g', '/', 'a', 'p', 'a', 'c', 'h', 'e', '/', 'p', 'd', 'f', 'b', 'o', 'x', '/', 'p', 'd', 'm', 'o', 'd', 'e', 'l', '/', 'f', 'o', 'n', 't', '/', 'F', 'o', 'n', 't', 'M', 'a', 'p', 'p', 'i', 'n', 'g'>>*;
+
+	struct PDFBoxBridge::OptionalMethods
+	{
+		// MemoryUsageSetting (PDFBox 2.0 이상)
+		Method<Static, JMemoryUsageSetting(jlong)> setupMainMemoryOnly;
+		Method<Static, JMemoryUsageSetting(jlong)> setupMixed;
+		Method<Static, JMemoryUsageSetting()> setupTempFileOnly;
+		Method<Instance, JMemoryUsageSetting(JFile)> setTempDir;
+		Method<Static, JDocument(JFile, JMemoryUsageSetting)> loadWithMemory; // 없으면 Default 정책만 가능하다.
+		// 문서 정보
+		Method<Instance, JDocumentInformation()> getDocumentInformation; // 조회 메소드가 하나라도 없으면 Null
+		Method<Instance, jstring()> infoGetters[6]; // DOCUMENT_INFO_KEYS 순서
+		// 글자 위치
+		Method<Instance, JList()> getCharactersByArticle; // protected 메소드, 나머지가 하나라도 없으면 Null
+		Method<Instance, jint()> listSize;
+		Method<Instance, jobject(jint)> listGet;
+		Method<Instance, jfloat()> glyphMetrics[6]; // TEXTPOSITION_METRICS 순서
+		Method<Instance, jstring()> getUnicode;
+		Method<Instance, JFont()> getFont;
+		Method<Instance, jstring()> fontGetName;
+	}; // struct PDFBoxBridge::OptionalMethods
+
+	PDFBoxBridge::PDFBoxBridge()
+	: m_FileClass(nullptr)
+	, m_DocumentClass(nullptr)
+	, m_RendererClass(nullptr)
+	, m_ImageIOClass(nullptr)
+	, m_BufferedImageClass(nullptr)
+	, m_DataBufferByteClass(nullptr)
+	, m_DataBufferIntClass(nullptr)
+	, m_TextStripperClass(nullptr)
+	, m_MemoryUsageSettingClass(nullptr)
+	, m_FileCtorID(nullptr)
+	, m_LoadMethodID(nullptr)
+	, m_CloseMethodID(nullptr)
+	, m_GetNumberOfPagesMethodID(nullptr)
+	, m_RendererCtorID(nullptr)
+	, m_RenderImageWithDPIMethodID(nullptr)
+	, m_WriteImageMethodID(nullptr)
+	, m_GetPageMethodID(nullptr)
+	, m_GetCropBoxMethodID(nullptr)
+	, m_GetRotationMethodID(nullptr)
+	, m_RectGetWidthMethodID(nullptr)
+	, m_RectGetHeightMethodID(nullptr)
+	, m_RenderPageToGraphicsMethodID(nullptr)
+	, m_BufferedImageCtorID(nullptr)
+	, m_CreateGraphicsMethodID(nullptr)
+	, m_GetRasterMethodID(nullptr)
+	, m_GetSubimageMethodID(nullptr)
+	, m_GetWidthMethodID(nullptr)
+	, m_GetHeightMethodID(nullptr)
+	, m_GetDataBufferMethodID(nullptr)
+	, m_DataBufferByteGetDataMethodID(nullptr)
+	, m_DataBufferIntGetDataMethodID(nullptr)
+	, m_SetBackgroundMethodID(nullptr)
+	, m_ClearRectMethodID(nullptr)
+	, m_TranslateMethodID(nullptr)
+	, m_DisposeMethodID(nullptr)
+	, m_WhiteColor(nullptr)
+	, m_TransparentColor(nullptr)
+	, m_SetSubsamplingAllowedMethodID(nullptr)
+	, m_SetRenderingHintsMethodID(nullptr)
+	, m_DraftRenderingHints(nullptr)
+	, m_ImageTypes()
+	, m_PNGFormatName(nullptr)
+	, m_TextStripperCtorID(nullptr)
+	, m_SetStartPageMethodID(nullptr)
+	, m_SetEndPageMethodID(nullptr)
+	, m_GetTextMethodID(nullptr)
+	, m_Optional(new OptionalMethods())
+	{
+	}
+
+	PDFBoxBridge::~PDFBoxBridge()
+	{
+		// 전역 참조는 JavaVM 이 살아 있을 때 Fini() 로 해제해야 한다.
+		_ASSERTE(!m_FileClass && "Fini() is not called");
+	}
+
+	bool PDFBoxBridge::Init(JNIEnv* env)
+	{
+		_ASSERTE(env && "env is not Null");
+		if (!env) {
+			return false;
+		}
+
+		m_FileClass = findGlobalClass(env, JAVA_FILE_CLASS_NAME);
+		m_DocumentClass = findGlobalClass(env, PDFBOX_DOCUMENT_CLASS_NAME);
+		m_RendererClass = findGlobalClass(env, PDFBOX_RENDERER_CLASS_NAME);
+		m_ImageIOClass = findGlobalClass(env, JAVA_IMAGEIO_CLASS_NAME);
+		m_BufferedImageClass = findGlobalClass(env, JAVA_BUFFEREDIMAGE_CLASS_NAME);
+		m_DataBufferByteClass = findGlobalClass(env, JAVA_DATABUFFERBYTE_CLASS_NAME);
+		m_DataBufferIntClass = findGlobalClass(env, JAVA_DATABUFFERINT_CLASS_NAME);
+		m_TextStripperClass = findGlobalClass(env, PDFBOX_TEXTSTRIPPER_CLASS_NAME);
+		if (!m_FileClass || !m_DocumentClass || !m_RendererClass || !m_ImageIOClass
+			|| !m_BufferedImageClass || !m_DataBufferByteClass || !m_DataBufferIntClass || !m_TextStripperClass) {
+			Fini(env);
+			return false;
+		}
+
+		m_FileCtorID = env->GetMethodID(m_FileClass, "<init>", "(Ljava/lang/String;)V");
+		m_LoadMethodID = env->GetStaticMethodID(
+			m_DocumentClass,
+			"load",
+			"(Ljava/io/File;)Lorg/apache/pdfbox/pdmodel/PDDocument;"
+		);
+		m_CloseMethodID = env->GetMethodID(m_DocumentClass, "close", "()V");
+		m_GetNumberOfPagesMethodID = env->GetMethodID(m_DocumentClass, "getNumberOfPages", "()I");
+		m_RendererCtorID = env->GetMethodID(m_RendererClass, "<init>", "(Lorg/apache/pdfbox/pdmodel/PDDocument;)V");
+		m_RenderImageWithDPIMethodID = env->GetMethodID(
+			m_RendererClass,
+			"renderImageWithDPI",
+			"(IFLorg/apache/pdfbox/rendering/ImageType;)Ljava/awt/image/BufferedImage;"
+		);
+		m_WriteImageMethodID = env->GetStaticMethodID(
+			m_ImageIOClass,
+			"write",
+			"(Ljava/awt/image/RenderedImage;Ljava/lang/String;Ljava/io/File;)Z"
+		);
+		if (checkException(env) || !m_FileCtorID || !m_LoadMethodID || !m_CloseMethodID || !m_GetNumberOfPagesMethodID
+			|| !m_RendererCtorID || !m_RenderImageWithDPIMethodID || !m_WriteImageMethodID) {
+			Fini(env);
+			return false;
+		}
+
+		// 타일 렌더링, 픽셀 복사
+		m_GetPageMethodID = env->GetMethodID(m_DocumentClass, "getPage", "(I)Lorg/apache/pdfbox/pdmodel/PDPage;");
+		m_RenderPageToGraphicsMethodID = env->GetMethodID(m_RendererClass, "renderPageToGraphics", "(ILjava/awt/Graphics2D;F)V");
+		m_BufferedImageCtorID = env->GetMethodID(m_BufferedImageClass, "<init>", "(III)V");
+		m_CreateGraphicsMethodID = env->GetMethodID(m_BufferedImageClass, "createGraphics", "()Ljava/awt/Graphics2D;");
+		m_GetRasterMethodID = env->GetMethodID(m_BufferedImageClass, "getRaster", "()Ljava/awt/image/WritableRaster;");
+		m_GetSubimageMethodID = env->GetMethodID(m_BufferedImageClass, "getSubimage", "(IIII)Ljava/awt/image/BufferedImage;");
+		m_GetWidthMethodID = env->GetMethodID(m_BufferedImageClass, "getWidth", "()I");
+		m_GetHeightMethodID = env->GetMethodID(m_BufferedImageClass, "getHeight", "()I");
+		m_DataBufferByteGetDataMethodID = env->GetMethodID(m_DataBufferByteClass, "getData", "()[B");
+		m_DataBufferIntGetDataMethodID = env->GetMethodID(m_DataBufferIntClass, "getData", "()[I");
+		if (checkException(env)) {
+			Fini(env);
+			return false;
+		}
+
+		jclass pageClass = env->FindClass(PDFBOX_PAGE_CLASS_NAME);
+		jclass rectangleClass = env->FindClass(PDFBOX_RECTANGLE_CLASS_NAME);
+		jclass rasterClass = env->FindClass(JAVA_RASTER_CLASS_NAME);
+		jclass graphicsClass = env->FindClass(JAVA_GRAPHICS2D_CLASS_NAME);
+		jclass colorClass = env->FindClass(JAVA_COLOR_CLASS_NAME);
+		if (!checkException(env) && pageClass && rectangleClass && rasterClass && graphicsClass && colorClass) {
+			m_GetCropBoxMethodID = env->GetMethodID(pageClass, "getCropBox", "()Lorg/apache/pdfbox/pdmodel/common/PDRectangle;");
+			m_GetRotationMethodID = env->GetMethodID(pageClass, "getRotation", "()I");
+			m_RectGetWidthMethodID = env->GetMethodID(rectangleClass, "getWidth", "()F");
+			m_RectGetHeightMethodID = env->GetMethodID(rectangleClass, "getHeight", "()F");
+			m_GetDataBufferMethodID = env->GetMethodID(rasterClass, "getDataBuffer", "()Ljava/awt/image/DataBuffer;");
+			m_SetBackgroundMethodID = env->GetMethodID(graphicsClass, "setBackground", "(Ljava/awt/Color;)V");
+			m_ClearRectMethodID = env->GetMethodID(graphicsClass, "clearRect", "(IIII)V");
+			m_TranslateMethodID = env->GetMethodID(graphicsClass, "translate", "(II)V");
+			m_DisposeMethodID = env->GetMethodID(graphicsClass, "dispose", "()V");
+			checkException(env);
+			m_WhiteColor = getStaticObjectField(env, colorClass, "WHITE", "Ljava/awt/Color;");
+			jmethodID colorCtorID = env->GetMethodID(colorClass, "<init>", "(IIII)V");
+			jobject transparentColor = colorCtorID ? env->NewObject(colorClass, colorCtorID, 0, 0, 0, 0) : nullptr;
+			if (!checkException(env) && transparentColor) {
+				m_TransparentColor = env->NewGlobalRef(transparentColor);
+			}
+			if (transparentColor) {
+				env->DeleteLocalRef(transparentColor);
+			}
+		}
+		jobject localClasses[] = { pageClass, rectangleClass, rasterClass, graphicsClass, colorClass };
+		for (jobject localClass : localClasses) {
+			if (localClass) {
+				env->DeleteLocalRef(localClass);
+			}
+		}
+		if (!m_GetPageMethodID || !m_RenderPageToGraphicsMethodID || !m_BufferedImageCtorID || !m_CreateGraphicsMethodID
+			|| !m_GetRasterMethodID || !m_GetSubimageMethodID || !m_GetWidthMethodID || !m_GetHeightMethodID || !m_DataBufferByteGetDataMethodID
+			|| !m_DataBufferIntGetDataMethodID || !m_GetCropBoxMethodID || !m_GetRotationMethodID || !m_RectGetWidthMethodID
+			|| !m_RectGetHeightMethodID || !m_GetDataBufferMethodID || !m_SetBackgroundMethodID || !m_ClearRectMethodID
+			|| !m_TranslateMethodID || !m_DisposeMethodID || !m_WhiteColor || !m_TransparentColor) {
+			Fini(env);
+			return false;
+		}
+
+		// 페이지 단위 텍스트 추출
+		m_TextStripperCtorID = env->GetMethodID(m_TextStripperClass, "<init>", "()V");
+		m_SetStartPageMethodID = env->GetMethodID(m_TextStripperClass, "setStartPage", "(I)V");
+		m_SetEndPageMethodID = env->GetMethodID(m_TextStripperClass, "setEndPage", "(I)V");
+		m_GetTextMethodID = env->GetMethodID(m_TextStripperClass, "getText", "(Lorg/apache/pdfbox/pdmodel/PDDocument;)Ljava/lang/String;");
+		if (checkException(env) || !m_TextStripperCtorID || !m_SetStartPageMethodID || !m_SetEndPageMethodID || !m_GetTextMethodID) {
+			Fini(env);
+			return false;
+		}
+
+		// PixelFormat 순서대로 ImageType 상수를 보관한다. Default 는 RGB 로 렌더링한다.
+		jclass imageTypeClass = env->FindClass(PDFBOX_IMAGETYPE_CLASS_NAME);
+		if (checkException(env) || !imageTypeClass) {
+			Fini(env);
+			return false;
+		}
+		const char* const imageTypeSignature = "Lorg/apache/pdfbox/rendering/ImageType;";
+		m_ImageTypes[static_cast<int>(PixelFormat::Default)] = getStaticObjectField(env, imageTypeClass, "RGB", imageTypeSignature);
+		m_ImageTypes[static_cast<int>(PixelFormat::Gray)] = getStaticObjectField(env, imageTypeClass, "GRAY", imageTypeSignature);
+		m_ImageTypes[static_cast<int>(PixelFormat::Mono)] = getStaticObjectField(env, imageTypeClass, "BINARY", imageTypeSignature);
+		m_ImageTypes[static_cast<int>(PixelFormat::RGB)] = getStaticObjectField(env, imageTypeClass, "RGB", imageTypeSignature);
+		m_ImageTypes[static_cast<int>(PixelFormat::RGBA)] = getStaticObjectField(env, imageTypeClass, "ARGB", imageTypeSignature);
+		env->DeleteLocalRef(imageTypeClass);
+		for (jobject imageType : m_ImageTypes) {
+			if (!imageType) {
+				Fini(env);
+				return false;
+			}
+		}
+
+		// 미리보기용 설정은 선택 기능이므로 실패해도 Init() 은 성공한다.
+		m_SetSubsamplingAllowedMethodID = env->GetMethodID(m_RendererClass, "setSubsamplingAllowed", "(Z)V");
+		env->ExceptionClear();
+		m_SetRenderingHintsMethodID = env->GetMethodID(m_RendererClass, "setRenderingHints", "(Ljava/awt/RenderingHints;)V");
+		env->ExceptionClear();
+		if (m_SetRenderingHintsMethodID) {
+			m_DraftRenderingHints = newDraftRenderingHints(env);
+		}
+
+		// 문서 정보는 선택 기능이다. 하나라도 없으면 모두 사용하지 않는다.
+		jclass infoClass = env->FindClass(PDFBOX_DOCUMENTINFO_CLASS_NAME);
+		env->ExceptionClear();
+		bool infoMethods = infoClass && m_Optional->getDocumentInformation.Resolve(env, m_DocumentClass, "getDocumentInformation", true);
+		for (size_t i = 0; infoMethods && i < sizeof(DOCUMENT_INFO_KEYS) / sizeof(DOCUMENT_INFO_KEYS[0]); i++) {
+			infoMethods = m_Optional->infoGetters[i].Resolve(env, infoClass, (std::string("get") + DOCUMENT_INFO_KEYS[i]).c_str(), true);
+		}
+		if (!infoMethods) {
+			m_Optional->getDocumentInformation.Reset();
+		}
+		if (infoClass) {
+			env->DeleteLocalRef(infoClass);
+		}
+
+		// 글자 위치는 선택 기능이다. JNI 는 접근 제한자를 확인하지 않으므로 protected 메소드도 호출할 수 있다.
+		jclass listClass = env->FindClass(JAVA_LIST_CLASS_NAME);
+		env->ExceptionClear();
+		jclass positionClass = env->FindClass(PDFBOX_TEXTPOSITION_CLASS_NAME);
+		env->ExceptionClear();
+		jclass fontClass = env->FindClass(PDFBOX_FONT_CLASS_NAME);
+		env->ExceptionClear();
+		bool glyphMethods = listClass && positionClass && fontClass
+			&& m_Optional->getCharactersByArticle.Resolve(env, m_TextStripperClass, "getCharactersByArticle", true)
+			&& m_Optional->listSize.Resolve(env, listClass, "size", true)
+			&& m_Optional->listGet.Resolve(env, listClass, "get", true)
+			&& m_Optional->getUnicode.Resolve(env, positionClass, "getUnicode", true)
+			&& m_Optional->getFont.Resolve(env, positionClass, "getFont", true)
+			&& m_Optional->fontGetName.Resolve(env, fontClass, "getName", true);
+		for (size_t i = 0; glyphMethods && i < sizeof(TEXTPOSITION_METRICS) / sizeof(TEXTPOSITION_METRICS[0]); i++) {
+			glyphMethods = m_Optional->glyphMetrics[i].Resolve(env, positionClass, TEXTPOSITION_METRICS[i], true);
+		}
+		if (!glyphMethods) {
+			m_Optional->getCharactersByArticle.Reset();
+		}
+		jobject glyphClasses[] = { listClass, positionClass, fontClass };
+		for (jobject glyphClass : glyphClasses) {
+			if (glyphClass) {
+				env->DeleteLocalRef(glyphClass);
+			}
+		}
+
+		// 문서 스트림 메모리 설정도 선택 기능이다. (PDFBox 2.0 이상)
+		jclass memoryClass = env->FindClass(PDFBOX_MEMORYUSAGESETTING_CLASS_NAME);
+		env->ExceptionClear();
+		if (memoryClass) {
+			if (m_Optional->setupMainMemoryOnly.Resolve(env, memoryClass, "setupMainMemoryOnly", true)
+				&& m_Optional->setupMixed.Resolve(env, memoryClass, "setupMixed", true)
+				&& m_Optional->setupTempFileOnly.Resolve(env, memoryClass, "setupTempFileOnly", true)
+				&& m_Optional->setTempDir.Resolve(env, memoryClass, "setTempDir", true)
+				&& m_Optional->loadWithMemory.Resolve(env, m_DocumentClass, "load", true)) {
+				m_MemoryUsageSettingClass = static_cast<jclass>(env->NewGlobalRef(memoryClass));
+			}
+			if (!m_MemoryUsageSettingClass) {
+				m_Optional->loadWithMemory.Reset();
+			}
+			env->DeleteLocalRef(memoryClass);
+		}
+
+		jstring formatName = env->NewStringUTF("png");
+		m_PNGFormatName = static_cast<jstring>(env->NewGlobalRef(formatName));
+		env->DeleteLocalRef(formatName);
+
+		return true;
+	}
+
+	void PDFBoxBridge::Fini(JNIEnv* env)
+	{
+		if (!env) {
+			return;
+		}
+
+		jobject globalRefs[] = {
+			m_FileClass, m_DocumentClass, m_RendererClass, m_ImageIOClass, m_BufferedImageClass,
+			m_DataBufferByteClass, m_DataBufferIntClass, m_TextStripperClass, m_MemoryUsageSettingClass, m_WhiteColor, m_TransparentColor, m_DraftRenderingHints, m_PNGFormatName
+		};
+		for (jobject globalRef : globalRefs) {
+			if (globalRef) {
+				env->DeleteGlobalRef(globalRef);
+			}
+		}
+		for (jobject& imageType : m_ImageTypes) {
+			if (imageType) {
+				env->DeleteGlobalRef(imageType);
+				imageType = nullptr;
+			}
+		}
+		m_FileClass = nullptr;
+		m_DocumentClass = nullptr;
+		m_RendererClass = nullptr;
+		m_ImageIOClass = nullptr;
+		m_BufferedImageClass = nullptr;
+		m_DataBufferByteClass = nullptr;
+		m_DataBufferIntClass = nullptr;
+		m_TextStripperClass = nullptr;
+		m_MemoryUsageSettingClass = nullptr;
+		*m_Optional = OptionalMethods(); // 메소드 ID 는 클래스와 함께 무효가 된다.
+		m_WhiteColor = nullptr;
+		m_TransparentColor = nullptr;
+		m_DraftRenderingHints = nullptr;
+		m_SetSubsamplingAllowedMethodID = nullptr;
+		m_SetRenderingHintsMethodID = nullptr;
+		m_PNGFormatName = nullptr;
+	}
+
+	bool PDFBoxBridge::SupportsMemoryPolicy() const
+	{
+		return static_cast<bool>(m_Optional->loadWithMemory);
+	}
+
+	bool PDFBoxBridge::SupportsGlyphs() const
+	{
+		return static_cast<bool>(m_Optional->getCharactersByArticle);
+	}
+
+	jobject PDFBoxBridge::LoadDocument(JNIEnv* env, const std::string& sourceFile)
+	{
+		jstring jsourceFile = env->NewStringUTF(sourceFile.c_str());
+		jobject file = env->NewObject(m_FileClass, m_FileCtorID, jsourceFile);
+		env->DeleteLocalRef(jsourceFile);
+		if (checkException(env) || !file) {
+			return nullptr;
+		}
+
+		jobject document = env->CallStaticObjectMethod(m_DocumentClass, m_LoadMethodID, file);
+		env->DeleteLocalRef(file);
+		if (checkException(env)) {
+			return nullptr;
+		}
+		return document;
+	}
+
+	jobject PDFBoxBridge::LoadDocument(JNIEnv* env, const std::string& sourceFile, const MemoryOptions& memory, const std::string& scratchDir)
+	{
+		if (memory.policy == MemoryPolicy::Default) {
+			return LoadDocument(env, sourceFile);
+		}
+		_ASSERTE(m_Optional->loadWithMemory && "MemoryUsageSetting is not supported");
+		if (!m_Optional->loadWithMemory) {
+			return nullptr;
+		}
+
+		JMemoryUsageSetting setting = nullptr;
+		switch (memory.policy) {
+		case MemoryPolicy::MainMemory:
+			m_Optional->setupMainMemoryOnly(env, m_MemoryUsageSettingClass, &setting, static_cast<jlong>(memory.mainMemoryBytes > 0 ? memory.mainMemoryBytes : -1));
+			break;
+		case MemoryPolicy::Mixed:
+			m_Optional->setupMixed(env, m_MemoryUsageSettingClass, &setting, static_cast<jlong>(std::max<int64_t>(memory.mainMemoryBytes, 0)));
+			break;
+		default:
+			m_Optional->setupTempFileOnly(env, m_MemoryUsageSettingClass, &setting);
+			break;
+		}
+		if (!setting) {
+			return nullptr;
+		}
+		if (!scratchDir.empty()) {
+			jstring jscratchDir = env->NewStringUTF(scratchDir.c_str());
+			jobject directory = env->NewObject(m_FileClass, m_FileCtorID, jscratchDir);
+			env->DeleteLocalRef(jscratchDir);
+			JMemoryUsageSetting applied = nullptr; // 같은 객체를 반환한다.
+			if (!checkException(env) && directory) {
+				m_Optional->setTempDir(env, setting, &applied, static_cast<JFile>(directory));
+			}
+			if (applied) {
+				env->DeleteLocalRef(applied);
+			}
+			if (directory) {
+				env->DeleteLocalRef(directory);
+			}
+			if (!applied) {
+				env->DeleteLocalRef(setting);
+				return nullptr;
+			}
+		}
+
+		jstring jsourceFile = env->NewStringUTF(sourceFile.c_str());
+		jobject file = env->NewObject(m_FileClass, m_FileCtorID, jsourceFile);
+		env->DeleteLocalRef(jsourceFile);
+		JDocument document = nullptr;
+		if (!checkException(env) && file) {
+			m_Optional->loadWithMemory(env, m_DocumentClass, &document, static_cast<JFile>(file), setting);
+		}
+		if (file) {
+			env->DeleteLocalRef(file);
+		}
+		env->DeleteLocalRef(setting);
+		return document;
+	}
+
+	void PDFBoxBridge::CloseDocument(JNIEnv* env, jobject document)
+	{
+		if (!document) {
+			return;
+		}
+		env->CallVoidMethod(document, m_CloseMethodID);
+		checkException(env);
+		env->DeleteLocalRef(document);
+	}
+
+	int PDFBoxBridge::GetPageCount(JNIEnv* env, jobject document)
+	{
+		jint pageCount = env->CallIntMethod(document, m_GetNumberOfPagesMethodID);
+		if (checkException(env)) {
+			return -1;
+		}
+		return pageCount;
+	}
+
+	jobject PDFBoxBridge::NewRenderer(JNIEnv* env, jobject document)
+	{
+		jobject renderer = env->NewObject(m_RendererClass, m_RendererCtorID, document);
+		if (checkException(env)) {
+			return nullptr;
+		}
+		return renderer;
+	}
+
+	bool PDFBoxBridge::SetDraftMode(JNIEnv* env, jobject renderer)
+	{
+		bool applied = false;
+		if (m_SetSubsamplingAllowedMethodID) {
+			env->CallVoidMethod(renderer, m_SetSubsamplingAllowedMethodID, JNI_TRUE);
+			applied = !checkException(env);
+		}
+		if (m_SetRenderingHintsMethodID && m_DraftRenderingHints) {
+			env->CallVoidMethod(renderer, m_SetRenderingHintsMethodID, m_DraftRenderingHints);
+			applied = !checkException(env) || applied;
+		}
+		return applied;
+	}
+
+	jobject PDFBoxBridge::RenderImage(JNIEnv* env, jobject renderer, int pageIndex, float dpi, PixelFormat format)
+	{
+		// PDFBox 가 대상 포맷(BufferedImage 타입)에 바로 렌더링하므로 컬러 렌더링 후 변환하는 비용이 없다.
+		jobject image = env->CallObjectMethod(
+			renderer,
+			m_RenderImageWithDPIMethodID,
+			static_cast<jint>(pageIndex),
+			static_cast<jfloat>(dpi),
+			m_ImageTypes[static_cast<int>(format)]
+		);
+		if (checkException(env)) {
+			return nullptr;
+		}
+		return image;
+	}
+
+	bool PDFBoxBridge::WriteImage(JNIEnv* env, jobject image, const std::string& targetFile)
+	{
+		jstring jtargetFile = env->NewStringUTF(targetFile.c_str());
+		jobject file = env->NewObject(m_FileClass, m_FileCtorID, jtargetFile);
+		env->DeleteLocalRef(jtargetFile);
+		if (checkException(env) || !file) {
+			return false;
+		}
+
+		jboolean result = env->CallStaticBooleanMethod(m_ImageIOClass, m_WriteImageMethodID, image, m_PNGFormatName, file);
+		env->DeleteLocalRef(file);
+		if (checkException(env)) {
+			return false;
+		}
+		return result == JNI_TRUE;
+	}
+
+	bool PDFBoxBridge::WriteSubimage(JNIEnv* env, jobject image, int x, int y, int width, int height, const std::string& targetFile)
+	{
+		// getSubimage() 는 원본 래스터를 공유하는 이미지를 만든다.
+		jobject subimage = env->CallObjectMethod(image, m_GetSubimageMethodID, static_cast<jint>(x), static_cast<jint>(y), static_cast<jint>(width), static_cast<jint>(height));
+		if (checkException(env) || !subimage) {
+			return false;
+		}
+		bool result = WriteImage(env, subimage, targetFile);
+		env->DeleteLocalRef(subimage);
+		return result;
+	}
+
+	bool PDFBoxBridge::GetPageSize(JNIEnv* env, jobject document, int pageIndex, float* width, float* height)
+	{
+		_ASSERTE(width && height && "width, height is not Null");
+		jobject page = env->CallObjectMethod(document, m_GetPageMethodID, static_cast<jint>(pageIndex));
+		if (checkException(env) || !page) {
+			return false;
+		}
+		jobject cropBox = env->CallObjectMethod(page, m_GetCropBoxMethodID);
+		jint rotation = env->CallIntMethod(page, m_GetRotationMethodID);
+		env->DeleteLocalRef(page);
+		if (checkException(env) || !cropBox) {
+			return false;
+		}
+		*width = env->CallFloatMethod(cropBox, m_RectGetWidthMethodID);
+		*height = env->CallFloatMethod(cropBox, m_RectGetHeightMethodID);
+		env->DeleteLocalRef(cropBox);
+		if (checkException(env)) {
+			return false;
+		}
+
+		// PDFRenderer 와 동일하게 90, 270 도 회전은 가로 세로를 바꾼다.
+		if (rotation == 90 || rotation == 270) {
+			float temp = *width;
+			*width = *height;
+			*height = temp;
+		}
+		return true;
+	}
+
+	jobject PDFBoxBridge::NewImage(JNIEnv* env, int width, int height, PixelFormat format)
+	{
+		jint imageType = BUFFEREDIMAGE_TYPE_INT_RGB;
+		switch (format) {
+		case PixelFormat::Gray:
+			imageType = BUFFEREDIMAGE_TYPE_BYTE_GRAY;
+			break;
+		case PixelFormat::Mono:
+			imageType = BUFFEREDIMAGE_TYPE_BYTE_BINARY;
+			break;
+		case PixelFormat::RGBA:
+			imageType = BUFFEREDIMAGE_TYPE_INT_ARGB;
+			break;
+		default:
+			break;
+		}
+
+		jobject image = env->NewObject(m_BufferedImageClass, m_BufferedImageCtorID, static_cast<jint>(width), static_cast<jint>(height), imageType);
+		if (checkException(env)) {
+			return nullptr;
+		}
+		return image;
+	}
+
+	bool PDFBoxBridge::RenderTile(JNIEnv* env, jobject renderer, jobject tileImage, int pageIndex, float dpi, int x, int y, PixelFormat format)
+	{
+		jobject graphics = env->CallObjectMethod(tileImage, m_CreateGraphicsMethodID);
+		if (checkException(env) || !graphics) {
+			return false;
+		}
+
+		// 재사용하는 타일 이미지를 지우고 페이지 좌표를 타일 위치만큼 이동해서 그린다.
+		// createGraphics() 의 기본 배경은 불투명한 검정이고 renderPageToGraphics 도 그 배경으로 지우므로
+		// RGBA 는 renderImageWithDPI 와 같도록 투명 배경을 지정한다.
+		jint tileWidth = env->CallIntMethod(tileImage, m_GetWidthMethodID);
+		jint tileHeight = env->CallIntMethod(tileImage, m_GetHeightMethodID);
+		env->CallVoidMethod(graphics, m_SetBackgroundMethodID, format == PixelFormat::RGBA ? m_TransparentColor : m_WhiteColor);
+		env->CallVoidMethod(graphics, m_ClearRectMethodID, 0, 0, tileWidth, tileHeight);
+		env->CallVoidMethod(graphics, m_TranslateMethodID, static_cast<jint>(-x), static_cast<jint>(-y));
+		env->CallVoidMethod(renderer, m_RenderPageToGraphicsMethodID, static_cast<jint>(pageIndex), graphics, static_cast<jfloat>(dpi / 72.0f));
+		bool result = !checkException(env);
+
+		env->CallVoidMethod(graphics, m_DisposeMethodID);
+		checkException(env);
+		env->DeleteLocalRef(graphics);
+		return result;
+	}
+
+	bool PDFBoxBridge::CopyPixels(JNIEnv* env, jobject image, PixelFormat format, Bitmap& bitmap)
+	{
+		jint width = env->CallIntMethod(image, m_GetWidthMethodID);
+		jint height = env->CallIntMethod(image, m_GetHeightMethodID);
+		jobject raster = env->CallObjectMethod(image, m_GetRasterMethodID);
+		if (checkException(env) || !raster) {
+			return false;
+		}
+		jobject dataBuffer = env->CallObjectMethod(raster, m_GetDataBufferMethodID);
+		env->DeleteLocalRef(raster);
+		if (checkException(env) || !dataBuffer) {
+			return false;
+		}
+
+		bitmap.width = width;
+		bitmap.height = height;
+		bitmap.format = format;
+
+		// NewImage(), renderImageWithDPI() 로 만든 이미지는 줄 사이 여백이 없는 래스터이다.
+		bool result = false;
+		if (env->IsInstanceOf(dataBuffer, m_DataBufferByteClass)) {
+			jbyteArray data = static_cast<jbyteArray>(env->CallObjectMethod(dataBuffer, m_DataBufferByteGetDataMethodID));
+			if (!checkException(env) && data) {
+				bitmap.stride = (format == PixelFormat::Mono) ? (width + 7) / 8 : width;
+				const jsize length = env->GetArrayLength(data);
+				if (length == static_cast<jsize>(bitmap.stride) * height) {
+					bitmap.pixels.resize(length);
+					env->GetByteArrayRegion(data, 0, length, reinterpret_cast<jbyte*>(bitmap.pixels.data()));
+					result = true;
+				}
+				env->DeleteLocalRef(data);
+			}
+		} else if (env->IsInstanceOf(dataBuffer, m_DataBufferIntClass)) {
+			jintArray data = static_cast<jintArray>(env->CallObjectMethod(dataBuffer, m_DataBufferIntGetDataMethodID));
+			if (!checkException(env) && data) {
+				bitmap.stride = width * 4;
+				const jsize length = env->GetArrayLength(data);
+				if (length == static_cast<jsize>(width) * height) {
+					bitmap.pixels.resize(static_cast<size_t>(length) * 4);
+					env->GetIntArrayRegion(data, 0, length, reinterpret_cast<jint*>(bitmap.pixels.data()));
+					result = true;
+				}
+				env->DeleteLocalRef(data);
+			}
+		}
+		env->DeleteLocalRef(dataBuffer);
+		return result;
+	}
+
+	bool PDFBoxBridge::WriteBitmap(JNIEnv* env, const Bitmap& bitmap, int x, int y, int width, int height, const std::string& targetFile)
+	{
+		_ASSERTE(bitmap.format != PixelFormat::Mono && "Mono bitmap is not supported");
+		_ASSERTE(x >= 0 && y >= 0 && x + width <= bitmap.width && y + height <= bitmap.height && "invalid region");
+		if (bitmap.format == PixelFormat::Mono || x < 0 || y < 0 || width <= 0 || height <= 0
+			|| x + width > bitmap.width || y + height > bitmap.height) {
+			return false;
+		}
+		if (env->PushLocalFrame(8) != JNI_OK) {
+			checkException(env);
+			return false;
+		}
+
+		bool result = false;
+		jobject image = NewImage(env, width, height, bitmap.format);
+		jobject raster = image ? env->CallObjectMethod(image, m_GetRasterMethodID) : nullptr;
+		jobject dataBuffer = (!checkException(env) && raster) ? env->CallObjectMethod(raster, m_GetDataBufferMethodID) : nullptr;
+		if (!checkException(env) && dataBuffer) {
+			if (bitmap.format == PixelFormat::Gray) {
+				jbyteArray data = static_cast<jbyteArray>(env->CallObjectMethod(dataBuffer, m_DataBufferByteGetDataMethodID));
+				if (!checkException(env) && data) {
+					for (int row = 0; row < height; row++) {
+						const unsigned char* in = bitmap.pixels.data() + static_cast<size_t>(y + row) * bitmap.stride + x;
+						env->SetByteArrayRegion(data, row * width, width, reinterpret_cast<const jbyte*>(in));
+					}
+					result = !checkException(env);
+				}
+			} else {
+				jintArray data = static_cast<jintArray>(env->CallObjectMethod(dataBuffer, m_DataBufferIntGetDataMethodID));
+				if (!checkException(env) && data) {
+					for (int row = 0; row < height; row++) {
+						const unsigned char* in = bitmap.pixels.data() + static_cast<size_t>(y + row) * bitmap.stride + x * 4;
+						env->SetIntArrayRegion(data, row * width, width, reinterpret_cast<const jint*>(in));
+					}
+					result = !checkException(env);
+				}
+			}
+		}
+		if (result) {
+			result = WriteImage(env, image, targetFile);
+		}
+
+		env->PopLocalFrame(nullptr);
+		return result;
+	}
+
+	jobject PDFBoxBridge::NewTextStripper(JNIEnv* env)
+	{
+		jobject stripper = env->NewObject(m_TextStripperClass, m_TextStripperCtorID);
+		if (checkException(env)) {
+			return nullptr;
+		}
+		return stripper;
+	}
+
+	bool PDFBoxBridge::LoadSystemFonts(JNIEnv* env)
+	{
+		// 첫 폰트 조회에서 FileSystemFontProvider 가 캐시를 읽거나, 없으면 시스템 폰트를 검색해서 캐시를 쓴다.
+		// 변환 중에는 한번만 호출되므로 클래스와 메소드를 미리 조회하지 않는다.
+		jclass mappersClass = env->FindClass(PDFBOX_FONTMAPPERS_CLASS_NAME);
+		if (checkException(env) || !mappersClass) {
+			return false;
+		}
+		jclass mapperClass = env->FindClass(PDFBOX_FONTMAPPER_CLASS_NAME);
+		if (checkException(env) || !mapperClass) {
+			env->DeleteLocalRef(mappersClass);
+			return false;
+		}
+
+		bool result = false;
+		Method<Static, JFontMapper()> instance;
+		Method<Instance, JFontMapping(jstring, JFontDescriptor)> getFontBoxFont;
+		if (instance.Resolve(env, mappersClass, "instance") && getFontBoxFont.Resolve(env, mapperClass, "getFontBoxFont")) {
+			JFontMapper mapper = nullptr;
+			if (instance(env, mappersClass, &mapper) && mapper) {
+				jstring fontName = env->NewStringUTF("Helvetica");
+				JFontMapping mapping = nullptr;
+				result = fontName && getFontBoxFont(env, mapper, &mapping, fontName, nullptr) && mapping;
+				if (mapping) {
+					env->DeleteLocalRef(mapping);
+				}
+				if (fontName) {
+					env->DeleteLocalRef(fontName);
+				}
+				env->DeleteLocalRef(mapper);
+			}
+		}
+		env->DeleteLocalRef(mapperClass);
+		env->DeleteLocalRef(mappersClass);
+		return result;
+	}
+
+	bool PDFBoxBridge::ExtractText(JNIEnv* env, jobject stripper, jobject document, int pageIndex, std::string& text)
+	{
+		// PDFTextStripper 의 페이지 번호는 1 부터 시작한다.
+		env->CallVoidMethod(stripper, m_SetStartPageMethodID, static_cast<jint>(pageIndex + 1));
+		env->CallVoidMethod(stripper, m_SetEndPageMethodID, static_cast<jint>(pageIndex + 1));
+		if (checkException(env)) {
+			return false;
+		}
+		jstring pageText = static_cast<jstring>(env->CallObjectMethod(stripper, m_GetTextMethodID, document));
+		if (checkException(env) || !pageText) {
+			return false;
+		}
+
+		const bool result = appendStringUTF8(env, pageText, text);
+		env->DeleteLocalRef(pageText);
+		return result;
+	}
+
+	bool PDFBoxBridge::ExtractGlyphs(JNIEnv* env, jobject stripper, std::vector<TextGlyph>& glyphs, std::string& text, std::vector<std::string>& fonts)
+	{
+		glyphs.clear();
+		// getText() 는 페이지를 시작할 때만 목록을 비우므로 마지막으로 추출한 페이지의 글자가 남아 있다.
+		JList articles = nullptr;
+		if (!m_Optional->getCharactersByArticle(env, stripper, &articles) || !articles) {
+			return false;
+		}
+
+		jobject previousFont = nullptr;
+		uint16_t fontId = 0;
+		jint articleCount = 0;
+		bool result = m_Optional->listSize(env, articles, &articleCount);
+		for (jint article = 0; article < articleCount && result; article++) {
+			jobject positions = nullptr;
+			jint positionCount = 0;
+			if (!m_Optional->listGet(env, articles, &positions, article) || !positions || !m_Optional->listSize(env, positions, &positionCount)) {
+				if (positions) {
+					env->DeleteLocalRef(positions);
+				}
+				result = false;
+				break;
+			}
+			for (jint index = 0; index < positionCount && result; index++) {
+				jobject position = nullptr;
+				if (!m_Optional->listGet(env, positions, &position, index) || !position) {
+					result = false;
+					break;
+				}
+				TextGlyph glyph;
+				float* metrics[] = { &glyph.x, &glyph.baseline, &glyph.width, &glyph.height, &glyph.fontSize, &glyph.spaceWidth };
+				for (size_t i = 0; i < sizeof(metrics) / sizeof(metrics[0]) && result; i++) {
+					result = m_Optional->glyphMetrics[i](env, position, metrics[i]);
+				}
+				jstring unicode = nullptr;
+				JFont font = nullptr;
+				result = result && m_Optional->getUnicode(env, position, &unicode) && m_Optional->getFont(env, position, &font);
+
+				glyph.textBegin = static_cast<uint32_t>(text.size());
+				if (result && unicode) {
+					result = appendStringUTF8(env, unicode, text);
+				}
+				glyph.textEnd = static_cast<uint32_t>(text.size());
+
+				// 같은 폰트가 이어지는 경우가 대부분이므로 폰트가 바뀔 때만 이름을 읽는다.
+				if (result && font && !(previousFont && env->IsSameObject(font, previousFont))) {
+					jstring name = nullptr;
+					std::string fontName;
+					if (m_Optional->fontGetName(env, font, &name) && name) {
+						appendStringUTF8(env, name, fontName);
+					}
+					if (name) {
+						env->DeleteLocalRef(name);
+					}
+					const size_t found = std::find(fonts.begin(), fonts.end(), fontName) - fonts.begin();
+					if (found == fonts.size()) {
+						fonts.push_back(fontName);
+					}
+					fontId = static_cast<uint16_t>(std::min<size_t>(found, 0xFFFF));
+					if (previousFont) {
+						env->DeleteLocalRef(previousFont);
+					}
+					previousFont = font;
+					font = nullptr;
+				}
+				glyph.fontId = fontId;
+				glyph.articleStart = index == 0;
+				glyphs.push_back(glyph);
+
+				if (font) {
+					env->DeleteLocalRef(font);
+				}
+				if (unicode) {
+					env->DeleteLocalRef(unicode);
+				}
+				env->DeleteLocalRef(position);
+			}
+			env->DeleteLocalRef(positions);
+		}
+		if (previousFont) {
+			env->DeleteLocalRef(previousFont);
+		}
+		env->DeleteLocalRef(articles);
+		return result && !checkException(env);
+	}
+
+	bool PDFBoxBridge::GetDocumentInfo(JNIEnv* env, jobject document, std::vector<std::pair<std::string, std::string>>& info)
+	{
+		info.clear();
+		JDocumentInformation documentInfo = nullptr;
+		if (!m_Optional->getDocumentInformation(env, document, &documentInfo) || !documentInfo) {
+			return false;
+		}
+		bool result = true;
+		for (size_t i = 0; i < sizeof(DOCUMENT_INFO_KEYS) / sizeof(DOCUMENT_INFO_KEYS[0]) && result; i++) {
+			jstring value = nullptr;
+			if (!m_Optional->infoGetters[i](env, documentInfo, &value)) {
+				result = false;
+				break;
+			}
+			if (!value) {
+				continue;
+			}
+			std::string text;
+			result = appendStringUTF8(env, value, text);
+			env->DeleteLocalRef(value);
+			info.push_back(std::make_pair(std::string(DOCUMENT_INFO_KEYS[i]), text));
+		}
+		env->DeleteLocalRef(documentInfo);
+		return result;
+	}
+
+}} // PDF::Converter
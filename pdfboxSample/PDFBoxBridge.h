@@ -0,0 +1,147 @@
+﻿// PDFBoxBridge.h
+#pragma once
+#include <jni.h>
+#include <string> // std::string
+#include <vector> // std::vector
+#include <utility> // std::pair
+#include <memory> // std::unique_ptr
+#include "PDFBoxConverter.h"
+#include "PDFStructuredText.h"
+
+namespace PDF { namespace Converter {
+
+	// 현재 스레드의 JNIEnv 를 얻는다. JavaVM 에 붙어있지 않은 스레드는 붙였다가 소멸 시 뗀다.
+	class ScopedJNIEnv
+	{
+	public:
+		explicit ScopedJNIEnv(JavaVM* javaVM)
+		: m_JavaVM(javaVM)
+		, m_Env(nullptr)
+		, m_Attached(false)
+		{
+			if (!m_JavaVM) {
+				return;
+			}
+			jint result = m_JavaVM->GetEnv(reinterpret_cast<void**>(&m_Env), JNI_VERSION_1_8);
+			if (result == JNI_EDETACHED) {
+				m_Attached = m_JavaVM->AttachCurrentThread(reinterpret_cast<void**>(&m_Env), nullptr) == JNI_OK;
+			}
+			if (result != JNI_OK && !m_Attached) {
+				m_Env = nullptr;
+			}
+		}
+		~ScopedJNIEnv()
+		{
+			if (m_Attached) {
+				m_JavaVM->DetachCurrentThread();
+			}
+		}
+		JNIEnv* Get() const { return m_Env; }
+
+	private:
+		ScopedJNIEnv(const ScopedJNIEnv&) = delete;
+		ScopedJNIEnv& operator=(const ScopedJNIEnv&) = delete;
+
+	private:
+		JavaVM*	m_JavaVM;
+		JNIEnv*	m_Env;
+		bool	m_Attached;
+	}; // class ScopedJNIEnv
+
+	// PDFBoxModule.jar 에 포함된 Apache PDFBox 클래스를 JNI 로 직접 호출한다.
+	// 클래스/메소드 ID 는 Init() 에서 한번만 조회하며 전역 참조이므로 스레드에 관계없이 사용 가능하다.
+	// 반환되는 jobject 는 호출한 스레드의 로컬 참조이다.
+	class PDFBoxBridge
+	{
+	public:
+		PDFBoxBridge();
+		~PDFBoxBridge();
+
+	public:
+		bool Init(JNIEnv* env);
+		void Fini(JNIEnv* env);
+
+	public:
+		jobject LoadDocument(JNIEnv* env, const std::string& sourceFile);
+		// scratchDir 가 비어 있으면 java.io.tmpdir. MemoryUsageSetting 이 없는 구버전 PDFBox 는 Default 만 가능하다.
+		jobject LoadDocument(JNIEnv* env, const std::string& sourceFile, const MemoryOptions& memory, const std::string& scratchDir);
+		bool SupportsMemoryPolicy() const;
+		void CloseDocument(JNIEnv* env, jobject document);
+		int GetPageCount(JNIEnv* env, jobject document);
+		bool GetPageSize(JNIEnv* env, jobject document, int pageIndex, float* width, float* height); // 회전이 적용된 포인트 단위 크기
+
+		jobject NewRenderer(JNIEnv* env, jobject document);
+		bool SetDraftMode(JNIEnv* env, jobject renderer); // 안티앨리어싱 끄기, 이미지 서브샘플링 허용
+		jobject RenderImage(JNIEnv* env, jobject renderer, int pageIndex, float dpi, PixelFormat format);
+		bool WriteImage(JNIEnv* env, jobject image, const std::string& targetFile);
+		bool WriteSubimage(JNIEnv* env, jobject image, int x, int y, int width, int height, const std::string& targetFile); // 픽셀을 복사하지 않는다.
+
+		jobject NewImage(JNIEnv* env, int width, int height, PixelFormat format);
+		bool RenderTile(JNIEnv* env, jobject renderer, jobject tileImage, int pageIndex, float dpi, int x, int y, PixelFormat format);
+		bool CopyPixels(JNIEnv* env, jobject image, PixelFormat format, Bitmap& bitmap);
+		bool WriteBitmap(JNIEnv* env, const Bitmap& bitmap, int x, int y, int width, int height, const std::string& targetFile); // Mono 미지원
+
+		jobject NewTextStripper(JNIEnv* env);
+		bool ExtractText(JNIEnv* env, jobject stripper, jobject document, int pageIndex, std::string& text); // 페이지 텍스트를 UTF-8 로 덧붙인다.
+		// ExtractText() 직후 호출해서 그 페이지의 TextPosition 을 읽는 순서대로 가져온다.
+		// 글자 텍스트는 text 에 이어 붙이고 폰트 이름은 fonts 에 없으면 추가한다.
+		bool ExtractGlyphs(JNIEnv* env, jobject stripper, std::vector<TextGlyph>& glyphs, std::string& text, std::vector<std::string>& fonts);
+		bool SupportsGlyphs() const;
+
+		bool LoadSystemFonts(JNIEnv* env); // PDFBox 폰트 캐시를 읽거나 만든다.
+
+		// 문서 정보 사전의 Title, Author, Subject, Keywords, Creator, Producer 중 값이 있는 항목 (UTF-8)
+		bool GetDocumentInfo(JNIEnv* env, jobject document, std::vector<std::pair<std::string, std::string>>& info);
+
+	private:
+		jclass		m_FileClass;
+		jclass		m_DocumentClass;
+		jclass		m_RendererClass;
+		jclass		m_ImageIOClass;
+		jclass		m_BufferedImageClass;
+		jclass		m_DataBufferByteClass;
+		jclass		m_DataBufferIntClass;
+		jclass		m_TextStripperClass;
+		jclass		m_MemoryUsageSettingClass; // 구버전 PDFBox 에는 없으며 그 경우 Null
+		jmethodID	m_FileCtorID;
+		jmethodID	m_LoadMethodID;
+		jmethodID	m_CloseMethodID;
+		jmethodID	m_GetNumberOfPagesMethodID;
+		jmethodID	m_RendererCtorID;
+		jmethodID	m_RenderImageWithDPIMethodID;
+		jmethodID	m_WriteImageMethodID;
+		jmethodID	m_GetPageMethodID;
+		jmethodID	m_GetCropBoxMethodID;
+		jmethodID	m_GetRotationMethodID;
+		jmethodID	m_RectGetWidthMethodID;
+		jmethodID	m_RectGetHeightMethodID;
+		jmethodID	m_RenderPageToGraphicsMethodID;
+		jmethodID	m_BufferedImageCtorID;
+		jmethodID	m_CreateGraphicsMethodID;
+		jmethodID	m_GetRasterMethodID;
+		jmethodID	m_GetSubimageMethodID;
+		jmethodID	m_GetWidthMethodID;
+		jmethodID	m_GetHeightMethodID;
+		jmethodID	m_GetDataBufferMethodID;
+		jmethodID	m_DataBufferByteGetDataMethodID;
+		jmethodID	m_DataBufferIntGetDataMethodID;
+		jmethodID	m_SetBackgroundMethodID;
+		jmethodID	m_ClearRectMethodID;
+		jmethodID	m_TranslateMethodID;
+		jmethodID	m_DisposeMethodID;
+		jobject		m_WhiteColor;
+		jobject		m_TransparentColor; // new Color(0, 0, 0, 0)
+		jmethodID	m_SetSubsamplingAllowedMethodID; // 구버전 PDFBox 에는 없으며 그 경우 Null
+		jmethodID	m_SetRenderingHintsMethodID; // 구버전 PDFBox 에는 없으며 그 경우 Null
+		jobject		m_DraftRenderingHints;
+		jobject		m_ImageTypes[5]; // PixelFormat -> org.apache.pdfbox.rendering.ImageType
+		jstring		m_PNGFormatName;
+		jmethodID	m_TextStripperCtorID;
+		jmethodID	m_SetStartPageMethodID;
+		jmethodID	m_SetEndPageMethodID;
+		jmethodID	m_GetTextMethodID;
+		struct OptionalMethods;
+		std::unique_ptr<OptionalMethods> m_Optional; // 메모리 설정, 문서 정보, 글자 위치 (PDFJNIBinding.h)
+	}; // class PDFBoxBridge
+
+}} // PDF::Converter
@@ -1,8 +1,25 @@
 ﻿// PDFBoxConverter.cpp
 #include "PDFBoxConverter.h"
+#include "PDFBoxBridge.h"
+#include "PDFImage.h"
+#include "PDFStructureScanner.h"
+#include "PDFAdmissionController.h"
+#include "PDFWorkerPool.h"
+#include "PDFJNIBinding.h"
+#include "PDFStructuredText.h"
+#include "PDFTextIndex.h"
+#include "PDFDuplicateDetector.h"
 #include <jni.h>
 #include <string>
 #include <memory>
+#include <thread> // std::thread
+#include <atomic> // std::atomic
+#include <mutex> // std::mutex
+#include <condition_variable> // std::condition_variable
+#include <algorithm> // std::min, std::max
+#include <cmath> // std::floor, std::lround
+#include <stdio.h> // snprintf, rename
+#include <limits.h> // INT_MAX
 #include "pdf_assert.h"
 #include "pdf_utils.h"
 
@@ -11,29 +28,381 @@
 #else
 #	include <libgen.h> // dirname
 #	include <unistd.h> // readlink
+#	include <stdlib.h> // getenv
+#	include <dirent.h> // opendir
+#	include <sys/stat.h> // stat
 #	include <memory.h> // memset
+#	include <sys/resource.h> // setpriority
+#	include <sys/syscall.h> // SYS_gettid
 #endif
 
 static const wchar_t* const PDFBOX_JAR_CLASSPATH_NAME = L"-Djava.class.path=";
 static const wchar_t* const PDFBOX_MODULE_FILE_NAME = L"PDFBoxModule.jar";
-static const wchar_t* const PDFBOX_CLASS_NAME = L"PDFBoxModule";
-static const wchar_t* const PDFBOX_CONVERT_IMAGE_METHOD_NAME = L"ConvertPDFToImage";
-static const wchar_t* const PDFBOX_CONVERT_TEXT_METHOD_NAME = L"ConvertPDFToText";
-static const wchar_t* const PDFBOX_INITIALIZE_METHOD_NAME = L"PDFModuleInitialize";
-static const wchar_t* const PDFBOX_GETPAGECOUNT_METHOD_NAME = L"GetPDFPageCount";
+static const char* const PDFBOX_FONTCACHE_OPTION_NAME = "-Dpdfbox.fontcache=";
+static const wchar_t* const PDFBOX_FONTCACHE_FILE_NAME = L".pdfbox.cache"; // FileSystemFontProvider 디스크 캐시
+static const char* const PDFBOX_CLASS_NAME = "PDFBoxModule";
+static const char* const PDFBOX_CONVERT_IMAGE_METHOD_NAME = "ConvertPDFToImage";
+static const char* const PDFBOX_CONVERT_TEXT_METHOD_NAME = "ConvertPDFToText";
+static const char* const PDFBOX_INITIALIZE_METHOD_NAME = "PDFModuleInitialize";
+static const char* const PDFBOX_GETPAGECOUNT_METHOD_NAME = "GetPDFPageCount";
+static const wchar_t* const WARMUP_SAMPLE_FILE_NAME = L"samples/sample01.pdf"; // 빌드 후 실행 파일 옆으로 복사된다.
+static const int MIN_ADMISSION_TILE_SIZE = 256; // 메모리 예산에 맞춰 타일을 줄일 때의 하한
+
+namespace {
+
+	bool isCancelled(const std::shared_ptr<PDF::Converter::CancelToken>& cancelToken)
+	{
+		return cancelToken && cancelToken->IsCancelled();
+	}
+
+	// text 앞에서 maxCharacters 글자(코드 포인트)까지의 바이트 수. characters 에 그 글자 수를 남긴다.
+	size_t utf8Prefix(const std::string& text, size_t maxCharacters, size_t& characters)
+	{
+		characters = 0;
+		for (size_t i = 0; i < text.size(); i++) {
+			if ((static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) { // 연속 바이트가 아니면 글자의 시작
+				if (characters == maxCharacters) {
+					return i;
+				}
+				characters++;
+			}
+		}
+		return text.size();
+	}
+
+	// 완료한 페이지 수를 남긴다. 모든 페이지를 마치기 전에 토큰이 켜졌으면 중단된 것이다.
+	void reportProgress(PDF::Converter::ConvertResult* convertResult, int pageCount, int completedPages, const std::shared_ptr<PDF::Converter::CancelToken>& cancelToken)
+	{
+		if (!convertResult) {
+			return;
+		}
+		convertResult->pageCount = pageCount;
+		convertResult->completedPages = completedPages;
+		convertResult->cancelled = (pageCount < 0 || completedPages < pageCount) && isCancelled(cancelToken);
+		convertResult->deadlineExceeded = convertResult->cancelled && cancelToken->DeadlineExceeded();
+	}
+
+	// 앞 probePages 페이지를 마쳤으면 먼저 변환한 문서와 비교한다. 같으면 그 문서 경로, 아니면 빈 문자열
+	std::string matchDuplicatePrefix(const std::shared_ptr<PDF::Converter::DuplicateDetector>& duplicates, const std::string& sourcePath, int pageIndex, int pageCount)
+	{
+		if (!duplicates || pageIndex + 1 != duplicates->Options().probePages || pageIndex + 1 >= pageCount) {
+			return "";
+		}
+		return duplicates->MatchPrefix(sourcePath);
+	}
+
+	// 중복 검출에 문서가 끝났음을 알리고 나머지 페이지를 건너뛰었으면 결과에 남긴다.
+	void reportDuplicate(PDF::Converter::ConvertResult* convertResult, const std::shared_ptr<PDF::Converter::DuplicateDetector>& duplicates,
+		const std::string& sourcePath, const std::string& duplicateOf)
+	{
+		if (duplicates) {
+			duplicates->Finish(sourcePath, duplicateOf);
+		}
+		if (convertResult && !duplicateOf.empty()) {
+			convertResult->duplicate = true;
+			convertResult->truncated = true;
+		}
+	}
+
+	// 페이지별 잉크 비율과 쓰지 않은 빈 페이지 수를 남긴다.
+	void reportInkCoverage(PDF::Converter::ConvertResult* convertResult, std::vector<float>& inkCoverage, int blankPages)
+	{
+		if (!convertResult) {
+			return;
+		}
+		convertResult->inkCoverage.swap(inkCoverage);
+		convertResult->blankPages = blankPages;
+	}
+
+	// 현재 스레드를 낮은 우선순위로 내린다. 리눅스는 스레드별 nice 값을 사용한다.
+	void lowerThreadPriority()
+	{
+#ifdef _WIN32
+		::SetThreadPriority(::GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+#else
+		setpriority(PRIO_PROCESS, static_cast<id_t>(syscall(SYS_gettid)), 10);
+#endif
+	}
+
+	// 완성된 임시 파일로 대상 파일을 교체한다.
+	bool replaceFile(const std::string& sourceFile, const std::string& targetFile)
+	{
+#ifdef _WIN32
+		return ::MoveFileExA(sourceFile.c_str(), targetFile.c_str(), MOVEFILE_REPLACE_EXISTING) ? true : false;
+#else
+		return rename(sourceFile.c_str(), targetFile.c_str()) == 0;
+#endif
+	}
+
+	// 변환 한 건의 PDFBox 임시 파일 폴더. 닫기 전에 크기를 재고 소멸 시 지운다.
+	class ScratchSpace
+	{
+	public:
+		explicit ScratchSpace(const PDF::Converter::MemoryOptions& memory)
+		{
+			if (memory.policy != PDF::Converter::MemoryPolicy::Mixed && memory.policy != PDF::Converter::MemoryPolicy::TempFile) {
+				return;
+			}
+			static std::atomic<unsigned int> s_Sequence(0);
+			std::string parentDir = _U2A(memory.scratchDir);
+#ifdef _WIN32
+			if (parentDir.empty()) {
+				char tempDir[MAX_PATH + 1] = { 0, };
+				::GetTempPathA(MAX_PATH + 1, tempDir);
+				parentDir = tempDir;
+			}
+			const unsigned long processID = ::GetCurrentProcessId();
+#else
+			if (parentDir.empty()) {
+				const char* tempDir = getenv("TMPDIR");
+				parentDir = tempDir ? tempDir : "/tmp";
+			}
+			const unsigned long processID = static_cast<unsigned long>(getpid());
+#endif
+			pathCreateDirectory(parentDir.c_str());
+			const std::string dir = pathAddSeparator(parentDir) + "pdfbox-" + std::to_string(processID) + "-" + std::to_string(s_Sequence++);
+			if (pathCreateDirectory(dir.c_str())) {
+				m_Dir = dir;
+			}
+		}
+		~ScratchSpace()
+		{
+			if (m_Dir.empty()) {
+				return;
+			}
+			forEachFile([](const std::string& file, int64_t) { remove(file.c_str()); });
+#ifdef _WIN32
+			::RemoveDirectoryA(m_Dir.c_str());
+#else
+			rmdir(m_Dir.c_str());
+#endif
+		}
+
+		const std::string& Dir() const { return m_Dir; }
+
+		// ScratchFile 은 문서를 닫을 때까지 줄지 않으므로 닫기 직전의 크기가 최대 사용량이다.
+		int64_t Bytes() const
+		{
+			int64_t bytes = 0;
+			forEachFile([&bytes](const std::string&, int64_t size) { bytes += size; });
+			return bytes;
+		}
+
+	private:
+		template <typename Function>
+		void forEachFile(Function function) const
+		{
+			if (m_Dir.empty()) {
+				return;
+			}
+			const std::string dir = pathAddSeparator(m_Dir);
+#ifdef _WIN32
+			WIN32_FIND_DATAA findData;
+			HANDLE find = ::FindFirstFileA((dir + "*").c_str(), &findData);
+			if (find == INVALID_HANDLE_VALUE) {
+				return;
+			}
+			do {
+				if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+					function(dir + findData.cFileName, (static_cast<int64_t>(findData.nFileSizeHigh) << 32) | findData.nFileSizeLow);
+				}
+			} while (::FindNextFileA(find, &findData));
+			::FindClose(find);
+#else
+			DIR* directory = opendir(dir.c_str());
+			if (!directory) {
+				return;
+			}
+			while (dirent* entry = readdir(directory)) {
+				struct stat info;
+				const std::string file = dir + entry->d_name;
+				if (stat(file.c_str(), &info) == 0 && S_ISREG(info.st_mode)) {
+					function(file, static_cast<int64_t>(info.st_size));
+				}
+			}
+			closedir(directory);
+#endif
+		}
+
+	private:
+		std::string m_Dir;
+	}; // class ScratchSpace
+
+	// 문서 스트림 메모리 설정과 임시 파일 사용량을 남긴다.
+	void reportMemory(PDF::Converter::ConvertResult* convertResult, const PDF::Converter::MemoryOptions& memory, int64_t scratchBytes)
+	{
+		if (!convertResult) {
+			return;
+		}
+		switch (memory.policy) {
+		case PDF::Converter::MemoryPolicy::MainMemory:
+			convertResult->heapLimitBytes = memory.mainMemoryBytes > 0 ? memory.mainMemoryBytes : -1;
+			break;
+		case PDF::Converter::MemoryPolicy::Mixed:
+			convertResult->heapLimitBytes = std::max<int64_t>(memory.mainMemoryBytes, 0);
+			break;
+		case PDF::Converter::MemoryPolicy::TempFile:
+			convertResult->heapLimitBytes = 0;
+			break;
+		default:
+			convertResult->heapLimitBytes = -1;
+			break;
+		}
+		convertResult->scratchBytes = scratchBytes;
+	}
+
+	// JSON 문자열 리터럴. UTF-8 은 그대로 두고 제어 문자만 이스케이프한다.
+	std::string jsonString(const std::string& value)
+	{
+		std::string quoted = "\"";
+		for (const char ch : value) {
+			switch (ch) {
+			case '"': quoted += "\\\""; break;
+			case '\\': quoted += "\\\\"; break;
+			case '\n': quoted += "\\n"; break;
+			case '\r': quoted += "\\r"; break;
+			case '\t': quoted += "\\t"; break;
+			default:
+				if (static_cast<unsigned char>(ch) < 0x20) {
+					char escaped[8] = { 0, };
+					snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned char>(ch));
+					quoted += escaped;
+				} else {
+					quoted += ch;
+				}
+				break;
+			}
+		}
+		return quoted + "\"";
+	}
+
+	bool writeDeepZoomDescriptor(const std::string& descriptorFile, int width, int height, const PDF::Converter::PyramidOptions& options)
+	{
+		AutoFilePtr file(fopen(descriptorFile.c_str(), "wb"));
+		if (!file) {
+			return false;
+		}
+		fprintf(file.get(), "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+		fprintf(file.get(), "<Image xmlns=\"http://schemas.microsoft.com/deepzoom/2008\" Format=\"png\" Overlap=\"%d\" TileSize=\"%d\">\n", options.overlap, options.tileSize);
+		fprintf(file.get(), "  <Size Width=\"%d\" Height=\"%d\"/>\n", width, height);
+		fprintf(file.get(), "</Image>\n");
+		return ferror(file.get()) == 0;
+	}
+
+	// 최대 레벨 비트맵에서 시작해서 절반씩 줄여가며 레벨 0(1x1) 까지 타일을 쓰고 마지막에 디스크립터를 쓴다.
+	bool writePyramid(JNIEnv* env, PDF::Converter::PDFBoxBridge& bridge, PDF::Converter::Bitmap& page, const std::string& pagePrefix, const PDF::Converter::PyramidOptions& options)
+	{
+		const std::string filesDir = pagePrefix + "_files";
+		if (!pathCreateDirectory(filesDir.c_str())) {
+			return false;
+		}
+
+		const int width = page.width;
+		const int height = page.height;
+		int maxLevel = 0;
+		for (int size = std::max(width, height); size > 1; size = (size + 1) / 2) {
+			maxLevel++;
+		}
+
+		PDF::Converter::Bitmap current;
+		PDF::Converter::Bitmap next;
+		std::swap(current, page);
+		const int tileSize = options.tileSize;
+		const int overlap = options.overlap;
+		for (int level = maxLevel; level >= 0; level--) {
+			const std::string levelDir = filesDir + "/" + std::to_string(level);
+			if (!pathCreateDirectory(levelDir.c_str())) {
+				return false;
+			}
+
+			const int columns = (current.width + tileSize - 1) / tileSize;
+			const int rows = (current.height + tileSize - 1) / tileSize;
+			for (int row = 0; row < rows; row++) {
+				for (int column = 0; column < columns; column++) {
+					const int x = std::max(column * tileSize - overlap, 0);
+					const int y = std::max(row * tileSize - overlap, 0);
+					const int right = std::min((column + 1) * tileSize + overlap, current.width);
+					const int bottom = std::min((row + 1) * tileSize + overlap, current.height);
+					const std::string tileFile = levelDir + "/" + std::to_string(column) + "_" + std::to_string(row) + ".png";
+					if (!bridge.WriteBitmap(env, current, x, y, right - x, bottom - y, tileFile)) {
+						return false;
+					}
+				}
+			}
+
+			if (level > 0) {
+				bool result = options.filter == PDF::Converter::ResampleFilter::Box
+					? PDF::Converter::HalveBitmap(current, next)
+					: PDF::Converter::ResizeBitmap(current, (current.width + 1) / 2, (current.height + 1) / 2, options.filter, next);
+				if (!result) {
+					return false;
+				}
+				std::swap(current, next);
+			}
+		}
+
+		return writeDeepZoomDescriptor(pagePrefix + ".dzi", width, height, options);
+	}
+}
 
 namespace PDF { namespace Converter {
 
-	
+	CancelToken::CancelToken()
+	: m_Cancelled(false)
+	, m_Deadline(0)
+	{
+	}
+
+	void CancelToken::Cancel()
+	{
+		m_Cancelled = true;
+	}
+
+	void CancelToken::SetDeadline(std::chrono::steady_clock::time_point deadline)
+	{
+		m_Deadline = std::max<std::chrono::steady_clock::rep>(deadline.time_since_epoch().count(), 1);
+	}
+
+	void CancelToken::SetTimeout(std::chrono::milliseconds timeout)
+	{
+		SetDeadline(std::chrono::steady_clock::now() + timeout);
+	}
+
+	bool CancelToken::IsCancelled() const
+	{
+		return m_Cancelled || DeadlineExceeded();
+	}
+
+	bool CancelToken::DeadlineExceeded() const
+	{
+		const std::chrono::steady_clock::rep deadline = m_Deadline;
+		return deadline != 0 && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline;
+	}
+
+	bool UsesModulePath(const ImageOptions& options, bool hasBridge)
+	{
+		// PDFBoxModule 기본 포맷은 페이지 단위 렌더링만 지원하고 중간에 멈출 수 없다.
+		return options.format == PixelFormat::Default && options.tileMode != TileMode::Always && !options.tileSink && options.variants.empty()
+			&& options.memory.policy == MemoryPolicy::Default
+			&& (!hasBridge || (!options.cancelToken && !options.duplicates && !options.blankPages.detect && !options.autoCrop.enabled));
+	}
+
+	// 시그니처는 함수 타입에서 컴파일 시간에 만들어진다.
+	struct PDFBox::ModuleMethods
+	{
+		Method<Static, jboolean(jstring, jstring, jint)> convertToImage;
+		Method<Static, jboolean(jstring, jstring)> convertToText;
+		Method<Static, jboolean(jstring, jstring)> initialize;
+		Method<Static, jint()> getPageCount;
+	}; // struct PDFBox::ModuleMethods
 
 	PDFBox::PDFBox()
 	: m_Env(nullptr)
 	, m_JavaVM(nullptr)
 	, m_TargetClass(nullptr)
-	, m_PDFToImageMethodID(nullptr)
-	, m_PDFToTextMethodID(nullptr)
-	, m_InitializeMethodID(nullptr)
-	, m_GetPageCountMethodID(nullptr)
+	, m_Module(new ModuleMethods())
+	, m_Bridge(new PDFBoxBridge())
+	, m_FontCacheWarm(false)
 	{
 	}
 
@@ -44,7 +413,12 @@ namespace PDF { namespace Converter {
 
 	bool PDFBox::Init()
 	{
-		JavaVMOption vmOptions[1] = { 0, };
+		return Init(InitOptions());
+	}
+
+	bool PDFBox::Init(const InitOptions& options)
+	{
+		JavaVMOption vmOptions[2] = { 0, };
 #ifdef _WIN32
 		// 윈도우에서는 자바 클래스 패스가 상대경로도 가능하지만 리눅스에서는 상대경로 지정시
 		// 실패해서 리눅스와 동일하게 절대경로로 변경한다.
@@ -54,6 +428,7 @@ namespace PDF { namespace Converter {
 		::GetModuleFileNameW(nullptr, exePath, sizeof(exePath));
 		_wsplitpath_s(exePath, drive, _MAX_DRIVE, dir, _MAX_DIR, nullptr, 0, nullptr, 0);
 		std::wstring exeDir = std::wstring(drive) + dir;
+		m_ModuleDir = exeDir;
 
 		wchar_t optionStringW[_MAX_PATH] = { 0, };
 		_snwprintf_s(optionStringW, _countof(optionStringW), _TRUNCATE, L"%s%s%s", PDFBOX_JAR_CLASSPATH_NAME, exeDir.c_str(), PDFBOX_MODULE_FILE_NAME);
@@ -68,6 +443,7 @@ namespace PDF { namespace Converter {
 		const char* exePath = nullptr;
 		if (count != -1) {
 			exePath = dirname(pathTemp);
+			m_ModuleDir = _A2U(pathAddSeparator(exePath));
 		}
 		char optionString[maxPath] = { 0, };
 		memset(optionString, 0x00, maxPath);
@@ -76,9 +452,35 @@ namespace PDF { namespace Converter {
 		printf("%s\n", optionString);
 #endif
 
+		// PDFBox 는 pdfbox.fontcache, user.home 순서로 캐시 폴더를 정한다.
+		std::string fontCacheOption;
+		std::wstring fontCacheDir = options.fontCacheDir;
+		if (!fontCacheDir.empty()) {
+			pathCreateDirectory(_U2A(fontCacheDir).c_str()); // 폴더가 없으면 PDFBox 는 user.home 을 사용한다.
+			fontCacheOption = PDFBOX_FONTCACHE_OPTION_NAME + _U2A(fontCacheDir);
+			vmOptions[1].optionString = const_cast<char*>(fontCacheOption.c_str());
+		} else {
+#ifdef _WIN32
+			size_t requiredSize = 0;
+			_wgetenv_s(&requiredSize, nullptr, 0, L"USERPROFILE");
+			if (requiredSize > 0) {
+				std::vector<wchar_t> homeDir(requiredSize, 0);
+				_wgetenv_s(&requiredSize, &homeDir[0], requiredSize, L"USERPROFILE");
+				fontCacheDir = &homeDir[0];
+			}
+#else
+			const char* homeDir = getenv("HOME");
+			if (homeDir) {
+				fontCacheDir = _A2U(homeDir);
+			}
+#endif
+		}
+		m_FontCacheFile = fontCacheDir.empty() ? std::wstring() : _A2U(pathAddSeparator(_U2A(fontCacheDir))) + PDFBOX_FONTCACHE_FILE_NAME;
+		m_FontCacheWarm = !m_FontCacheFile.empty() && pathFileExists(_U2A(m_FontCacheFile).c_str());
+
 		JavaVMInitArgs vmArgs = { 0, };
 		vmArgs.options = vmOptions;
-		vmArgs.nOptions = 1;
+		vmArgs.nOptions = fontCacheOption.empty() ? 1 : 2;
 		vmArgs.version = JNI_VERSION_1_8;
 
 		// create java virtual mathine		
@@ -89,63 +491,147 @@ namespace PDF { namespace Converter {
 		}
 
 		// find target class and load
-		m_TargetClass = m_Env->FindClass(_U2A(PDFBOX_CLASS_NAME).c_str());
-		_ASSERTE(m_TargetClass && "m_Env->FindClass() Failed");
+		// 다른 스레드에서도 사용할 수 있도록 전역 참조로 바꾼다.
+		jclass targetClass = m_Env->FindClass(PDFBOX_CLASS_NAME);
+		_ASSERTE(targetClass && "m_Env->FindClass() Failed");
+		if (!targetClass) {
+			return false;
+		}
+		m_TargetClass = static_cast<jclass>(m_Env->NewGlobalRef(targetClass));
+		m_Env->DeleteLocalRef(targetClass);
 		if (!m_TargetClass) {
 			return false;
 		}
 
-		m_PDFToImageMethodID = m_Env->GetStaticMethodID(
-			m_TargetClass,
-			_U2A(PDFBOX_CONVERT_IMAGE_METHOD_NAME).c_str(),
-			"(Ljava/lang/String;Ljava/lang/String;I)Z"
-		);
-		_ASSERTE(m_PDFToImageMethodID && "m_Env->GetStaticMethodID() Failed");
-		if (!m_PDFToImageMethodID) {
+		bool resolved = m_Module->convertToImage.Resolve(m_Env, m_TargetClass, PDFBOX_CONVERT_IMAGE_METHOD_NAME)
+			&& m_Module->convertToText.Resolve(m_Env, m_TargetClass, PDFBOX_CONVERT_TEXT_METHOD_NAME)
+			&& m_Module->initialize.Resolve(m_Env, m_TargetClass, PDFBOX_INITIALIZE_METHOD_NAME)
+			&& m_Module->getPageCount.Resolve(m_Env, m_TargetClass, PDFBOX_GETPAGECOUNT_METHOD_NAME);
+		_ASSERTE(resolved && "m_Env->GetStaticMethodID() Failed");
+		if (!resolved) {
 			return false;
 		}
 
-		m_PDFToTextMethodID = m_Env->GetStaticMethodID(
-			m_TargetClass, 
-			_U2A(PDFBOX_CONVERT_TEXT_METHOD_NAME).c_str(),
-			"(Ljava/lang/String;Ljava/lang/String;)Z"
-		);
-		_ASSERTE(m_PDFToTextMethodID && "m_Env->GetStaticMethodID() Failed");
-		if (!m_PDFToTextMethodID) {
-			return false;
+		// PDFBox 직접 호출 경로는 선택 기능이므로 실패해도 기본 변환은 사용할 수 있다.
+		if (!m_Bridge->Init(m_Env)) {
+			m_Bridge.reset();
 		}
 
-		m_InitializeMethodID = m_Env->GetStaticMethodID(
-			m_TargetClass, 
-			_U2A(PDFBOX_INITIALIZE_METHOD_NAME).c_str(),
-			"(Ljava/lang/String;Ljava/lang/String;)Z"
-		);
-		_ASSERTE(m_InitializeMethodID && "m_Env->GetStaticMethodID() Failed");
-		if (!m_InitializeMethodID) {
+		return true;
+	}
+
+	bool PDFBox::BuildFontCache()
+	{
+		_ASSERTE(m_Env && "m_Env is not Null");
+		_ASSERTE(m_Bridge && "m_Bridge is not Null");
+		if (!m_Env || !m_Bridge) {
+			return false;
+		}
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env || !m_Bridge->LoadSystemFonts(env)) {
 			return false;
 		}
+		return pathFileExists(_U2A(m_FontCacheFile).c_str());
+	}
 
-		m_GetPageCountMethodID = m_Env->GetStaticMethodID(
-			m_TargetClass, 
-			_U2A(PDFBOX_GETPAGECOUNT_METHOD_NAME).c_str(),
-			"()I"
-		);
-		_ASSERTE(m_GetPageCountMethodID && "m_Env->GetStaticMethodID() Failed");
-		if (!m_GetPageCountMethodID) {
+	bool PDFBox::WarmUp(const WarmupOptions& options, WarmupResult* warmupResult /*= nullptr*/)
+	{
+		_ASSERTE(m_Env && "m_Env is not Null");
+		_ASSERTE(options.maxIterations > 0 && options.stableIterations > 0 && "invalid options");
+		if (!m_Env || options.maxIterations <= 0 || options.stableIterations <= 0) {
+			return false;
+		}
+		// 결과를 메모리로 받는 싱크는 직접 경로에만 있다. 모듈 경로는 파일을 쓰므로 데우지 않는다.
+		if (!m_Bridge) {
+			if (warmupResult) {
+				*warmupResult = WarmupResult();
+			}
 			return false;
 		}
 
-		return true;
+		std::vector<std::wstring> corpus = options.corpus;
+		if (corpus.empty()) {
+			corpus.push_back(m_ModuleDir + WARMUP_SAMPLE_FILE_NAME);
+		}
+
+		// 싱크가 있으면 PDFBox 를 직접 호출하므로 렌더러와 텍스트 추출기를 거치고 결과는 메모리에서 버린다.
+		ImageOptions imageOptions;
+		imageOptions.dpi = options.dpi;
+		imageOptions.format = PixelFormat::RGB;
+		imageOptions.tileSink = [](const ImageTile&, const Bitmap&) -> bool { return true; };
+		TextOptions textOptions;
+		textOptions.textSink = [](int, const std::string&) -> bool { return true; };
+
+		WarmupResult warmup;
+		bool result = true;
+		std::vector<double> iterationSeconds;
+		const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+		while (warmup.iterations < options.maxIterations) {
+			const std::chrono::steady_clock::time_point iterationBegin = std::chrono::steady_clock::now();
+			for (const std::wstring& sourceFile : corpus) {
+				result = ToImage(sourceFile.c_str(), L"", imageOptions) && result;
+				result = ToText(sourceFile.c_str(), L"", textOptions) && result;
+			}
+			iterationSeconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - iterationBegin).count());
+			warmup.iterations++;
+			if (!result) {
+				break; // 변환이 실패하면 반복 시간이 의미가 없다.
+			}
+
+			// 마지막 stableIterations 번의 최대, 최소 차이가 평균의 tolerance 배 안이면 멈춘다.
+			const size_t window = static_cast<size_t>(options.stableIterations);
+			if (warmup.iterations < options.minIterations || iterationSeconds.size() < window) {
+				continue;
+			}
+			const std::vector<double>::const_iterator first = iterationSeconds.end() - window;
+			const double fastest = *std::min_element(first, iterationSeconds.cend());
+			const double slowest = *std::max_element(first, iterationSeconds.cend());
+			double mean = 0.0;
+			for (std::vector<double>::const_iterator it = first; it != iterationSeconds.cend(); ++it) {
+				mean += *it / window;
+			}
+			warmup.steadyIterationSeconds = mean;
+			if (slowest - fastest <= mean * options.tolerance) {
+				warmup.stabilized = true;
+				break;
+			}
+		}
+		warmup.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+		warmup.firstIterationSeconds = iterationSeconds.empty() ? 0.0 : iterationSeconds.front();
+		if (warmupResult) {
+			*warmupResult = warmup;
+		}
+		return result;
 	}
 
 	void PDFBox::Fini()
 	{
+		StopWorkers(); // 작업자 스레드를 JavaVM 에서 떼어야 DestroyJavaVM() 이 끝난다.
+		if (m_Bridge) {
+			m_Bridge->Fini(m_Env);
+		}
+		if (m_TargetClass) {
+			m_Env->DeleteGlobalRef(m_TargetClass);
+			m_TargetClass = nullptr;
+		}
+		*m_Module = ModuleMethods(); // 메소드 ID 는 JavaVM 과 함께 무효가 된다.
 		if (m_JavaVM) {
 			m_JavaVM->DestroyJavaVM();
+			m_JavaVM = nullptr;
+			m_Env = nullptr;
 		}
 	}
 
-	bool PDFBox::ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, int dpi /*= 96*/)
+	bool PDFBox::ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, int dpi /*= 96*/, PixelFormat format /*= PixelFormat::Default*/)
+	{
+		ImageOptions options;
+		options.dpi = dpi;
+		options.format = format;
+		return ToImage(sourceFile, targetDir, options);
+	}
+
+	bool PDFBox::ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, const ImageOptions& options, ConvertResult* convertResult /*= nullptr*/)
 	{
 		_ASSERTE(sourceFile && "sourceFile is not Null");
 		_ASSERTE(targetDir && "sourceFile is not Null");
@@ -154,67 +640,1111 @@ namespace PDF { namespace Converter {
 			return false;
 		}
 
-		jstring jsoureFile = m_Env->NewStringUTF(_U2A(sourceFile).c_str());
-		jstring jtargetDir = m_Env->NewStringUTF(_U2A(targetDir).c_str());
+		// 메모리 예산이 있으면 구조 분석으로 사용량을 추정하고 예산 안에 들어올 때까지 기다린다.
+		ImageOptions admitted = options;
+		MemoryEstimate estimate;
+		if (m_Admission) {
+			DocumentStructure structure;
+			ScanStructure(sourceFile, structure); // 실패하면 Letter 크기로 추정한다.
+			estimate = EstimateImageMemory(structure, admitted, m_Bridge != nullptr);
+			if (estimate.Total() > m_Admission->Budget() && admitted.variants.empty() && m_Bridge) {
+				// 한 페이지가 예산을 넘으면 타일 크기를 줄여 렌더링 버퍼를 예산 안으로 맞춘다.
+				admitted.tileMode = TileMode::Always;
+				if (admitted.format == PixelFormat::Default) {
+					admitted.format = PixelFormat::RGB;
+				}
+				while (admitted.tileSize > MIN_ADMISSION_TILE_SIZE
+					&& estimate.documentBytes + EstimateRasterBytes(admitted.tileSize, admitted.tileSize, admitted.format) > m_Admission->Budget()) {
+					admitted.tileSize /= 2;
+				}
+				estimate = EstimateImageMemory(structure, admitted, m_Bridge != nullptr);
+			}
+		}
+		AdmissionTicket ticket(m_Admission.get(), estimate.Total(), admitted.cancelToken.get());
+		if (isCancelled(admitted.cancelToken)) {
+			reportProgress(convertResult, -1, 0, admitted.cancelToken); // 허가를 기다리는 동안 취소되었다.
+			return false;
+		}
 
-		int32_t pageCount  = 0;
-		bool result = m_Env->CallStaticBooleanMethod(
-			m_TargetClass, 
-			m_InitializeMethodID, 
-			jsoureFile,
-			jtargetDir, 
-			dpi
-		);
-		_ASSERTE(result && "m_Env->CallStaticBooleanMethod() Failed");
-		if (!result) {
-			goto CLEAN_UP;
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env) {
+			return false;
+		}
+
+		// PDFBoxModule 은 문서 전체를 한번에 변환하므로 취소하거나 페이지를 검사하는 옵션은 직접 렌더링해야 한다.
+		_ASSERTE((m_Bridge || !admitted.cancelToken) && "CancelToken needs PDFBox direct path");
+		_ASSERTE((m_Bridge || !admitted.duplicates) && "DuplicateDetector needs PDFBox direct path");
+		_ASSERTE((m_Bridge || !admitted.blankPages.detect) && "BlankPageOptions needs PDFBox direct path");
+		_ASSERTE((m_Bridge || !admitted.autoCrop.enabled) && "AutoCropOptions needs PDFBox direct path");
+		if (!m_Bridge && (admitted.cancelToken || admitted.duplicates || admitted.blankPages.detect || admitted.autoCrop.enabled)) {
+			return false;
+		}
+
+		// PDFBoxModule 로 변환할 수 없으면 PDFBox 로 대상 포맷에 직접 렌더링한다.
+		if (UsesModulePath(admitted, m_Bridge != nullptr)) {
+			return moduleToImage(env, sourceFile, targetDir, admitted.dpi, convertResult);
 		}
+		return renderImages(env, sourceFile, targetDir, admitted, convertResult);
+	}
+
+	bool PDFBox::ToText(const wchar_t* sourceFile, const wchar_t* targetDir)
+	{
+		return ToText(sourceFile, targetDir, TextOptions());
+	}
 
-		pageCount = m_Env->CallStaticIntMethod(m_TargetClass, m_GetPageCountMethodID);
-		if (pageCount == -1) {
-			result = false;
-			goto CLEAN_UP;
+	bool PDFBox::ToText(const wchar_t* sourceFile, const wchar_t* targetDir, const TextOptions& options, ConvertResult* convertResult /*= nullptr*/)
+	{
+		_ASSERTE(sourceFile && "sourceFile is not Null");
+		_ASSERTE(targetDir && "sourceFile is not Null");
+		_ASSERTE(m_Env && "m_Env is not Null");
+		if (!sourceFile || !targetDir || !m_Env) {
+			return false;
 		}
 
-		result = m_Env->CallStaticBooleanMethod(
-			m_TargetClass,
-			m_PDFToImageMethodID, 
-			jsoureFile,
-			jtargetDir,
-			dpi
-		);
-		_ASSERTE(result && "m_Env->CallStaticBooleanMethod() Failed");
+		MemoryEstimate estimate;
+		if (m_Admission) {
+			DocumentStructure structure;
+			ScanStructure(sourceFile, structure);
+			estimate = EstimateTextMemory(structure, options.memory);
+			if (options.budget.maxPages > 0 && structure.pageCount > options.budget.maxPages) {
+				// 앞 페이지만 읽으므로 페이지 비율만큼만 예약한다.
+				estimate.pageBytes = estimate.pageBytes * options.budget.maxPages / structure.pageCount;
+			}
+		}
+		AdmissionTicket ticket(m_Admission.get(), estimate.Total(), options.cancelToken.get());
+		if (isCancelled(options.cancelToken)) {
+			reportProgress(convertResult, -1, 0, options.cancelToken);
+			return false;
+		}
 
-CLEAN_UP:
-		m_Env->DeleteLocalRef(jsoureFile);
-		m_Env->DeleteLocalRef(jtargetDir);
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env) {
+			return false;
+		}
+
+		// PDFBoxModule 은 문서 전체를 한번에 파일로 추출하므로 취소하거나 메모리로 받거나 색인하거나 한도가 있을 때는 페이지씩 직접 추출한다.
+		if ((options.cancelToken || options.textSink || options.indexer || options.duplicates || options.budget.Limited() || options.memory.policy != MemoryPolicy::Default) && m_Bridge) {
+			return extractText(env, sourceFile, targetDir, options, convertResult);
+		}
+		_ASSERTE(options.memory.policy == MemoryPolicy::Default && "MemoryOptions needs PDFBox direct path");
+		_ASSERTE(!options.cancelToken && "CancelToken needs PDFBox direct path");
+		_ASSERTE(!options.textSink && "TextSink needs PDFBox direct path");
+		_ASSERTE(!options.indexer && "TextIndexer needs PDFBox direct path");
+		_ASSERTE(!options.budget.Limited() && "TextBudget needs PDFBox direct path");
+		_ASSERTE(!options.duplicates && "DuplicateDetector needs PDFBox direct path");
+		if (options.memory.policy != MemoryPolicy::Default || options.cancelToken || options.textSink || options.indexer || options.duplicates || options.budget.Limited()) {
+			return false;
+		}
+
+		std::lock_guard<std::mutex> lock(m_ModuleMutex);
+		jstring jsoureFile = env->NewStringUTF(_U2A(sourceFile).c_str());
+		jstring jtargetDir = env->NewStringUTF(_U2A(targetDir).c_str());
+
+		jboolean converted = JNI_FALSE;
+		bool result = m_Module->convertToText(env, m_TargetClass, &converted, jsoureFile, jtargetDir) && converted;
+		_ASSERTE(result && "ConvertPDFToText() Failed");
+
+		env->DeleteLocalRef(jsoureFile);
+		env->DeleteLocalRef(jtargetDir);
 
 		return result;
 	}
 
-	bool PDFBox::ToText(const wchar_t* sourceFile, const wchar_t* targetDir)
+	bool PDFBox::Convert(const wchar_t* sourceFile, const wchar_t* targetDir, const ConvertOptions& options, ConvertResult* convertResult /*= nullptr*/)
 	{
 		_ASSERTE(sourceFile && "sourceFile is not Null");
 		_ASSERTE(targetDir && "sourceFile is not Null");
 		_ASSERTE(m_Env && "m_Env is not Null");
-		if (!sourceFile || !targetDir || !m_Env) {
+		_ASSERTE(m_Bridge && "m_Bridge is not Null");
+		if (!sourceFile || !targetDir || !m_Env || !m_Bridge) {
+			return false;
+		}
+		const ImageOptions& imageOptions = options.image;
+		const ConvertOutputs& outputs = options.outputs;
+		_ASSERTE((!outputs.image || (imageOptions.dpi > 0 && imageOptions.tileSize > 0)) && "invalid options");
+		if (outputs.image && (imageOptions.dpi <= 0 || imageOptions.tileSize <= 0)) {
 			return false;
 		}
 
-		jstring jsoureFile = m_Env->NewStringUTF(_U2A(sourceFile).c_str());
-		jstring jtargetDir = m_Env->NewStringUTF(_U2A(targetDir).c_str());
+		// 문서는 한번만 열리므로 렌더링 버퍼와 텍스트 위치 정보를 더한다.
+		MemoryEstimate estimate;
+		if (m_Admission) {
+			DocumentStructure structure;
+			ScanStructure(sourceFile, structure);
+			const MemoryEstimate imageEstimate = EstimateImageMemory(structure, imageOptions, m_Bridge != nullptr);
+			const MemoryEstimate textEstimate = EstimateTextMemory(structure, imageOptions.memory);
+			estimate.documentBytes = imageEstimate.documentBytes;
+			estimate.pageBytes = (outputs.image ? imageEstimate.pageBytes : 0) + (outputs.text ? textEstimate.pageBytes : 0);
+		}
+		AdmissionTicket ticket(m_Admission.get(), estimate.Total(), imageOptions.cancelToken.get());
+		if (isCancelled(imageOptions.cancelToken)) {
+			reportProgress(convertResult, -1, 0, imageOptions.cancelToken);
+			return false;
+		}
 
-		bool result = m_Env->CallStaticBooleanMethod(
-			m_TargetClass,
-			m_PDFToTextMethodID,
-			jsoureFile,
-			jtargetDir
-		);
-		_ASSERTE(result && "m_Env->CallStaticBooleanMethod() Failed");
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env) {
+			return false;
+		}
+
+		const std::string sourcePath = _U2A(sourceFile);
+		ScratchSpace scratch(imageOptions.memory);
+		jobject document = m_Bridge->LoadDocument(env, sourcePath, imageOptions.memory, scratch.Dir());
+		_ASSERTE(document && "m_Bridge->LoadDocument() Failed");
+		if (!document) {
+			return false;
+		}
 
-		m_Env->DeleteLocalRef(jsoureFile);
-		m_Env->DeleteLocalRef(jtargetDir);
+		const std::string targetPrefix = _U2A(targetDir) + removeExt(pathFindFilename(sourcePath));
+		AutoFilePtr textFile;
+		if (outputs.text && !options.textSink) {
+			textFile.reset(fopen((targetPrefix + ".txt").c_str(), "wb"));
+		}
+		// 구조화 텍스트는 같은 PDFTextStripper 가 페이지 텍스트를 만들며 모은 글자 위치를 읽는다.
+		StructuredTextWriter structuredText;
+		const bool structured = outputs.structuredText && m_Bridge->SupportsGlyphs() && structuredText.Open(targetPrefix + ".stx");
+		const int pageCount = m_Bridge->GetPageCount(env, document);
+		jobject renderer = (outputs.image && pageCount > 0) ? m_Bridge->NewRenderer(env, document) : nullptr;
+		jobject stripper = (((outputs.text && (textFile || options.textSink)) || structured || options.indexer || options.duplicates) && pageCount >= 0) ? m_Bridge->NewTextStripper(env) : nullptr;
+		bool result = pageCount >= 0 && (!outputs.image || pageCount == 0 || renderer) && (!(outputs.text || outputs.structuredText || options.indexer || options.duplicates) || stripper)
+			&& structured == outputs.structuredText;
+		int completedPages = 0;
+		std::string duplicateOf;
+		PageHash pageHash;
+		std::vector<float> inkCoverage;
+		int blankPages = 0;
+		std::vector<ManifestEntry> manifest;
+		std::string text;
+		std::string glyphText;
+		std::vector<TextGlyph> glyphs;
+		std::vector<std::pair<float, float>> pageSizes;
+		for (int pageIndex = 0; pageIndex < pageCount && result; pageIndex++) {
+			if (isCancelled(imageOptions.cancelToken)) {
+				result = false;
+				break;
+			}
+			float pageWidth = 0.0f;
+			float pageHeight = 0.0f;
+			if ((outputs.image || outputs.metadata || structured) && !m_Bridge->GetPageSize(env, document, pageIndex, &pageWidth, &pageHeight)) {
+				result = false;
+				break;
+			}
+			pageSizes.push_back(std::make_pair(pageWidth, pageHeight));
+			PageAnalysis analysis;
+			analysis.hash = options.duplicates ? &pageHash : nullptr;
+			analysis.manifest = imageOptions.autoCrop.enabled ? &manifest : nullptr;
+			if (outputs.image && !renderPage(env, renderer, pageIndex, pageWidth, pageHeight, targetPrefix, imageOptions, analysis)) {
+				result = false;
+				break;
+			}
+			if (outputs.image && options.duplicates) {
+				options.duplicates->AddPageHash(sourcePath, pageIndex, pageHash);
+			}
+			if (outputs.image && imageOptions.blankPages.detect) {
+				inkCoverage.push_back(analysis.inkCoverage);
+				blankPages += analysis.skipped ? 1 : 0;
+			}
+			if (stripper) {
+				text.clear();
+				result = m_Bridge->ExtractText(env, stripper, document, pageIndex, text);
+			}
+			if (result && outputs.text) {
+				result = options.textSink ? options.textSink(pageIndex, text) : fwrite(text.data(), 1, text.size(), textFile.get()) == text.size();
+			}
+			if (result && options.indexer) {
+				result = options.indexer->AddPage(sourcePath, pageIndex, text);
+			}
+			if (result && options.duplicates) {
+				options.duplicates->AddPageText(sourcePath, pageIndex, text);
+			}
+			if (result && structured) {
+				glyphText.clear();
+				result = m_Bridge->ExtractGlyphs(env, stripper, glyphs, glyphText, structuredText.Fonts())
+					&& structuredText.AddPage(pageWidth, pageHeight, glyphs, glyphText);
+			}
+			completedPages += result ? 1 : 0;
+			// 앞 페이지가 먼저 변환한 문서와 같으면 나머지 페이지는 만들지 않는다.
+			if (result && !(duplicateOf = matchDuplicatePrefix(options.duplicates, sourcePath, pageIndex, pageCount)).empty()) {
+				break;
+			}
+		}
+		if (result && outputs.metadata) {
+			result = writeMetadata(env, document, pageSizes, targetPrefix + ".json");
+		}
+		if (outputs.image && imageOptions.autoCrop.enabled) {
+			result = writeManifest(manifest, targetPrefix + "_pages.json") && result; // 중단되어도 쓴 페이지까지 남긴다.
+		}
+		if (result && structured) {
+			result = structuredText.Close();
+		}
+		if (stripper) {
+			env->DeleteLocalRef(stripper);
+		}
+		if (renderer) {
+			env->DeleteLocalRef(renderer);
+		}
+		_ASSERTE((result || isCancelled(imageOptions.cancelToken)) && "PDFBox::Convert() Failed");
+
+		reportMemory(convertResult, imageOptions.memory, scratch.Bytes());
+		m_Bridge->CloseDocument(env, document);
+		reportProgress(convertResult, pageCount, completedPages, imageOptions.cancelToken);
+		reportDuplicate(convertResult, options.duplicates, sourcePath, duplicateOf);
+		reportInkCoverage(convertResult, inkCoverage, blankPages);
+		return result;
+	}
+
+	void PDFBox::SetMemoryBudget(int64_t budgetBytes)
+	{
+		m_Admission.reset(budgetBytes > 0 ? new AdmissionController(budgetBytes) : nullptr);
+	}
+
+	int64_t PDFBox::PeakAdmittedMemory() const
+	{
+		return m_Admission ? m_Admission->Peak() : 0;
+	}
+
+	bool PDFBox::StartWorkers(int threads, size_t queueCapacity)
+	{
+		_ASSERTE(m_Env && !m_Workers && "m_Env is not Null, workers are not started");
+		if (!m_Env || m_Workers) {
+			return false;
+		}
+
+		// 작업자 스레드는 살아있는 동안 JavaVM 에 붙어 있으므로 변환마다 붙였다 떼는 비용이 없다.
+		JavaVM* javaVM = m_JavaVM;
+		auto onStart = [javaVM]() {
+			JNIEnv* env = nullptr;
+			javaVM->AttachCurrentThread(reinterpret_cast<void**>(&env), nullptr);
+		};
+		auto onStop = [javaVM]() {
+			javaVM->DetachCurrentThread();
+		};
+		m_Workers.reset(new WorkerPool());
+		if (!m_Workers->Start(threads, queueCapacity, onStart, onStop)) {
+			m_Workers.reset();
+			return false;
+		}
+		return true;
+	}
+
+	void PDFBox::StopWorkers()
+	{
+		if (m_Workers) {
+			m_Workers->Stop();
+			m_Workers.reset();
+		}
+	}
+
+	size_t PDFBox::PendingConversions() const
+	{
+		return m_Workers ? m_Workers->Pending() : 0;
+	}
+
+	std::future<ConvertResult> PDFBox::SubmitImage(const std::wstring& sourceFile, const std::wstring& targetDir, const ImageOptions& options, const AsyncOptions& asyncOptions /*= AsyncOptions()*/)
+	{
+		return submit([this, sourceFile, targetDir, options](ConvertResult* convertResult) -> bool {
+			return ToImage(sourceFile.c_str(), targetDir.c_str(), options, convertResult);
+		}, asyncOptions);
+	}
+
+	std::future<ConvertResult> PDFBox::SubmitText(const std::wstring& sourceFile, const std::wstring& targetDir, const TextOptions& options, const AsyncOptions& asyncOptions /*= AsyncOptions()*/)
+	{
+		return submit([this, sourceFile, targetDir, options](ConvertResult* convertResult) -> bool {
+			return ToText(sourceFile.c_str(), targetDir.c_str(), options, convertResult);
+		}, asyncOptions);
+	}
+
+	std::future<ConvertResult> PDFBox::submit(const std::function<bool(ConvertResult* convertResult)>& convert, const AsyncOptions& asyncOptions)
+	{
+		_ASSERTE(m_Workers && "StartWorkers() is not called");
+		if (!m_Workers) {
+			return std::future<ConvertResult>();
+		}
+
+		std::shared_ptr<std::promise<ConvertResult>> promise = std::make_shared<std::promise<ConvertResult>>();
+		std::future<ConvertResult> future = promise->get_future();
+		WorkerPool::Task task = [promise, convert, asyncOptions](bool run) {
+			ConvertResult convertResult;
+			if (run) {
+				convertResult.succeeded = convert(&convertResult);
+			} else {
+				convertResult.cancelled = true; // StopWorkers() 로 실행하지 못했다.
+			}
+			promise->set_value(convertResult);
+
+			if (asyncOptions.callback) {
+				if (asyncOptions.executor) {
+					const ConvertCallback callback = asyncOptions.callback;
+					asyncOptions.executor([callback, convertResult]() { callback(convertResult); });
+				} else {
+					asyncOptions.callback(convertResult);
+				}
+			}
+		};
+
+		const bool queued = asyncOptions.blockWhenFull ? m_Workers->Push(task) : m_Workers->TryPush(task);
+		if (!queued) {
+			return std::future<ConvertResult>();
+		}
+		return future;
+	}
+
+	bool PDFBox::ToPyramid(const wchar_t* sourceFile, const wchar_t* targetDir, const PyramidOptions& options, ConvertResult* convertResult /*= nullptr*/)
+	{
+		_ASSERTE(sourceFile && "sourceFile is not Null");
+		_ASSERTE(targetDir && "sourceFile is not Null");
+		_ASSERTE(m_Env && m_Bridge && "m_Env, m_Bridge is not Null");
+		_ASSERTE(options.dpi > 0 && options.tileSize > 0 && options.overlap >= 0 && options.overlap < options.tileSize && "invalid options");
+		if (!sourceFile || !targetDir || !m_Env || !m_Bridge
+			|| options.dpi <= 0 || options.tileSize <= 0 || options.overlap < 0 || options.overlap >= options.tileSize) {
+			return false;
+		}
+
+		// 작업 스레드마다 문서를 열고 페이지 전체를 렌더링한 뒤 C++ 쪽에 복사하므로 스레드 수만큼 예약한다.
+		MemoryEstimate estimate;
+		if (m_Admission) {
+			DocumentStructure structure;
+			ScanStructure(sourceFile, structure);
+			ImageOptions imageOptions;
+			imageOptions.dpi = options.dpi;
+			imageOptions.format = options.format == PixelFormat::Mono ? PixelFormat::Gray : options.format;
+			imageOptions.tileMode = TileMode::Never;
+			estimate = EstimateImageMemory(structure, imageOptions, true);
+			int threads = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+			if (structure.pageCount > 0) {
+				threads = std::min(threads, structure.pageCount);
+			}
+			threads = std::max(threads, 1);
+			estimate.documentBytes *= threads;
+			estimate.pageBytes *= 2 * threads;
+		}
+		AdmissionTicket ticket(m_Admission.get(), estimate.Total(), options.cancelToken.get());
+		if (isCancelled(options.cancelToken)) {
+			reportProgress(convertResult, -1, 0, options.cancelToken);
+			return false;
+		}
+
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env) {
+			return false;
+		}
+
+		const std::string sourcePath = _U2A(sourceFile);
+		const std::string targetPrefix = _U2A(targetDir) + removeExt(pathFindFilename(sourcePath));
+		const float dpi = static_cast<float>(options.dpi);
+		PixelFormat format = options.format;
+		if (format == PixelFormat::Default) {
+			format = PixelFormat::RGB;
+		} else if (format == PixelFormat::Mono) {
+			format = PixelFormat::Gray; // 축소 레벨은 어차피 그레이가 된다.
+		}
+
+		jobject document = m_Bridge->LoadDocument(env, sourcePath);
+		_ASSERTE(document && "m_Bridge->LoadDocument() Failed");
+		if (!document) {
+			return false;
+		}
+		const int pageCount = m_Bridge->GetPageCount(env, document);
+		if (pageCount <= 0) {
+			m_Bridge->CloseDocument(env, document);
+			return false;
+		}
+
+		// PDDocument 는 스레드에 안전하지 않으므로 작업 스레드마다 문서를 따로 연다.
+		// 페이지는 렌더링 비용이 제각각이므로 공유 카운터로 하나씩 가져간다.
+		std::atomic<int> nextPage(0);
+		std::atomic<int> completedPages(0);
+		std::atomic<bool> failed(false);
+		auto renderPages = [&](JNIEnv* env, jobject workerDocument) {
+			jobject renderer = m_Bridge->NewRenderer(env, workerDocument);
+			if (!renderer) {
+				failed = true;
+				return;
+			}
+			Bitmap page;
+			for (int pageIndex = nextPage++; pageIndex < pageCount && !failed; pageIndex = nextPage++) {
+				if (isCancelled(options.cancelToken)) {
+					failed = true;
+					break;
+				}
+				if (env->PushLocalFrame(16) != JNI_OK) {
+					failed = true;
+					break;
+				}
+				jobject image = m_Bridge->RenderImage(env, renderer, pageIndex, dpi, format);
+				bool result = image && m_Bridge->CopyPixels(env, image, format, page);
+				env->PopLocalFrame(nullptr); // 피라미드를 만드는 동안 자바 쪽 페이지 이미지를 붙잡지 않는다.
+
+				result = result && writePyramid(env, *m_Bridge, page, targetPrefix + "_" + std::to_string(pageIndex + 1), options);
+				if (!result) {
+					failed = true;
+				} else {
+					completedPages++;
+				}
+			}
+			env->DeleteLocalRef(renderer);
+		};
+
+		int threadCount = options.threads > 0 ? options.threads : static_cast<int>(std::thread::hardware_concurrency());
+		threadCount = std::max(std::min(threadCount, pageCount), 1);
+		std::vector<std::thread> workers;
+		for (int i = 1; i < threadCount; i++) {
+			workers.emplace_back([&]() {
+				ScopedJNIEnv scopedEnv(m_JavaVM);
+				JNIEnv* env = scopedEnv.Get();
+				jobject workerDocument = env ? m_Bridge->LoadDocument(env, sourcePath) : nullptr;
+				if (!workerDocument) {
+					failed = true;
+					return;
+				}
+				renderPages(env, workerDocument);
+				m_Bridge->CloseDocument(env, workerDocument);
+			});
+		}
+		renderPages(env, document);
+		for (std::thread& worker : workers) {
+			worker.join();
+		}
+
+		m_Bridge->CloseDocument(env, document);
+		reportProgress(convertResult, pageCount, completedPages, options.cancelToken);
+		return !failed;
+	}
+
+	bool PDFBox::ToImageProgressive(const wchar_t* sourceFile, const wchar_t* targetDir, const ProgressiveOptions& options, ConvertResult* convertResult /*= nullptr*/)
+	{
+		_ASSERTE(sourceFile && "sourceFile is not Null");
+		_ASSERTE(targetDir && "sourceFile is not Null");
+		_ASSERTE(m_Env && m_Bridge && "m_Env, m_Bridge is not Null");
+		_ASSERTE(options.previewDPI > 0 && options.dpi > 0 && "invalid options");
+		if (!sourceFile || !targetDir || !m_Env || !m_Bridge || options.previewDPI <= 0 || options.dpi <= 0) {
+			return false;
+		}
+
+		// 미리보기와 최종 렌더링이 문서를 따로 열고 동시에 한 페이지씩 렌더링한다.
+		MemoryEstimate estimate;
+		if (m_Admission) {
+			DocumentStructure structure;
+			ScanStructure(sourceFile, structure);
+			ImageOptions imageOptions;
+			imageOptions.dpi = options.dpi;
+			imageOptions.format = options.format;
+			imageOptions.tileMode = TileMode::Never;
+			estimate = EstimateImageMemory(structure, imageOptions, true);
+			imageOptions.dpi = options.previewDPI;
+			const MemoryEstimate preview = EstimateImageMemory(structure, imageOptions, true);
+			estimate.documentBytes += preview.documentBytes;
+			estimate.pageBytes += preview.pageBytes;
+		}
+		AdmissionTicket ticket(m_Admission.get(), estimate.Total(), options.cancelToken.get());
+		if (isCancelled(options.cancelToken)) {
+			reportProgress(convertResult, -1, 0, options.cancelToken);
+			return false;
+		}
+
+		ScopedJNIEnv scopedEnv(m_JavaVM);
+		JNIEnv* env = scopedEnv.Get();
+		if (!env) {
+			return false;
+		}
+
+		const std::string sourcePath = _U2A(sourceFile);
+		const std::string targetPrefix = _U2A(targetDir) + removeExt(pathFindFilename(sourcePath));
+		const PixelFormat format = options.format == PixelFormat::Default ? PixelFormat::RGB : options.format;
+		auto pageFileName = [&](int pageIndex) -> std::string {
+			return targetPrefix + "_" + std::to_string(pageIndex + 1) + ".png";
+		};
+
+		// 최종 렌더링은 미리보기가 끝난 페이지만 처리해서 미리보기가 최종 결과를 덮어쓰지 않게 한다.
+		std::mutex mutex;
+		std::condition_variable previewCondition;
+		int previewDone = 0;
+		int completedPages = 0; // 최종 렌더링을 마친 페이지 수
+		std::atomic<int> finalPageCount(-1);
+		std::atomic<bool> failed(false);
+
+		std::thread finalWorker([&]() {
+			lowerThreadPriority();
+			ScopedJNIEnv scopedEnv(m_JavaVM);
+			JNIEnv* env = scopedEnv.Get();
+			jobject document = env ? m_Bridge->LoadDocument(env, sourcePath) : nullptr;
+			jobject renderer = document ? m_Bridge->NewRenderer(env, document) : nullptr;
+			const int pageCount = renderer ? m_Bridge->GetPageCount(env, document) : -1;
+			finalPageCount = pageCount;
+			if (pageCount <= 0) {
+				failed = true;
+			}
+			for (int pageIndex = 0; pageIndex < pageCount; pageIndex++) {
+				{
+					std::unique_lock<std::mutex> lock(mutex);
+					previewCondition.wait(lock, [&]() { return previewDone > pageIndex; });
+				}
+				if (isCancelled(options.cancelToken)) {
+					failed = true;
+					break;
+				}
+
+				const std::string imageFile = pageFileName(pageIndex);
+				const std::string tempFile = imageFile + ".tmp";
+				jobject image = m_Bridge->RenderImage(env, renderer, pageIndex, static_cast<float>(options.dpi), format);
+				bool result = image && m_Bridge->WriteImage(env, image, tempFile) && replaceFile(tempFile, imageFile);
+				if (image) {
+					env->DeleteLocalRef(image);
+				}
+				if (!result) {
+					failed = true;
+					continue;
+				}
+				completedPages++;
+				if (options.callback) {
+					options.callback(RenderStage::Final, pageIndex, _A2U(imageFile));
+				}
+			}
+			if (renderer) {
+				env->DeleteLocalRef(renderer);
+			}
+			if (document) {
+				m_Bridge->CloseDocument(env, document);
+			}
+		});
+
+		// 미리보기 : 호출 스레드에서 보통 우선순위로 렌더링한다.
+		jobject document = m_Bridge->LoadDocument(env, sourcePath);
+		jobject renderer = document ? m_Bridge->NewRenderer(env, document) : nullptr;
+		const int pageCount = renderer ? m_Bridge->GetPageCount(env, document) : -1;
+		if (renderer && options.draftPreview) {
+			m_Bridge->SetDraftMode(env, renderer);
+		}
+		for (int pageIndex = 0; pageIndex < pageCount && !isCancelled(options.cancelToken); pageIndex++) {
+			const std::string imageFile = pageFileName(pageIndex);
+			jobject image = m_Bridge->RenderImage(env, renderer, pageIndex, static_cast<float>(options.previewDPI), format);
+			bool result = image && m_Bridge->WriteImage(env, image, imageFile);
+			if (image) {
+				env->DeleteLocalRef(image);
+			}
+			if (result && options.callback) {
+				options.callback(RenderStage::Preview, pageIndex, _A2U(imageFile));
+			}
+			{
+				std::lock_guard<std::mutex> lock(mutex);
+				previewDone = pageIndex + 1;
+			}
+			previewCondition.notify_one();
+		}
+		{
+			// 미리보기가 실패해도 최종 렌더링이 끝까지 진행되도록 한다.
+			std::lock_guard<std::mutex> lock(mutex);
+			previewDone = INT_MAX;
+		}
+		previewCondition.notify_one();
+		if (renderer) {
+			env->DeleteLocalRef(renderer);
+		}
+		if (document) {
+			m_Bridge->CloseDocument(env, document);
+		}
+
+		finalWorker.join();
+		reportProgress(convertResult, finalPageCount, completedPages, options.cancelToken);
+		return !failed;
+	}
+
+	bool PDFBox::moduleToImage(JNIEnv* env, const wchar_t* sourceFile, const wchar_t* targetDir, int dpi, ConvertResult* convertResult)
+	{
+		// PDFBoxModule 은 Initialize 에서 연 문서를 정적 상태로 들고 있으므로 호출을 직렬화한다.
+		std::lock_guard<std::mutex> lock(m_ModuleMutex);
+		jstring jsoureFile = env->NewStringUTF(_U2A(sourceFile).c_str());
+		jstring jtargetDir = env->NewStringUTF(_U2A(targetDir).c_str());
+
+		const int pageCount = moduleConvert(env, jsoureFile, jtargetDir, dpi);
+
+		env->DeleteLocalRef(jsoureFile);
+		env->DeleteLocalRef(jtargetDir);
+
+		reportProgress(convertResult, pageCount, std::max(pageCount, 0), nullptr);
+
+		return pageCount >= 0;
+	}
+
+	int PDFBox::moduleConvert(JNIEnv* env, jstring sourceFile, jstring targetDir, int dpi)
+	{
+		jboolean result = JNI_FALSE;
+		if (!m_Module->initialize(env, m_TargetClass, &result, sourceFile, targetDir) || !result) {
+			_ASSERTE(!"PDFModuleInitialize() Failed");
+			return -1;
+		}
+
+		jint pageCount = -1;
+		if (!m_Module->getPageCount(env, m_TargetClass, &pageCount) || pageCount == -1) {
+			return -1;
+		}
+
+		result = JNI_FALSE;
+		if (!m_Module->convertToImage(env, m_TargetClass, &result, sourceFile, targetDir, dpi) || !result) {
+			_ASSERTE(!"ConvertPDFToImage() Failed");
+			return -1;
+		}
+		return pageCount;
+	}
+
+	bool PDFBox::renderImages(JNIEnv* env, const wchar_t* sourceFile, const wchar_t* targetDir, const ImageOptions& options, ConvertResult* convertResult)
+	{
+		_ASSERTE(m_Bridge && "m_Bridge is not Null");
+		_ASSERTE(options.dpi > 0 && options.tileSize > 0 && "invalid options");
+		if (!m_Bridge || options.dpi <= 0 || options.tileSize <= 0) {
+			return false;
+		}
+
+		const std::string sourcePath = _U2A(sourceFile);
+		ScratchSpace scratch(options.memory);
+		jobject document = m_Bridge->LoadDocument(env, sourcePath, options.memory, scratch.Dir());
+		_ASSERTE(document && "m_Bridge->LoadDocument() Failed");
+		if (!document) {
+			return false;
+		}
+
+		bool result = false;
+		int completedPages = 0;
+		int pageCount = m_Bridge->GetPageCount(env, document);
+		jobject renderer = pageCount > 0 ? m_Bridge->NewRenderer(env, document) : nullptr;
+		std::string duplicateOf;
+		std::vector<float> inkCoverage;
+		int blankPages = 0;
+		if (renderer) {
+			const std::string targetPrefix = _U2A(targetDir) + removeExt(pathFindFilename(sourcePath));
+			PageHash pageHash;
+			std::vector<ManifestEntry> manifest;
+			result = true;
+			for (int pageIndex = 0; pageIndex < pageCount && result; pageIndex++) {
+				if (isCancelled(options.cancelToken)) {
+					result = false;
+					break;
+				}
+				// renderImageWithDPI() 와 동일한 방식으로 페이지 픽셀 크기를 계산한다.
+				float pageWidth = 0.0f;
+				float pageHeight = 0.0f;
+				PageAnalysis analysis;
+				analysis.hash = options.duplicates ? &pageHash : nullptr;
+				analysis.manifest = options.autoCrop.enabled ? &manifest : nullptr;
+				result = m_Bridge->GetPageSize(env, document, pageIndex, &pageWidth, &pageHeight)
+					&& renderPage(env, renderer, pageIndex, pageWidth, pageHeight, targetPrefix, options, analysis);
+				if (result && options.duplicates) {
+					options.duplicates->AddPageHash(sourcePath, pageIndex, pageHash);
+				}
+				if (result && options.blankPages.detect) {
+					inkCoverage.push_back(analysis.inkCoverage);
+					blankPages += analysis.skipped ? 1 : 0;
+				}
+				completedPages += result ? 1 : 0;
+				// 앞 페이지가 먼저 변환한 문서와 같으면 나머지 페이지는 렌더링하지 않는다.
+				if (result && !(duplicateOf = matchDuplicatePrefix(options.duplicates, sourcePath, pageIndex, pageCount)).empty()) {
+					break;
+				}
+			}
+			env->DeleteLocalRef(renderer);
+			if (options.autoCrop.enabled) {
+				result = writeManifest(manifest, targetPrefix + "_pages.json") && result; // 중단되어도 쓴 페이지까지 남긴다.
+			}
+		}
+		_ASSERTE((result || isCancelled(options.cancelToken)) && "PDFBox::renderImages() Failed");
+
+		reportMemory(convertResult, options.memory, scratch.Bytes());
+		m_Bridge->CloseDocument(env, document);
+		reportProgress(convertResult, pageCount, completedPages, options.cancelToken);
+		reportDuplicate(convertResult, options.duplicates, sourcePath, duplicateOf);
+		reportInkCoverage(convertResult, inkCoverage, blankPages);
+		return result;
+	}
+
+	bool PDFBox::extractText(JNIEnv* env, const wchar_t* sourceFile, const wchar_t* targetDir, const TextOptions& options, ConvertResult* convertResult)
+	{
+		const std::chrono::steady_clock::time_point budgetEnd = std::chrono::steady_clock::now() + options.budget.timeBudget;
+		const std::string sourcePath = _U2A(sourceFile);
+		ScratchSpace scratch(options.memory);
+		jobject document = m_Bridge->LoadDocument(env, sourcePath, options.memory, scratch.Dir());
+		_ASSERTE(document && "m_Bridge->LoadDocument() Failed");
+		if (!document) {
+			return false;
+		}
+
+		AutoFilePtr file;
+		if (!options.textSink) {
+			const std::string targetFile = _U2A(targetDir) + removeExt(pathFindFilename(sourcePath)) + ".txt";
+			file.reset(fopen(targetFile.c_str(), "wb"));
+		}
+		const int pageCount = m_Bridge->GetPageCount(env, document);
+		jobject stripper = ((file || options.textSink) && pageCount >= 0) ? m_Bridge->NewTextStripper(env) : nullptr;
+		bool result = stripper != nullptr;
+		int completedPages = 0;
+		size_t remainingCharacters = options.budget.maxCharacters;
+		bool truncated = false;
+		std::string duplicateOf;
+		std::string text;
+		for (int pageIndex = 0; pageIndex < pageCount && result && !truncated; pageIndex++) {
+			if (isCancelled(options.cancelToken)) {
+				result = false;
+				break;
+			}
+			// 한도에 닿으면 남은 페이지는 PDFBox 에 요청하지 않는다.
+			if ((options.budget.maxPages > 0 && pageIndex >= options.budget.maxPages)
+				|| (options.budget.maxCharacters > 0 && remainingCharacters == 0)
+				|| (options.budget.timeBudget.count() > 0 && std::chrono::steady_clock::now() >= budgetEnd)) {
+				truncated = true;
+				break;
+			}
+			// 페이지마다 파일에 써서 중단되더라도 완료한 페이지까지의 텍스트가 남는다.
+			text.clear();
+			result = m_Bridge->ExtractText(env, stripper, document, pageIndex, text);
+			if (result && options.budget.maxCharacters > 0) {
+				size_t characters = 0;
+				const size_t bytes = utf8Prefix(text, remainingCharacters, characters);
+				truncated = bytes < text.size();
+				text.resize(bytes);
+				remainingCharacters -= characters;
+			}
+			result = result
+				&& (options.textSink ? options.textSink(pageIndex, text) : fwrite(text.data(), 1, text.size(), file.get()) == text.size())
+				&& (!options.indexer || options.indexer->AddPage(sourcePath, pageIndex, text));
+			if (result && options.duplicates) {
+				options.duplicates->AddPageText(sourcePath, pageIndex, text);
+			}
+			completedPages += result ? 1 : 0;
+			if (result && !truncated && !(duplicateOf = matchDuplicatePrefix(options.duplicates, sourcePath, pageIndex, pageCount)).empty()) {
+				break; // 앞 페이지가 먼저 추출한 문서와 같다.
+			}
+		}
+		if (stripper) {
+			env->DeleteLocalRef(stripper);
+		}
+		_ASSERTE((result || isCancelled(options.cancelToken)) && "PDFBox::extractText() Failed");
+
+		reportMemory(convertResult, options.memory, scratch.Bytes());
+		m_Bridge->CloseDocument(env, document);
+		reportProgress(convertResult, pageCount, completedPages, options.cancelToken);
+		if (convertResult) {
+			convertResult->truncated = result && truncated;
+		}
+		reportDuplicate(convertResult, options.duplicates, sourcePath, duplicateOf);
+		return result;
+	}
+
+	bool PDFBox::renderPage(JNIEnv* env, _jobject* renderer, int pageIndex, float pageWidth, float pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis)
+	{
+		if (!options.variants.empty()) {
+			return renderVariants(env, renderer, pageIndex, pageWidth, pageHeight, targetPrefix, options, analysis);
+		}
+
+		// renderImageWithDPI() 와 동일한 방식으로 페이지 픽셀 크기를 계산한다.
+		const float dpi = static_cast<float>(options.dpi);
+		const int widthPx = std::max(static_cast<int>(std::floor(pageWidth * dpi / 72.0f)), 1);
+		const int heightPx = std::max(static_cast<int>(std::floor(pageHeight * dpi / 72.0f)), 1);
+		const int64_t pagePixels = static_cast<int64_t>(widthPx) * heightPx;
+
+		bool tiled = options.tileMode == TileMode::Always
+			|| (options.tileMode == TileMode::Auto && pagePixels > options.tilePixelThreshold);
+		if (tiled || options.tileSink) {
+			return renderTiles(env, renderer, pageIndex, widthPx, heightPx, targetPrefix, options, analysis);
+		}
+
+		PixelFormat format = options.format == PixelFormat::Default ? PixelFormat::RGB : options.format;
+		jobject image = m_Bridge->RenderImage(env, renderer, pageIndex, dpi, format);
+		if (!image) {
+			return false;
+		}
+		// PNG 는 Java 에서 인코딩하므로 픽셀을 분석할 때만 복사한다. 빈 페이지는 인코딩하지 않는다.
+		bool result = true;
+		int imageWidth = widthPx;
+		int imageHeight = heightPx;
+		if (analysis.hash || options.blankPages.detect || options.autoCrop.enabled) {
+			Bitmap bitmap;
+			result = m_Bridge->CopyPixels(env, image, format, bitmap);
+			if (result) {
+				analyzePage(bitmap, options, analysis);
+				imageWidth = bitmap.width;
+				imageHeight = bitmap.height;
+			}
+		}
+		if (result && !analysis.skipped) {
+			const std::string targetFile = targetPrefix + "_" + std::to_string(pageIndex + 1) + ".png";
+			if (options.autoCrop.enabled) {
+				// 잘라낸 영역만 인코딩한다.
+				result = m_Bridge->WriteSubimage(env, image, analysis.cropX, analysis.cropY, analysis.cropWidth, analysis.cropHeight, targetFile);
+			} else {
+				result = m_Bridge->WriteImage(env, image, targetFile);
+			}
+			if (result && analysis.manifest) {
+				const ManifestEntry entry = { pageIndex, pathFindFilename(targetFile), imageWidth, imageHeight,
+					analysis.cropX, analysis.cropY, analysis.cropWidth, analysis.cropHeight };
+				analysis.manifest->push_back(entry);
+			}
+		}
+		env->DeleteLocalRef(image);
+		return result;
+	}
+
+	void PDFBox::analyzePage(const Bitmap& page, const ImageOptions& options, PageAnalysis& analysis)
+	{
+		if (analysis.hash) {
+			PageHasher hasher(page.width, page.height);
+			hasher.AddPixels(page, 0, 0);
+			*analysis.hash = hasher.Finish();
+		}
+		if (options.blankPages.detect) {
+			const int64_t pixels = static_cast<int64_t>(page.width) * page.height;
+			analysis.inkCoverage = pixels > 0 ? static_cast<float>(static_cast<double>(CountInkPixels(page, options.blankPages.inkLevel)) / pixels) : 0.0f;
+			analysis.skipped = analysis.inkCoverage < options.blankPages.skipBelow;
+		}
+		analysis.cropX = 0;
+		analysis.cropY = 0;
+		analysis.cropWidth = page.width;
+		analysis.cropHeight = page.height;
+		int x = 0;
+		int y = 0;
+		int width = 0;
+		int height = 0;
+		if (options.autoCrop.enabled && FindContentBounds(page, options.autoCrop.inkLevel, x, y, width, height)) { // 내용이 없으면 자르지 않는다.
+			const int padding = std::max(options.autoCrop.padding, 0);
+			analysis.cropX = std::max(x - padding, 0);
+			analysis.cropY = std::max(y - padding, 0);
+			analysis.cropWidth = std::min(x + width + padding, page.width) - analysis.cropX;
+			analysis.cropHeight = std::min(y + height + padding, page.height) - analysis.cropY;
+		}
+	}
+
+	bool PDFBox::writeMetadata(JNIEnv* env, _jobject* document, const std::vector<std::pair<float, float>>& pageSizes, const std::string& targetFile)
+	{
+		std::vector<std::pair<std::string, std::string>> info;
+		m_Bridge->GetDocumentInfo(env, document, info); // 문서 정보가 없어도 페이지 정보는 쓴다.
+
+		AutoFilePtr file(fopen(targetFile.c_str(), "wb"));
+		if (!file) {
+			return false;
+		}
+		fprintf(file.get(), "{\n  \"pageCount\": %d,\n  \"info\": {", static_cast<int>(pageSizes.size()));
+		for (size_t i = 0; i < info.size(); i++) {
+			fprintf(file.get(), "%s\n    %s: %s", i ? "," : "", jsonString(info[i].first).c_str(), jsonString(info[i].second).c_str());
+		}
+		fprintf(file.get(), "%s},\n  \"pages\": [", info.empty() ? "" : "\n  ");
+		// main() 이 로케일을 바꾸므로 %f 대신 1/100 pt 정수로 소수점을 쓴다.
+		auto points = [](float value) -> std::string {
+			const long centi = std::lround(std::max(value, 0.0f) * 100.0f);
+			char text[32] = { 0, };
+			snprintf(text, sizeof(text), "%ld.%02ld", centi / 100, centi % 100);
+			return text;
+		};
+		for (size_t i = 0; i < pageSizes.size(); i++) {
+			fprintf(file.get(), "%s\n    { \"width\": %s, \"height\": %s }", i ? "," : "", points(pageSizes[i].first).c_str(), points(pageSizes[i].second).c_str());
+		}
+		fprintf(file.get(), "%s]\n}\n", pageSizes.empty() ? "" : "\n  ");
+		return ferror(file.get()) == 0;
+	}
+
+	bool PDFBox::writeManifest(const std::vector<ManifestEntry>& entries, const std::string& targetFile)
+	{
+		// 잘라낸 이미지의 좌표를 렌더링한 페이지 좌표로 되돌릴 수 있도록 픽셀 단위로 쓴다.
+		AutoFilePtr file(fopen(targetFile.c_str(), "wb"));
+		if (!file) {
+			return false;
+		}
+		fprintf(file.get(), "{\n  \"pages\": [");
+		for (size_t i = 0; i < entries.size(); i++) {
+			const ManifestEntry& entry = entries[i];
+			fprintf(file.get(), "%s\n    { \"page\": %d, \"file\": %s, \"width\": %d, \"height\": %d, \"x\": %d, \"y\": %d, \"cropWidth\": %d, \"cropHeight\": %d }",
+				i ? "," : "", entry.pageIndex + 1, jsonString(entry.file).c_str(), entry.pageWidth, entry.pageHeight, entry.x, entry.y, entry.width, entry.height);
+		}
+		fprintf(file.get(), "%s]\n}\n", entries.empty() ? "" : "\n  ");
+		return ferror(file.get()) == 0;
+	}
+
+	bool PDFBox::renderTiles(JNIEnv* env, _jobject* renderer, int pageIndex, int pageWidth, int pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis)
+	{
+		// 타일 하나 크기의 이미지를 재사용하므로 최대 메모리는 페이지가 아닌 타일 크기에 비례한다.
+		// 페이지 가장자리의 타일은 tileSize 보다 작을 수 있으며 그 크기의 이미지를 따로 만든다.
+		PixelFormat format = options.format == PixelFormat::Default ? PixelFormat::RGB : options.format;
+		const float dpi = static_cast<float>(options.dpi);
+		const int tileSize = options.tileSize;
+		const int rows = (pageHeight + tileSize - 1) / tileSize;
+		const int columns = (pageWidth + tileSize - 1) / tileSize;
+
+		jobject tileImage = nullptr;
+		int tileImageWidth = 0;
+		int tileImageHeight = 0;
+		Bitmap bitmap;
+		PageHasher hasher(pageWidth, pageHeight); // 타일마다 페이지 좌표로 모은다.
+		int64_t inkPixels = 0;
+		const bool analyze = analysis.hash || options.blankPages.detect;
+		bool result = true;
+		for (int row = 0; row < rows && result; row++) {
+			for (int column = 0; column < columns && result; column++) {
+				if (isCancelled(options.cancelToken)) {
+					result = false; // 큰 페이지는 타일 사이에서도 멈춘다.
+					break;
+				}
+				ImageTile tile;
+				tile.pageIndex = pageIndex;
+				tile.row = row;
+				tile.column = column;
+				tile.x = column * tileSize;
+				tile.y = row * tileSize;
+				tile.pageWidth = pageWidth;
+				tile.pageHeight = pageHeight;
+				const int tileWidth = std::min(tileSize, pageWidth - tile.x);
+				const int tileHeight = std::min(tileSize, pageHeight - tile.y);
+
+				if (!tileImage || tileImageWidth != tileWidth || tileImageHeight != tileHeight) {
+					if (tileImage) {
+						env->DeleteLocalRef(tileImage);
+					}
+					tileImage = m_Bridge->NewImage(env, tileWidth, tileHeight, format);
+					tileImageWidth = tileWidth;
+					tileImageHeight = tileHeight;
+					if (!tileImage) {
+						result = false;
+						break;
+					}
+				}
+
+				result = m_Bridge->RenderTile(env, renderer, tileImage, pageIndex, dpi, tile.x, tile.y, format);
+				if (!result) {
+					break;
+				}
+
+				if (options.tileSink || analyze) {
+					result = m_Bridge->CopyPixels(env, tileImage, format, bitmap);
+				}
+				if (result && analysis.hash) {
+					hasher.AddPixels(bitmap, tile.x, tile.y);
+				}
+				if (result && options.blankPages.detect) {
+					inkPixels += CountInkPixels(bitmap, options.blankPages.inkLevel);
+				}
+				if (!result) {
+					break;
+				} else if (options.tileSink) {
+					result = options.tileSink(tile, bitmap);
+				} else {
+					char tileName[64] = { 0, };
+					snprintf(tileName, sizeof(tileName), "_%d_r%d_c%d.png", pageIndex + 1, row, column);
+					result = m_Bridge->WriteImage(env, tileImage, targetPrefix + tileName);
+				}
+			}
+		}
+
+		if (tileImage) {
+			env->DeleteLocalRef(tileImage);
+		}
+		if (result && analysis.hash) {
+			*analysis.hash = hasher.Finish();
+		}
+		if (result && options.blankPages.detect) {
+			// 타일은 이미 썼으므로 빈 페이지라도 비율만 남긴다.
+			analysis.inkCoverage = static_cast<float>(static_cast<double>(inkPixels) / (static_cast<int64_t>(pageWidth) * pageHeight));
+		}
+		return result;
+	}
+
+	bool PDFBox::renderVariants(JNIEnv* env, _jobject* renderer, int pageIndex, float pageWidth, float pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis)
+	{
+		// 변형별 출력 크기를 구하고 가장 큰 변형의 해상도로 한번만 렌더링한다.
+		struct Target
+		{
+			int width;
+			int height;
+			std::string fileName;
+		};
+		std::vector<Target> targets;
+		float renderDPI = 0.0f;
+		const float longEdge = std::max(pageWidth, pageHeight);
+		for (const ImageVariant& variant : options.variants) {
+			_ASSERTE((variant.dpi > 0 || variant.maxSize > 0) && "invalid variant");
+			float variantDPI = 0.0f;
+			char suffix[32] = { 0, };
+			if (variant.dpi > 0) {
+				variantDPI = static_cast<float>(variant.dpi);
+				snprintf(suffix, sizeof(suffix), "_%d_%ddpi.png", pageIndex + 1, variant.dpi);
+			} else if (variant.maxSize > 0) {
+				variantDPI = variant.maxSize * 72.0f / longEdge;
+				snprintf(suffix, sizeof(suffix), "_%d_%dpx.png", pageIndex + 1, variant.maxSize);
+			} else {
+				return false;
+			}
+			Target target;
+			target.width = std::max(static_cast<int>(std::floor(pageWidth * variantDPI / 72.0f)), 1);
+			target.height = std::max(static_cast<int>(std::floor(pageHeight * variantDPI / 72.0f)), 1);
+			target.fileName = targetPrefix + suffix;
+			targets.push_back(target);
+			renderDPI = std::max(renderDPI, variantDPI);
+		}
+		std::sort(targets.begin(), targets.end(), [](const Target& a, const Target& b) {
+			return a.width * static_cast<int64_t>(a.height) > b.width * static_cast<int64_t>(b.height);
+		});
+
+		// Mono 는 축소하면 계조가 생기므로 그레이로 만든다.
+		PixelFormat format = options.format;
+		if (format == PixelFormat::Default) {
+			format = PixelFormat::RGB;
+		} else if (format == PixelFormat::Mono) {
+			format = PixelFormat::Gray;
+		}
+
+		jobject image = m_Bridge->RenderImage(env, renderer, pageIndex, renderDPI, format);
+		if (!image) {
+			return false;
+		}
+		Bitmap page;
+		bool result = m_Bridge->CopyPixels(env, image, format, page);
+		if (result) {
+			analyzePage(page, options, analysis);
+		}
+		if (analysis.skipped) {
+			targets.clear(); // 빈 페이지는 어떤 변형도 만들지 않는다.
+		}
+
+		// 2배 이상 줄일 때는 SIMD 절반 축소를 반복하고 남은 비율만 필터로 줄인다.
+		// 절반 축소한 비트맵은 다음(더 작은) 변형에서 다시 사용한다.
+		std::vector<Bitmap> mipmaps;
+		mipmaps.reserve(32); // source 포인터가 무효화되지 않도록 미리 잡는다. (2^32 픽셀 이상은 없다)
+		Bitmap resized;
+		for (size_t i = 0; i < targets.size() && result; i++) {
+			const Target& target = targets[i];
+			// 잘라낼 영역을 변형 크기에 맞게 바깥쪽으로 늘린다.
+			const double scaleX = static_cast<double>(target.width) / page.width;
+			const double scaleY = static_cast<double>(target.height) / page.height;
+			const int cropLeft = std::max(static_cast<int>(std::floor(analysis.cropX * scaleX)), 0);
+			const int cropTop = std::max(static_cast<int>(std::floor(analysis.cropY * scaleY)), 0);
+			const int cropRight = std::min(static_cast<int>(std::ceil((analysis.cropX + analysis.cropWidth) * scaleX)), target.width);
+			const int cropBottom = std::min(static_cast<int>(std::ceil((analysis.cropY + analysis.cropHeight) * scaleY)), target.height);
+			if (target.width == page.width && target.height == page.height) {
+				result = m_Bridge->WriteSubimage(env, image, cropLeft, cropTop, cropRight - cropLeft, cropBottom - cropTop, target.fileName);
+			} else {
+				const Bitmap* source = mipmaps.empty() ? &page : &mipmaps.back();
+				while (result && (source->width + 1) / 2 >= target.width && (source->height + 1) / 2 >= target.height) {
+					mipmaps.push_back(Bitmap());
+					result = HalveBitmap(*source, mipmaps.back());
+					source = &mipmaps.back();
+				}
+				if (!result) {
+					break;
+				}
+				if (source->width == target.width && source->height == target.height) {
+					result = m_Bridge->WriteBitmap(env, *source, cropLeft, cropTop, cropRight - cropLeft, cropBottom - cropTop, target.fileName);
+				} else {
+					result = ResizeBitmap(*source, target.width, target.height, options.variantFilter, resized)
+						&& m_Bridge->WriteBitmap(env, resized, cropLeft, cropTop, cropRight - cropLeft, cropBottom - cropTop, target.fileName);
+				}
+			}
+			if (result && analysis.manifest) {
+				const ManifestEntry entry = { pageIndex, pathFindFilename(target.fileName), target.width, target.height,
+					cropLeft, cropTop, cropRight - cropLeft, cropBottom - cropTop };
+				analysis.manifest->push_back(entry);
+			}
+		}
 
+		env->DeleteLocalRef(image);
 		return result;
 	}
 
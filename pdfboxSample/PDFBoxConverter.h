@@ -1,13 +1,304 @@
 ﻿// PDFBoxConverter.h
 #pragma once
+#include <memory> // std::unique_ptr, std::shared_ptr
+#include <vector> // std::vector
+#include <functional> // std::function
+#include <string> // std::string
+#include <utility> // std::pair
+#include <mutex> // std::mutex
+#include <future> // std::future
+#include <atomic> // std::atomic
+#include <chrono> // std::chrono
+#include <stdint.h> // int64_t
 
 struct JNIEnv_;
 struct JavaVM_;
+class _jobject;
 class _jclass;
-struct _jmethodID;
+class _jstring;
 
 namespace PDF { namespace Converter {
 
+	// 변환 취소 토큰. 다른 스레드에서 Cancel() 하거나 기한을 정할 수 있다.
+	// 변환은 페이지(타일) 사이에서 확인하므로 렌더링 중인 페이지(타일)가 끝나야 멈춘다.
+	class CancelToken
+	{
+	public:
+		CancelToken();
+
+	public:
+		void Cancel();
+		void SetDeadline(std::chrono::steady_clock::time_point deadline);
+		void SetTimeout(std::chrono::milliseconds timeout); // 지금부터 timeout 뒤를 기한으로 정한다.
+
+		bool IsCancelled() const; // Cancel() 되었거나 기한이 지났다.
+		bool DeadlineExceeded() const;
+
+	private:
+		CancelToken(const CancelToken&) = delete;
+		CancelToken& operator=(const CancelToken&) = delete;
+
+	private:
+		std::atomic<bool> m_Cancelled;
+		std::atomic<std::chrono::steady_clock::rep> m_Deadline; // steady_clock 틱, 0 = 기한 없음
+	}; // class CancelToken
+
+	// 변환 결과. 중단된 변환은 완료한 페이지까지의 출력이 남는다.
+	struct ConvertResult
+	{
+		int pageCount = -1;				// 알 수 없으면 -1
+		int completedPages = 0;			// 출력을 마친 페이지 수
+		bool cancelled = false;			// 토큰으로 중단했다.
+		bool deadlineExceeded = false;	// 중단 이유가 기한 초과이다.
+		bool succeeded = false;			// 비동기 변환의 반환값
+		bool rejected = false;			// 대기 큐가 가득 차서 실행하지 않았다. (co_await)
+		int64_t heapLimitBytes = -1;	// 문서 스트림에 허용한 힙 (MemoryOptions, -1 = 제한 없음)
+		int64_t scratchBytes = 0;		// 힙 대신 임시 파일에 쓴 크기
+		bool truncated = false;			// TextBudget 에 닿거나 중복이라 남은 페이지를 변환하지 않았다. (실패가 아니다)
+		bool duplicate = false;			// 앞 페이지가 먼저 변환한 문서와 같아 나머지를 건너뛰었다. (DuplicateOptions::probePages)
+		std::vector<float> inkCoverage;	// 변환한 페이지의 잉크 비율 0 ~ 1 (BlankPageOptions::detect)
+		int blankPages = 0;				// 잉크 비율이 skipBelow 미만이라 쓰지 않은 페이지 수
+	}; // struct ConvertResult
+
+	// PDFBox 가 파싱한 문서 스트림을 둘 곳 (org.apache.pdfbox.io.MemoryUsageSetting)
+	enum class MemoryPolicy
+	{
+		Default,	// PDFBox 기본값 (힙만 사용, 제한 없음). PDFBoxModule 기본 경로를 사용할 수 있다.
+		MainMemory,	// 힙만 사용, mainMemoryBytes 를 넘으면 실패
+		Mixed,		// 힙에 mainMemoryBytes 까지, 넘는 부분은 임시 파일
+		TempFile	// 임시 파일만 사용
+	}; // enum class MemoryPolicy
+
+	// Default 가 아니면 PDFBox 로 직접 변환한다. (PDFBoxModule 은 문서를 기본 설정으로 연다)
+	struct MemoryOptions
+	{
+		MemoryPolicy policy = MemoryPolicy::Default;
+		int64_t mainMemoryBytes = 64 * 1024 * 1024;	// MainMemory 는 0 이하이면 제한 없음
+		std::wstring scratchDir;					// 임시 파일 폴더. 비어 있으면 시스템 임시 폴더
+	}; // struct MemoryOptions
+
+	// 비동기 변환 완료 콜백과 콜백을 실행할 곳 (예: 서비스 이벤트 루프에 넣는 함수)
+	using ConvertCallback = std::function<void(const ConvertResult& convertResult)>;
+	using Executor = std::function<void(const std::function<void()>& task)>;
+
+	struct AsyncOptions
+	{
+		ConvertCallback callback;
+		Executor executor;			// 없으면 작업자 스레드에서 콜백을 호출한다.
+		bool blockWhenFull = false;	// 큐가 가득 찼을 때 false 면 바로 거절(무효한 future)하고 true 면 자리가 날 때까지 기다린다.
+	}; // struct AsyncOptions
+
+	// 이미지 변환 픽셀 포맷
+	enum class PixelFormat
+	{
+		Default,	// PDFBoxModule 기본 컬러 PNG
+		Gray,		// 8bit 그레이스케일
+		Mono,		// 1bit 흑백
+		RGB,		// 24bit 컬러
+		RGBA		// 32bit 컬러 + 알파
+	}; // enum class PixelFormat
+
+	// 페이지 타일 분할 렌더링 모드
+	enum class TileMode
+	{
+		Auto,		// 페이지 픽셀 수가 tilePixelThreshold 를 넘으면 타일로 분할
+		Never,
+		Always
+	}; // enum class TileMode
+
+	// C++ 로 전달되는 픽셀 버퍼
+	// Gray : 1byte, Mono : 1bit (MSB 우선, 1 = 흰색), RGB/RGBA : 4byte (리틀엔디언 0xAARRGGBB -> B, G, R, A)
+	struct Bitmap
+	{
+		int width = 0;
+		int height = 0;
+		int stride = 0; // 한 줄의 바이트 수
+		PixelFormat format = PixelFormat::Default;
+		std::vector<unsigned char> pixels;
+	}; // struct Bitmap
+
+	// 렌더링된 타일의 페이지 내 위치 (픽셀)
+	struct ImageTile
+	{
+		int pageIndex = 0;
+		int row = 0;
+		int column = 0;
+		int x = 0;
+		int y = 0;
+		int pageWidth = 0;
+		int pageHeight = 0;
+	}; // struct ImageTile
+
+	// false 를 반환하면 변환을 중단한다.
+	using TileSink = std::function<bool(const ImageTile& tile, const Bitmap& bitmap)>;
+
+	// 축소 필터
+	enum class ResampleFilter
+	{
+		Box,		// 영역 평균 (2배 축소는 SIMD)
+		Lanczos		// Lanczos3
+	}; // enum class ResampleFilter
+
+	// 한번 렌더링한 페이지에서 만들 해상도 변형. dpi 또는 긴 변의 픽셀 수 중 하나를 지정한다.
+	// <name>_<page>_<dpi>dpi.png, <name>_<page>_<maxSize>px.png 로 저장한다.
+	struct ImageVariant
+	{
+		int dpi = 0;
+		int maxSize = 0;
+	}; // struct ImageVariant
+
+	class DuplicateDetector;
+	struct PageHash;
+
+	// 빈 페이지(간지) 검출. 렌더링한 픽셀에서 잉크 비율을 잰다.
+	struct BlankPageOptions
+	{
+		bool detect = false;		// 페이지마다 잉크 비율을 ConvertResult::inkCoverage 에 남긴다.
+		int inkLevel = 160;			// 이보다 어두운 채널이 있는 픽셀을 잉크로 센다. (1 ~ 256)
+		double skipBelow = 0.0;		// 잉크 비율이 이 미만인 페이지는 PNG 를 만들지 않는다. (0 = 모두 쓴다) 타일로 나눈 페이지는 재기만 한다.
+	}; // struct BlankPageOptions
+
+	// 흰 여백 자르기. 렌더링한 픽셀에서 내용 영역을 찾아 그 영역만 PNG 로 쓰고 <name>_pages.json 에 위치를 남긴다.
+	// 페이지 좌표 = (잘라낸 이미지 좌표 + x, y) / 자르기 전 이미지 크기 * 페이지 크기. 타일로 나눈 페이지는 자르지 않는다.
+	struct AutoCropOptions
+	{
+		bool enabled = false;
+		int padding = 8;		// 내용 영역 둘레에 남길 픽셀 수 (페이지 밖으로는 넘지 않는다)
+		int inkLevel = 240;		// 이보다 어두운 채널이 있는 픽셀을 내용으로 본다. (1 ~ 256)
+	}; // struct AutoCropOptions
+
+	struct ImageOptions
+	{
+		int dpi = 96;
+		PixelFormat format = PixelFormat::Default;
+		TileMode tileMode = TileMode::Auto;
+		int tileSize = 2048; // 타일 한 변의 픽셀 수
+		int64_t tilePixelThreshold = 32 * 1024 * 1024; // Auto 모드 기준 페이지 픽셀 수
+		TileSink tileSink; // 지정하면 모든 페이지를 타일로 렌더링해서 파일 대신 C++ 로 전달한다.
+		std::vector<ImageVariant> variants; // 지정하면 가장 큰 변형으로 한번 렌더링하고 나머지는 축소해서 만든다. (타일 분할 안 함)
+		ResampleFilter variantFilter = ResampleFilter::Box;
+		std::shared_ptr<CancelToken> cancelToken; // 지정하면 Default 포맷도 PDFBox 로 직접 렌더링한다. (PDFBoxModule 은 중단할 수 없다)
+		MemoryOptions memory;
+		std::shared_ptr<DuplicateDetector> duplicates; // 지정하면 렌더링한 페이지의 지각 해시를 중복 검출에 넣는다. (PDFDuplicateDetector.h)
+		BlankPageOptions blankPages;
+		AutoCropOptions autoCrop;
+	}; // struct ImageOptions
+
+	// PDFBox::ToImage() 가 PDFBoxModule 로 변환하는지. 직접 렌더링(PDFBoxBridge)이 없으면 취소와 분석 옵션은 무시한다.
+	bool UsesModulePath(const ImageOptions& options, bool hasBridge);
+
+	class TextIndexer;
+
+	// 페이지 텍스트 (UTF-8). false 를 반환하면 변환을 중단한다.
+	using TextSink = std::function<bool(int pageIndex, const std::string& text)>;
+
+	// 미리보기, 분류용 텍스트 추출 한도. 하나라도 닿으면 남은 페이지는 PDFBox 로 읽지 않는다. (0 = 제한 없음)
+	struct TextBudget
+	{
+		int maxPages = 0;
+		size_t maxCharacters = 0;					// 글자(코드 포인트) 수. 넘는 페이지는 글자 경계에서 자른다.
+		std::chrono::milliseconds timeBudget{ 0 };	// 문서를 여는 시간부터 센다. 페이지 사이에서 확인한다.
+
+		bool Limited() const { return maxPages > 0 || maxCharacters > 0 || timeBudget.count() > 0; }
+	}; // struct TextBudget
+
+	struct TextOptions
+	{
+		std::shared_ptr<CancelToken> cancelToken; // 지정하면 PDFTextStripper 로 페이지씩 추출해서 <name>.txt 로 저장한다.
+		TextSink textSink; // 지정하면 페이지씩 추출해서 파일 대신 C++ 로 전달한다. (targetDir 는 사용하지 않는다)
+		MemoryOptions memory;
+		std::shared_ptr<TextIndexer> indexer; // 지정하면 페이지씩 추출한 텍스트를 색인에도 넣는다. (PDFTextIndex.h)
+		TextBudget budget; // 한도가 있으면 페이지씩 추출하다가 멈추고 ConvertResult::truncated 를 켠다.
+		std::shared_ptr<DuplicateDetector> duplicates; // 지정하면 페이지 텍스트의 MinHash 를 중복 검출에 넣는다.
+	}; // struct TextOptions
+
+	// Convert() 한번으로 만들 출력
+	struct ConvertOutputs
+	{
+		bool image = true;		// <name>_<page>.png (ImageOptions 의 타일, 변형을 따른다)
+		bool text = true;		// <name>.txt 또는 textSink
+		bool metadata = false;	// <name>.json : 페이지 수, 페이지 크기(pt), 문서 정보
+		bool structuredText = false; // <name>.stx : 줄, 단어, 글자 위치와 폰트 (StructuredTextReader 로 읽는다)
+	}; // struct ConvertOutputs
+
+	// 문서를 한번 열고 페이지마다 모든 출력을 만든다. image 의 cancelToken, memory 는 모든 출력에 적용된다.
+	struct ConvertOptions
+	{
+		ConvertOutputs outputs;
+		ImageOptions image;
+		TextSink textSink;
+		std::shared_ptr<TextIndexer> indexer; // 지정하면 출력에 관계없이 페이지 텍스트를 추출해서 색인에 넣는다.
+		std::shared_ptr<DuplicateDetector> duplicates; // 지정하면 페이지 텍스트와 (image 출력이면) 페이지 해시를 중복 검출에 넣는다.
+	}; // struct ConvertOptions
+
+	// DZI(Deep Zoom) 타일 피라미드 옵션
+	// 페이지마다 <name>_<page>.dzi 와 <name>_<page>_files/<level>/<column>_<row>.png 를 만든다.
+	struct PyramidOptions
+	{
+		int dpi = 300; // 최대 레벨 해상도
+		PixelFormat format = PixelFormat::RGB; // Mono 는 Gray 로, Default 는 RGB 로 렌더링한다.
+		int tileSize = 254;
+		int overlap = 1;
+		ResampleFilter filter = ResampleFilter::Box; // 하위 레벨 축소 필터
+		int threads = 0; // 페이지 병렬 처리 스레드 수, 0 이면 CPU 코어 수
+		std::shared_ptr<CancelToken> cancelToken;
+	}; // struct PyramidOptions
+
+	// 점진적 렌더링 단계
+	enum class RenderStage
+	{
+		Preview,	// 저해상도 빠른 렌더링
+		Final		// 최종 해상도, 미리보기 파일을 교체한다.
+	}; // enum class RenderStage
+
+	// Final 단계는 백그라운드 스레드에서 호출된다.
+	using RenderStageCallback = std::function<void(RenderStage stage, int pageIndex, const std::wstring& imageFile)>;
+
+	// 미리보기를 먼저 <name>_<page>.png 로 쓰고 낮은 우선순위 스레드에서 최종 해상도로 같은 파일을 교체한다.
+	struct ProgressiveOptions
+	{
+		int previewDPI = 48;
+		int dpi = 300;
+		PixelFormat format = PixelFormat::RGB; // Default 는 RGB 로 렌더링한다.
+		bool draftPreview = true; // 미리보기는 안티앨리어싱을 끄고 이미지 서브샘플링을 허용한다.
+		RenderStageCallback callback;
+		std::shared_ptr<CancelToken> cancelToken;
+	}; // struct ProgressiveOptions
+
+	// Init() 직후 JIT 컴파일이 끝날 때까지 같은 문서를 반복 변환한다. 결과는 파일로 쓰지 않는다.
+	struct WarmupOptions
+	{
+		std::vector<std::wstring> corpus;	// 비어 있으면 실행 파일 옆 samples/sample01.pdf
+		int dpi = 96;
+		int minIterations = 3;
+		int maxIterations = 30;
+		int stableIterations = 3;			// 마지막 stableIterations 번의 반복 시간 차이가
+		double tolerance = 0.1;				// 평균의 tolerance 배 안이면 안정된 것으로 본다.
+	}; // struct WarmupOptions
+
+	struct WarmupResult
+	{
+		int iterations = 0;
+		double seconds = 0.0;					// 워밍업 전체 시간
+		double firstIterationSeconds = 0.0;
+		double steadyIterationSeconds = 0.0;	// 마지막 stableIterations 번의 평균
+		bool stabilized = false;				// maxIterations 안에 안정되었는지
+	}; // struct WarmupResult
+
+	// JavaVM 생성 옵션
+	struct InitOptions
+	{
+		// PDFBox 폰트 캐시 (.pdfbox.cache) 폴더. 비어 있으면 PDFBox 기본값 (사용자 홈 폴더)
+		// 컨테이너처럼 홈 폴더가 매번 비는 환경에서는 이미지에 포함된 폴더를 지정하고 BuildFontCache() 로 미리 만든다.
+		std::wstring fontCacheDir;
+	}; // struct InitOptions
+
+	class PDFBoxBridge;
+	class AdmissionController;
+	class WorkerPool;
+
+	// Init() 이후 변환 함수는 여러 스레드에서 동시에 호출할 수 있다.
+	// PDFBoxModule 기본 경로는 모듈의 정적 상태를 공유하므로 한번에 하나씩 실행된다.
 	class PDFBox 
 	{
 	public:
@@ -16,20 +307,95 @@ namespace PDF { namespace Converter {
 
 	public:
 		bool Init();
+		bool Init(const InitOptions& options);
 		void Fini();
 
+		// 폰트 캐시가 JavaVM 생성 전에 이미 있었는지. 없으면 첫 변환에서 시스템 폰트를 검색한다.
+		bool FontCacheWarm() const { return m_FontCacheWarm; }
+		const std::wstring& FontCacheFile() const { return m_FontCacheFile; }
+		bool BuildFontCache(); // 시스템 폰트를 검색해서 폰트 캐시를 만든다. (이미 있으면 읽기만 한다)
+		// PDFBox 직접 경로의 렌더링과 텍스트 추출을 반복 시간이 안정될 때까지 실행한다.
+		// 변환이 하나라도 실패하거나 직접 경로를 쓸 수 없으면 (PDFBox 클래스 조회 실패) 반복하지 않고 false
+		bool WarmUp(const WarmupOptions& options, WarmupResult* result = nullptr);
+
+		// 동시 변환의 메모리 예산 (byte, 0 = 제한 없음). 변환을 호출하기 전에 설정한다.
+		// 예산을 넘는 변환은 대기하고, 한 페이지가 예산을 넘으면 타일로 나눠 렌더링한다.
+		void SetMemoryBudget(int64_t budgetBytes);
+		int64_t PeakAdmittedMemory() const;
+
 	public:
-		bool ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, int dpi = 96);
+		bool ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, int dpi = 96, PixelFormat format = PixelFormat::Default);
+		// 취소되거나 기한이 지나면 false 를 반환하고 result 에 완료한 페이지 수를 남긴다.
+		bool ToImage(const wchar_t* sourceFile, const wchar_t* targetDir, const ImageOptions& options, ConvertResult* result = nullptr);
 		bool ToText(const wchar_t* sourceFile, const wchar_t* targetDir);
+		bool ToText(const wchar_t* sourceFile, const wchar_t* targetDir, const TextOptions& options, ConvertResult* result = nullptr);
+		// 이미지와 텍스트를 따로 변환하면 문서를 두번 읽고 파싱한다. 항상 PDFBox 로 직접 변환한다.
+		bool Convert(const wchar_t* sourceFile, const wchar_t* targetDir, const ConvertOptions& options, ConvertResult* result = nullptr);
+		bool ToPyramid(const wchar_t* sourceFile, const wchar_t* targetDir, const PyramidOptions& options, ConvertResult* result = nullptr);
+		bool ToImageProgressive(const wchar_t* sourceFile, const wchar_t* targetDir, const ProgressiveOptions& options, ConvertResult* result = nullptr);
+
+	public:
+		// 비동기 변환 : JavaVM 에 붙어있는 작업자 스레드 threads 개와 최대 queueCapacity 개의 대기 큐를 만든다.
+		bool StartWorkers(int threads, size_t queueCapacity);
+		void StopWorkers(); // 실행 중인 변환을 기다리고 대기 중인 변환은 cancelled 로 끝낸다. Fini() 에서도 호출한다.
+		size_t PendingConversions() const;
+
+		// 큐가 가득 차서 거절되면 valid() 가 false 인 future 를 반환한다.
+		std::future<ConvertResult> SubmitImage(const std::wstring& sourceFile, const std::wstring& targetDir, const ImageOptions& options, const AsyncOptions& asyncOptions = AsyncOptions());
+		std::future<ConvertResult> SubmitText(const std::wstring& sourceFile, const std::wstring& targetDir, const TextOptions& options, const AsyncOptions& asyncOptions = AsyncOptions());
+
+	private:
+		std::future<ConvertResult> submit(const std::function<bool(ConvertResult* convertResult)>& convert, const AsyncOptions& asyncOptions);
+		bool moduleToImage(JNIEnv_* env, const wchar_t* sourceFile, const wchar_t* targetDir, int dpi, ConvertResult* convertResult);
+		int moduleConvert(JNIEnv_* env, _jstring* sourceFile, _jstring* targetDir, int dpi); // m_ModuleMutex 를 잡고 호출한다. 실패하면 -1
+		bool renderImages(JNIEnv_* env, const wchar_t* sourceFile, const wchar_t* targetDir, const ImageOptions& options, ConvertResult* convertResult);
+		bool extractText(JNIEnv_* env, const wchar_t* sourceFile, const wchar_t* targetDir, const TextOptions& options, ConvertResult* convertResult);
+		// 페이지 목록(<name>_pages.json)의 이미지 한 개. 잘라낸 이미지의 (0, 0) 은 자르기 전 이미지의 (x, y) 이다.
+		struct ManifestEntry
+		{
+			int pageIndex;
+			std::string file;	// 파일 이름 (폴더 제외)
+			int pageWidth;		// 자르기 전 이미지 크기 (픽셀)
+			int pageHeight;
+			int x;
+			int y;
+			int width;			// 잘라낸 크기
+			int height;
+		}; // struct ManifestEntry
+
+		// renderPage() 가 렌더링한 픽셀로 구하는 값
+		struct PageAnalysis
+		{
+			PageHash* hash = nullptr;	// 지정하면 지각 해시를 남긴다. (DuplicateDetector)
+			float inkCoverage = -1.0f;	// ImageOptions::blankPages.detect 이면 잉크 비율
+			bool skipped = false;		// 빈 페이지라 파일을 쓰지 않았다.
+			int cropX = 0;				// ImageOptions::autoCrop 이면 렌더링 픽셀 기준 자를 영역 (padding 포함)
+			int cropY = 0;
+			int cropWidth = 0;
+			int cropHeight = 0;
+			std::vector<ManifestEntry>* manifest = nullptr; // 지정하면 쓴 이미지를 덧붙인다.
+		}; // struct PageAnalysis
+
+		bool renderPage(JNIEnv_* env, _jobject* renderer, int pageIndex, float pageWidth, float pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis);
+		void analyzePage(const Bitmap& page, const ImageOptions& options, PageAnalysis& analysis); // 전체 페이지 픽셀
+		bool writeMetadata(JNIEnv_* env, _jobject* document, const std::vector<std::pair<float, float>>& pageSizes, const std::string& targetFile);
+		bool writeManifest(const std::vector<ManifestEntry>& entries, const std::string& targetFile);
+		bool renderTiles(JNIEnv_* env, _jobject* renderer, int pageIndex, int pageWidth, int pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis);
+		bool renderVariants(JNIEnv_* env, _jobject* renderer, int pageIndex, float pageWidth, float pageHeight, const std::string& targetPrefix, const ImageOptions& options, PageAnalysis& analysis);
 
 	private:
 		JNIEnv_*	m_Env;
 		JavaVM_*	m_JavaVM;
-		_jclass*	m_TargetClass;
-		_jmethodID*	m_PDFToImageMethodID;
-		_jmethodID*	m_PDFToTextMethodID;
-		_jmethodID*	m_InitializeMethodID;
-		_jmethodID*	m_GetPageCountMethodID;
+		_jclass*	m_TargetClass; // 전역 참조
+		struct ModuleMethods;
+		std::unique_ptr<ModuleMethods> m_Module; // PDFBoxModule 정적 메소드
+		std::unique_ptr<PDFBoxBridge> m_Bridge;
+		std::mutex	m_ModuleMutex; // PDFBoxModule 호출 직렬화
+		std::unique_ptr<AdmissionController> m_Admission;
+		std::unique_ptr<WorkerPool> m_Workers;
+		std::wstring m_ModuleDir; // PDFBoxModule.jar 가 있는 실행 파일 폴더
+		std::wstring m_FontCacheFile;
+		bool		m_FontCacheWarm;
 	}; // class PDFBox
 
 }} // PDF::Converter
@@ -0,0 +1,73 @@
+﻿// PDFCoroutine.h
+#pragma once
+#include "PDFBoxConverter.h"
+
+// C++20 코루틴을 지원하는 컴파일러에서만 사용할 수 있다. (gcc -std=c++20, msvc /std:c++20)
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine> // std::coroutine_handle
+#include <string> // std::wstring
+#include <utility> // std::move
+
+namespace PDF { namespace Converter {
+
+	// co_await 하면 PDFBox 작업자 스레드에서 변환하고 executor 에서 코루틴을 재개한다.
+	// executor 가 없으면 작업자 스레드에서 재개한다. PDFBox::StartWorkers() 이후에 사용한다.
+	// 대기 큐가 가득 차면 일시 중단하지 않고 rejected 인 결과를 바로 돌려준다.
+	class ConvertAwaitable
+	{
+	public:
+		using Submit = std::function<std::future<ConvertResult>(const AsyncOptions& asyncOptions)>;
+
+	public:
+		ConvertAwaitable(Submit submit, Executor executor)
+		: m_Submit(std::move(submit))
+		, m_Executor(std::move(executor))
+		{
+		}
+
+	public:
+		bool await_ready() const noexcept { return false; }
+
+		bool await_suspend(std::coroutine_handle<> handle)
+		{
+			AsyncOptions asyncOptions;
+			asyncOptions.executor = m_Executor;
+			asyncOptions.callback = [this, handle](const ConvertResult& convertResult) {
+				m_Result = convertResult;
+				handle.resume();
+			};
+			// 제출하자마자 다른 스레드에서 재개되어 이 객체가 사라질 수 있으므로 멤버를 쓰지 않고 호출한다.
+			Submit submit = std::move(m_Submit);
+			if (!submit(asyncOptions).valid()) {
+				m_Result.rejected = true;
+				return false;
+			}
+			return true;
+		}
+
+		ConvertResult await_resume() const { return m_Result; }
+
+	private:
+		Submit m_Submit;
+		Executor m_Executor;
+		ConvertResult m_Result;
+	}; // class ConvertAwaitable
+
+	// ConvertResult result = co_await AwaitImage(pdfBox, sourceFile, targetDir, options, executor);
+	inline ConvertAwaitable AwaitImage(PDFBox& pdfBox, const std::wstring& sourceFile, const std::wstring& targetDir, const ImageOptions& options, Executor executor = Executor())
+	{
+		return ConvertAwaitable([&pdfBox, sourceFile, targetDir, options](const AsyncOptions& asyncOptions) {
+			return pdfBox.SubmitImage(sourceFile, targetDir, options, asyncOptions);
+		}, std::move(executor));
+	}
+
+	inline ConvertAwaitable AwaitText(PDFBox& pdfBox, const std::wstring& sourceFile, const std::wstring& targetDir, const TextOptions& options, Executor executor = Executor())
+	{
+		return ConvertAwaitable([&pdfBox, sourceFile, targetDir, options](const AsyncOptions& asyncOptions) {
+			return pdfBox.SubmitText(sourceFile, targetDir, options, asyncOptions);
+		}, std::move(executor));
+	}
+
+}} // PDF::Converter
+
+#endif // __cpp_impl_coroutine
@@ -0,0 +1,75 @@
+﻿// PDFCoroutineSample.cpp
+// PDFCoroutine.h 사용 예 : 한 문서를 co_await 로 PNG, TXT 변환한다.
+//   pdfboxCoroutineSample <PDF 파일> <결과 폴더>
+// CMake 옵션 PDFBOX_COROUTINE_SAMPLE 을 켜면 C++20 으로 빌드한다.
+#include "PDFCoroutine.h"
+#include <string> // std::wstring
+#include <iostream> // std::cout
+#include <future> // std::promise
+#include <exception> // std::terminate
+#include "pdf_utils.h"
+
+#if !defined(__cpp_impl_coroutine) || __cpp_impl_coroutine < 201902L
+#error "PDFCoroutineSample.cpp needs C++20 coroutines (gcc -std=c++20, msvc /std:c++20)"
+#endif
+
+namespace {
+
+	// 결과를 돌려주지 않는 코루틴. 끝까지 실행되면 프레임이 스스로 해제된다.
+	struct DetachedTask
+	{
+		struct promise_type
+		{
+			DetachedTask get_return_object() noexcept { return DetachedTask(); }
+			std::suspend_never initial_suspend() noexcept { return {}; }
+			std::suspend_never final_suspend() noexcept { return {}; }
+			void return_void() noexcept {}
+			void unhandled_exception() noexcept { std::terminate(); }
+		}; // struct promise_type
+	}; // struct DetachedTask
+
+	void printResult(const char* type, const PDF::Converter::ConvertResult& convertResult)
+	{
+		std::cout << "    " << type << " : " << (convertResult.rejected ? "Rejected" : (convertResult.succeeded ? "done" : "Failed"))
+			<< " (" << convertResult.completedPages << "/" << convertResult.pageCount << " pages)" << std::endl;
+	}
+
+	// executor 가 없으므로 co_await 다음 줄부터는 PDFBox 작업자 스레드에서 실행된다.
+	DetachedTask convert(PDF::Converter::PDFBox& pdfBox, std::wstring sourceFile, std::wstring targetDir, std::promise<bool>& done)
+	{
+		const PDF::Converter::ConvertResult image = co_await PDF::Converter::AwaitImage(pdfBox, sourceFile, targetDir, PDF::Converter::ImageOptions());
+		printResult("png", image);
+		const PDF::Converter::ConvertResult text = co_await PDF::Converter::AwaitText(pdfBox, sourceFile, targetDir, PDF::Converter::TextOptions());
+		printResult("txt", text);
+		done.set_value(image.succeeded && text.succeeded);
+	}
+}
+
+int main(int argc, char* argv[])
+{
+	setlocale(LC_ALL, "");
+	if (argc < 3) {
+		std::cerr << "usage : pdfboxCoroutineSample <source pdf> <result dir>" << std::endl;
+		return 0;
+	}
+
+	PDF::Converter::PDFBox pdfBox;
+	if (!pdfBox.Init()) {
+		std::cerr << "PDFBox Init() Failed()" << std::endl;
+		return 0;
+	}
+	if (!pdfBox.StartWorkers(1, 2)) {
+		std::cerr << "PDFBox StartWorkers() Failed()" << std::endl;
+		pdfBox.Fini();
+		return 0;
+	}
+
+	std::promise<bool> done;
+	std::future<bool> finished = done.get_future();
+	convert(pdfBox, _A2U(argv[1]), _A2U(pathAddSeparator(argv[2])), done);
+	const bool result = finished.get();
+	std::cout << "    co_await : " << (result ? "done" : "Failed") << std::endl;
+
+	pdfBox.Fini();
+	return 0;
+}
@@ -0,0 +1,394 @@
+﻿// PDFDuplicateDetector.cpp
+#include "PDFDuplicateDetector.h"
+#include <algorithm> // std::min, std::find, std::rotate
+#include <map> // std::map
+#include <utility> // std::move
+#include <stdio.h> // fopen
+#include "PDFTextIndex.h"
+#include "pdf_assert.h"
+#include "pdf_utils.h"
+
+static const int LSH_BANDS = 16;	// TextSignature::HASH_COUNT 를 나눈 묶음 수
+static const int LSH_ROWS = 4;		// 묶음 하나의 해시 수
+
+namespace {
+
+	// splitmix64 마무리 함수
+	uint64_t mix64(uint64_t value)
+	{
+		value ^= value >> 30;
+		value *= 0xBF58476D1CE4E5B9ull;
+		value ^= value >> 27;
+		value *= 0x94D049BB133111EBull;
+		value ^= value >> 31;
+		return value;
+	}
+
+	uint64_t hashToken(const std::string& token)
+	{
+		uint64_t hash = 0xCBF29CE484222325ull; // FNV-1a
+		for (const char c : token) {
+			hash = (hash ^ static_cast<unsigned char>(c)) * 0x100000001B3ull;
+		}
+		return hash;
+	}
+
+	int popCount(uint64_t value)
+	{
+		int count = 0;
+		for (; value; value &= value - 1) {
+			count++;
+		}
+		return count;
+	}
+
+} // namespace
+
+namespace PDF { namespace Converter {
+
+	void TextSignature::Add(const std::string& text)
+	{
+		auto addShingle = [this](uint64_t shingle) {
+			for (int i = 0; i < HASH_COUNT; i++) {
+				// 해시 함수마다 다른 시드를 섞는다.
+				const uint32_t value = static_cast<uint32_t>(mix64(shingle + (i + 1) * 0x9E3779B97F4A7C15ull) >> 32);
+				minHash[i] = std::min(minHash[i], value);
+			}
+			shingleCount++;
+		};
+		// 직전 두 색인어의 해시와 이어서 색인어 3개짜리 싱글을 만든다.
+		uint64_t previous[2] = { 0, 0 };
+		int tokenCount = 0;
+		TokenizeText(text, [&](const std::string& token) {
+			const uint64_t hash = hashToken(token);
+			if (tokenCount >= 2) {
+				addShingle(mix64(previous[0] ^ mix64(previous[1] ^ mix64(hash))));
+			}
+			previous[0] = previous[1];
+			previous[1] = hash;
+			tokenCount++;
+		});
+		if (tokenCount == 1 || tokenCount == 2) {
+			addShingle(mix64(mix64(previous[0] ^ mix64(previous[1])))); // 색인어가 3개보다 적은 페이지
+		}
+	}
+
+	void TextSignature::Merge(const TextSignature& other)
+	{
+		for (int i = 0; i < HASH_COUNT; i++) {
+			minHash[i] = std::min(minHash[i], other.minHash[i]);
+		}
+		shingleCount += other.shingleCount;
+	}
+
+	double TextSignature::Similarity(const TextSignature& other) const
+	{
+		if (shingleCount == 0 || other.shingleCount == 0) {
+			return 0.0;
+		}
+		int equal = 0;
+		for (int i = 0; i < HASH_COUNT; i++) {
+			equal += minHash[i] == other.minHash[i] ? 1 : 0;
+		}
+		return static_cast<double>(equal) / HASH_COUNT;
+	}
+
+	int PageHash::Distance(const PageHash& other) const
+	{
+		int distance = 0;
+		for (size_t i = 0; i < bits.size(); i++) {
+			distance += popCount(bits[i] ^ other.bits[i]);
+		}
+		return distance;
+	}
+
+	PageHasher::PageHasher(int pageWidth, int pageHeight)
+	: m_PageWidth(pageWidth)
+	, m_PageHeight(pageHeight)
+	{
+		m_Sums.fill(0);
+		m_Counts.fill(0);
+	}
+
+	void PageHasher::AddPixels(const Bitmap& bitmap, int x, int y)
+	{
+		_ASSERTE(bitmap.format != PixelFormat::Default && "unsupported bitmap");
+		if (m_PageWidth <= 0 || m_PageHeight <= 0 || bitmap.format == PixelFormat::Default) {
+			return;
+		}
+		// 열마다 칸 번호를 미리 구해서 픽셀마다 나눗셈하지 않는다.
+		std::vector<int> columnCells(bitmap.width);
+		for (int column = 0; column < bitmap.width; column++) {
+			columnCells[column] = std::min((x + column) * GRID / m_PageWidth, GRID - 1);
+		}
+		for (int row = 0; row < bitmap.height; row++) {
+			const int cellRow = std::min((y + row) * GRID / m_PageHeight, GRID - 1);
+			const unsigned char* line = bitmap.pixels.data() + static_cast<size_t>(row) * bitmap.stride;
+			uint64_t* sums = &m_Sums[cellRow * GRID];
+			uint64_t* counts = &m_Counts[cellRow * GRID];
+			for (int column = 0; column < bitmap.width; column++) {
+				unsigned int luminance = 0;
+				if (bitmap.format == PixelFormat::Gray) {
+					luminance = line[column];
+				} else if (bitmap.format == PixelFormat::Mono) {
+					luminance = ((line[column >> 3] >> (7 - (column & 7))) & 1) ? 255 : 0; // 1 = 흰색
+				} else {
+					const unsigned char* pixel = line + column * 4; // B, G, R, A
+					luminance = (pixel[2] * 77 + pixel[1] * 150 + pixel[0] * 29) >> 8;
+					if (bitmap.format == PixelFormat::RGBA) {
+						luminance = (luminance * pixel[3] + 255 * (255 - pixel[3])) / 255; // 투명한 배경은 흰색
+					}
+				}
+				sums[columnCells[column]] += luminance;
+				counts[columnCells[column]]++;
+			}
+		}
+	}
+
+	PageHash PageHasher::Finish() const
+	{
+		// 픽셀이 없는 칸(페이지보다 작은 렌더링)은 흰색으로 본다.
+		uint64_t means[GRID * GRID];
+		uint64_t total = 0;
+		for (int cell = 0; cell < GRID * GRID; cell++) {
+			means[cell] = m_Counts[cell] ? m_Sums[cell] / m_Counts[cell] : 255;
+			total += means[cell];
+		}
+		const uint64_t average = total / (GRID * GRID);
+		PageHash hash;
+		for (int cell = 0; cell < GRID * GRID; cell++) {
+			if (means[cell] < average) {
+				hash.bits[cell / 64] |= 1ull << (cell % 64);
+			}
+		}
+		return hash;
+	}
+
+	struct DuplicateDetector::Document
+	{
+		std::string sourceFile;
+		TextSignature text;
+		TextSignature prefixText;		// 앞 probePages 페이지
+		std::vector<PageHash> pages;	// 페이지 번호 순서
+		std::vector<bool> hashed;		// pages 의 값이 있다.
+		std::string duplicateOf;
+		bool finished = false;
+	}; // struct DuplicateDetector::Document
+
+	DuplicateDetector::DuplicateDetector(const DuplicateOptions& options /*= DuplicateOptions()*/)
+	: m_Options(options)
+	{
+	}
+
+	DuplicateDetector::~DuplicateDetector()
+	{
+	}
+
+	DuplicateDetector::Document& DuplicateDetector::document(const std::string& sourceFile)
+	{
+		std::unique_ptr<Document>& document = m_Documents[sourceFile];
+		if (!document) {
+			document.reset(new Document());
+			document->sourceFile = sourceFile;
+		}
+		return *document;
+	}
+
+	void DuplicateDetector::AddPageText(const std::string& sourceFile, int pageIndex, const std::string& text)
+	{
+		// 해시는 잠금 밖에서 계산하고 페이지 서명만 합친다.
+		TextSignature page;
+		page.Add(text);
+
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Document& current = document(sourceFile);
+		current.text.Merge(page);
+		if (pageIndex < m_Options.probePages) {
+			current.prefixText.Merge(page);
+		}
+	}
+
+	void DuplicateDetector::AddPageHash(const std::string& sourceFile, int pageIndex, const PageHash& hash)
+	{
+		_ASSERTE(pageIndex >= 0 && "invalid pageIndex");
+		if (pageIndex < 0) {
+			return;
+		}
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Document& current = document(sourceFile);
+		if (current.pages.size() <= static_cast<size_t>(pageIndex)) {
+			current.pages.resize(pageIndex + 1);
+			current.hashed.resize(pageIndex + 1, false);
+		}
+		current.pages[pageIndex] = hash;
+		current.hashed[pageIndex] = true;
+	}
+
+	bool DuplicateDetector::similar(const Document& a, const Document& b, bool prefix) const
+	{
+		const TextSignature& textA = prefix ? a.prefixText : a.text;
+		const TextSignature& textB = prefix ? b.prefixText : b.text;
+		if (textA.shingleCount > 0 || textB.shingleCount > 0) {
+			return textA.Similarity(textB) >= m_Options.textSimilarity; // 한쪽만 텍스트가 있으면 다른 문서
+		}
+		// 텍스트가 없으면 (스캔 문서) 페이지 해시를 비교한다.
+		const size_t pageCount = prefix ? static_cast<size_t>(m_Options.probePages) : a.pages.size();
+		if (pageCount == 0 || a.pages.size() < pageCount || b.pages.size() < pageCount || (!prefix && a.pages.size() != b.pages.size())) {
+			return false;
+		}
+		for (size_t i = 0; i < pageCount; i++) {
+			if (!a.hashed[i] || !b.hashed[i] || a.pages[i].Distance(b.pages[i]) > m_Options.pageDistance) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	std::string DuplicateDetector::MatchPrefix(const std::string& sourceFile)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Document& current = document(sourceFile);
+		for (const Document* probed : m_Probed) {
+			if (probed != &current && similar(current, *probed, true)) {
+				return probed->sourceFile;
+			}
+		}
+		m_Probed.push_back(&current); // 원본만 다음 문서의 비교 대상으로 남긴다.
+		return "";
+	}
+
+	void DuplicateDetector::Finish(const std::string& sourceFile, const std::string& duplicateOf)
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		Document& current = document(sourceFile);
+		current.duplicateOf = duplicateOf;
+		if (!current.finished) {
+			current.finished = true;
+			m_Finished.push_back(&current);
+		}
+	}
+
+	std::vector<DuplicateCluster> DuplicateDetector::Clusters() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		const size_t documentCount = m_Finished.size();
+		std::unordered_map<const Document*, size_t> orders;
+		for (size_t i = 0; i < documentCount; i++) {
+			orders[m_Finished[i]] = i;
+		}
+
+		// 작은 번호(먼저 끝난 문서)를 뿌리로 합친다.
+		std::vector<size_t> parents(documentCount);
+		for (size_t i = 0; i < documentCount; i++) {
+			parents[i] = i;
+		}
+		auto find = [&](size_t i) -> size_t {
+			while (parents[i] != i) {
+				parents[i] = parents[parents[i]];
+				i = parents[i];
+			}
+			return i;
+		};
+		auto unite = [&](size_t a, size_t b) {
+			a = find(a);
+			b = find(b);
+			if (a != b) {
+				parents[std::max(a, b)] = std::min(a, b);
+			}
+		};
+		auto compare = [&](const std::vector<size_t>& candidates) {
+			for (size_t j = 1; j < candidates.size(); j++) {
+				for (size_t k = 0; k < j; k++) {
+					if (find(candidates[j]) != find(candidates[k]) && similar(*m_Finished[candidates[j]], *m_Finished[candidates[k]], false)) {
+						unite(candidates[j], candidates[k]);
+					}
+				}
+			}
+		};
+
+		// 건너뛴 문서는 텍스트와 페이지가 일부뿐이므로 앞 페이지가 같았던 문서에 붙인다.
+		std::unordered_map<uint64_t, std::vector<size_t>> textBuckets;
+		std::map<size_t, std::vector<size_t>> pageBuckets;
+		for (size_t i = 0; i < documentCount; i++) {
+			const Document& current = *m_Finished[i];
+			if (!current.duplicateOf.empty()) {
+				auto found = m_Documents.find(current.duplicateOf);
+				auto order = found != m_Documents.end() ? orders.find(found->second.get()) : orders.end();
+				if (order != orders.end()) {
+					unite(i, order->second);
+				}
+			} else if (current.text.shingleCount > 0) {
+				// LSH : MinHash 를 묶음으로 나누어 한 묶음이라도 모두 같은 문서끼리만 비교한다.
+				for (int band = 0; band < LSH_BANDS; band++) {
+					uint64_t key = mix64(band + 1);
+					for (int row = 0; row < LSH_ROWS; row++) {
+						key = mix64(key ^ current.text.minHash[band * LSH_ROWS + row]);
+					}
+					textBuckets[key].push_back(i);
+				}
+			} else if (!current.pages.empty()) {
+				pageBuckets[current.pages.size()].push_back(i); // 텍스트가 없으면 페이지 수가 같은 문서끼리 비교한다.
+			}
+		}
+		for (const auto& bucket : textBuckets) {
+			compare(bucket.second);
+		}
+		for (const auto& bucket : pageBuckets) {
+			compare(bucket.second);
+		}
+
+		std::map<size_t, DuplicateCluster> groups; // 대표 번호 순서
+		for (size_t i = 0; i < documentCount; i++) {
+			DuplicateCluster& cluster = groups[find(i)];
+			cluster.sourceFiles.push_back(m_Finished[i]->sourceFile);
+			cluster.skipped.push_back(!m_Finished[i]->duplicateOf.empty());
+		}
+		std::vector<DuplicateCluster> clusters;
+		for (auto& group : groups) {
+			DuplicateCluster& cluster = group.second;
+			if (cluster.sourceFiles.size() < 2) {
+				continue;
+			}
+			// 건너뛴 문서는 원본보다 먼저 끝나므로 건너뛰지 않은 첫 문서를 앞으로 옮겨 대표로 한다.
+			auto representative = std::find(cluster.skipped.begin(), cluster.skipped.end(), false);
+			if (representative != cluster.skipped.end() && representative != cluster.skipped.begin()) {
+				const size_t index = representative - cluster.skipped.begin();
+				std::rotate(cluster.sourceFiles.begin(), cluster.sourceFiles.begin() + index, cluster.sourceFiles.begin() + index + 1);
+				std::rotate(cluster.skipped.begin(), cluster.skipped.begin() + index, cluster.skipped.begin() + index + 1);
+			}
+			clusters.push_back(std::move(cluster));
+		}
+		return clusters;
+	}
+
+	bool DuplicateDetector::WriteReport(const std::string& reportFile) const
+	{
+		const std::vector<DuplicateCluster> clusters = Clusters();
+		AutoFilePtr fp(fopen(reportFile.c_str(), "wb"));
+		_ASSERTE(fp && "fopen() Failed");
+		if (!fp) {
+			return false;
+		}
+
+		auto quoted = [](std::string text) -> std::string {
+			for (size_t pos = text.find('"'); pos != std::string::npos; pos = text.find('"', pos + 2)) {
+				text.insert(pos, 1, '"'); // CSV 따옴표 이스케이프
+			}
+			return "\"" + text + "\"";
+		};
+		fprintf(fp.get(), "cluster,source,representative,skipped\n");
+		size_t duplicates = 0;
+		for (size_t i = 0; i < clusters.size(); i++) {
+			const DuplicateCluster& cluster = clusters[i];
+			for (size_t j = 0; j < cluster.sourceFiles.size(); j++) {
+				fprintf(fp.get(), "%d,%s,%s,%d\n", static_cast<int>(i + 1), quoted(cluster.sourceFiles[j]).c_str(),
+					quoted(cluster.sourceFiles[0]).c_str(), cluster.skipped[j] ? 1 : 0);
+			}
+			duplicates += cluster.sourceFiles.size() - 1;
+		}
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		fprintf(fp.get(), "# documents=%d clusters=%d duplicates=%d\n", static_cast<int>(m_Finished.size()), static_cast<int>(clusters.size()), static_cast<int>(duplicates));
+		return ferror(fp.get()) == 0;
+	}
+
+}} // PDF::Converter
@@ -0,0 +1,108 @@
+﻿// PDFDuplicateDetector.h
+#pragma once
+#include <array> // std::array
+#include <vector> // std::vector
+#include <string> // std::string
+#include <memory> // std::unique_ptr
+#include <mutex> // std::mutex
+#include <unordered_map> // std::unordered_map
+#include <stdint.h> // uint32_t, uint64_t
+#include "PDFBoxConverter.h"
+
+namespace PDF { namespace Converter {
+
+	// 텍스트의 MinHash 서명. TokenizeText() 색인어를 3개씩 겹쳐 자른 싱글(shingle) 집합에서 해시 함수마다 최솟값을 남긴다.
+	// 두 서명에서 같은 값의 비율이 두 집합의 자카드 유사도 추정값이다.
+	struct TextSignature
+	{
+		static const int HASH_COUNT = 64;
+
+		std::array<uint32_t, HASH_COUNT> minHash;
+		uint64_t shingleCount = 0; // 0 이면 텍스트가 없어 비교하지 않는다.
+
+		TextSignature() { minHash.fill(0xFFFFFFFFu); }
+
+		void Add(const std::string& text); // 페이지 텍스트 (UTF-8). 페이지 경계를 넘는 싱글은 만들지 않는다.
+		void Merge(const TextSignature& other);
+		double Similarity(const TextSignature& other) const; // 어느 한쪽이 비어 있으면 0
+	}; // struct TextSignature
+
+	// 렌더링한 페이지의 지각 해시 (평균 해시). 페이지를 16x16 칸으로 나누어 밝기가 칸 평균보다 어두운 칸이 1 이다.
+	// 서명, 도장, 스캔 잡음처럼 작은 차이는 몇 비트만 바꾸고 해상도와 픽셀 포맷에 관계없이 같은 값이 된다.
+	struct PageHash
+	{
+		std::array<uint64_t, 4> bits;
+
+		PageHash() { bits.fill(0); }
+
+		int Distance(const PageHash& other) const; // 다른 비트 수 (0 ~ 256)
+	}; // struct PageHash
+
+	// 타일로 나누어 렌더링한 페이지도 같은 해시가 되도록 페이지 좌표의 픽셀을 나누어 받는다.
+	class PageHasher
+	{
+	public:
+		PageHasher(int pageWidth, int pageHeight);
+
+		void AddPixels(const Bitmap& bitmap, int x, int y); // bitmap 의 (0, 0) 이 페이지의 (x, y)
+		PageHash Finish() const;
+
+	private:
+		static const int GRID = 16;
+
+		int m_PageWidth;
+		int m_PageHeight;
+		std::array<uint64_t, GRID * GRID> m_Sums;	// 칸별 밝기 합
+		std::array<uint64_t, GRID * GRID> m_Counts;	// 칸별 픽셀 수
+	}; // class PageHasher
+
+	struct DuplicateOptions
+	{
+		double textSimilarity = 0.9;	// MinHash 로 추정한 자카드 유사도가 이 이상이면 같은 문서
+		int pageDistance = 24;			// 텍스트가 없는 문서는 모든 페이지 해시의 거리가 이 이하이면 같은 문서 (256bit 중)
+		int probePages = 0;				// 0 이 아니면 앞 probePages 페이지가 먼저 본 문서와 같을 때 나머지 페이지 변환을 건너뛴다.
+	}; // struct DuplicateOptions
+
+	struct DuplicateCluster
+	{
+		std::vector<std::string> sourceFiles;	// 첫 번째가 대표 (건너뛰지 않은 문서 중 먼저 변환을 마친 문서)
+		std::vector<bool> skipped;				// 앞 페이지만 변환하고 건너뛰었다.
+	}; // struct DuplicateCluster
+
+	// 일괄 변환 중 추출한 텍스트와 렌더링한 페이지로 거의 같은 문서를 찾는다. 여러 변환 스레드에서 동시에 호출할 수 있다.
+	// 텍스트가 있는 문서끼리는 텍스트로, 텍스트가 없는 문서(스캔)는 페이지 해시로 비교한다.
+	class DuplicateDetector
+	{
+	public:
+		explicit DuplicateDetector(const DuplicateOptions& options = DuplicateOptions());
+		~DuplicateDetector();
+
+		const DuplicateOptions& Options() const { return m_Options; }
+
+		void AddPageText(const std::string& sourceFile, int pageIndex, const std::string& text);
+		void AddPageHash(const std::string& sourceFile, int pageIndex, const PageHash& hash);
+		// probePages 페이지까지 넣은 뒤 호출한다. 앞 페이지가 같은 문서를 먼저 확인했으면 그 경로, 아니면 빈 문자열
+		std::string MatchPrefix(const std::string& sourceFile);
+		// 문서 변환이 끝나면 (실패해도) 호출한다. duplicateOf 는 MatchPrefix() 로 나머지를 건너뛴 경우의 대상
+		void Finish(const std::string& sourceFile, const std::string& duplicateOf);
+
+		std::vector<DuplicateCluster> Clusters() const; // 문서가 2개 이상인 군집
+		bool WriteReport(const std::string& reportFile) const;
+
+	private:
+		DuplicateDetector(const DuplicateDetector&) = delete;
+		DuplicateDetector& operator=(const DuplicateDetector&) = delete;
+
+		struct Document;
+		Document& document(const std::string& sourceFile); // m_Mutex 를 잡고 호출한다.
+		bool similar(const Document& a, const Document& b, bool prefix) const;
+
+	private:
+		DuplicateOptions m_Options;
+		mutable std::mutex m_Mutex;
+		std::unordered_map<std::string, std::unique_ptr<Document>> m_Documents;
+		std::vector<const Document*> m_Probed;		// MatchPrefix() 순서
+		std::vector<const Document*> m_Finished;	// Finish() 순서
+	}; // class DuplicateDetector
+
+}} // PDF::Converter
@@ -0,0 +1,363 @@
+﻿// PDFFlate.cpp
+#include "PDFFlate.h"
+#include <stdlib.h> // abs
+#include <stdint.h> // SIZE_MAX
+
+static const int MAX_PREDICTOR_COLORS = 32; // PDF 명세의 /Colors 상한
+
+namespace {
+
+	// 허프만 디코딩 테이블 (길이별 코드 수 + 코드 순서의 심볼)
+	struct Huffman
+	{
+		unsigned short counts[16];
+		unsigned short symbols[288];
+	}; // struct Huffman
+
+	class BitReader
+	{
+	public:
+		BitReader(const unsigned char* data, size_t size)
+		: m_Data(data)
+		, m_Size(size)
+		, m_Position(0)
+		, m_BitBuffer(0)
+		, m_BitCount(0)
+		, m_Overrun(false)
+		{
+		}
+
+		unsigned int Bits(int count)
+		{
+			while (m_BitCount < count) {
+				unsigned int byte = 0;
+				if (m_Position < m_Size) {
+					byte = m_Data[m_Position++];
+				} else {
+					m_Overrun = true;
+				}
+				m_BitBuffer |= byte << m_BitCount;
+				m_BitCount += 8;
+			}
+			unsigned int value = m_BitBuffer & ((1u << count) - 1);
+			m_BitBuffer >>= count;
+			m_BitCount -= count;
+			return value;
+		}
+
+		// 저장 블록은 바이트 경계에서 시작한다.
+		void AlignToByte()
+		{
+			m_BitBuffer = 0;
+			m_BitCount = 0;
+		}
+
+		bool ReadBytes(std::vector<unsigned char>& out, size_t count)
+		{
+			if (m_Size - m_Position < count) {
+				m_Overrun = true;
+				return false;
+			}
+			out.insert(out.end(), m_Data + m_Position, m_Data + m_Position + count);
+			m_Position += count;
+			return true;
+		}
+
+		size_t Position() const { return m_Position; }
+		void Skip(size_t count) { m_Position += count; }
+		bool Overrun() const { return m_Overrun; }
+
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+		size_t m_Position;
+		unsigned int m_BitBuffer;
+		int m_BitCount;
+		bool m_Overrun;
+	}; // class BitReader
+
+	bool buildHuffman(Huffman& huffman, const unsigned char* lengths, int count)
+	{
+		for (int i = 0; i < 16; i++) {
+			huffman.counts[i] = 0;
+		}
+		for (int i = 0; i < count; i++) {
+			huffman.counts[lengths[i]]++;
+		}
+		huffman.counts[0] = 0;
+
+		// 코드 공간을 초과하는 길이 집합은 잘못된 데이터이다.
+		int left = 1;
+		for (int length = 1; length < 16; length++) {
+			left <<= 1;
+			left -= huffman.counts[length];
+			if (left < 0) {
+				return false;
+			}
+		}
+
+		unsigned short offsets[16] = { 0, };
+		for (int length = 1; length < 15; length++) {
+			offsets[length + 1] = offsets[length] + huffman.counts[length];
+		}
+		for (int i = 0; i < count; i++) {
+			if (lengths[i]) {
+				huffman.symbols[offsets[lengths[i]]++] = static_cast<unsigned short>(i);
+			}
+		}
+		return true;
+	}
+
+	int decodeSymbol(BitReader& reader, const Huffman& huffman)
+	{
+		int code = 0;
+		int first = 0;
+		int index = 0;
+		for (int length = 1; length < 16; length++) {
+			code |= reader.Bits(1);
+			const int count = huffman.counts[length];
+			if (code - count < first) {
+				return huffman.symbols[index + (code - first)];
+			}
+			index += count;
+			first += count;
+			first <<= 1;
+			code <<= 1;
+		}
+		return -1;
+	}
+
+	const unsigned short LENGTH_BASE[29] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258 };
+	const unsigned char LENGTH_EXTRA[29] = { 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0 };
+	const unsigned short DISTANCE_BASE[30] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+	const unsigned char DISTANCE_EXTRA[30] = { 0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13 };
+
+	bool inflateBlock(BitReader& reader, const Huffman& literals, const Huffman& distances, std::vector<unsigned char>& out, size_t maxOutput)
+	{
+		for (;;) {
+			int symbol = decodeSymbol(reader, literals);
+			if (symbol < 0 || reader.Overrun()) {
+				return false;
+			}
+			if (symbol < 256) {
+				if (out.size() >= maxOutput) {
+					return false;
+				}
+				out.push_back(static_cast<unsigned char>(symbol));
+				continue;
+			}
+			if (symbol == 256) {
+				return true;
+			}
+
+			symbol -= 257;
+			if (symbol >= 29) {
+				return false;
+			}
+			const size_t length = LENGTH_BASE[symbol] + reader.Bits(LENGTH_EXTRA[symbol]);
+			const int distanceSymbol = decodeSymbol(reader, distances);
+			if (distanceSymbol < 0 || distanceSymbol >= 30) {
+				return false;
+			}
+			const size_t distance = DISTANCE_BASE[distanceSymbol] + reader.Bits(DISTANCE_EXTRA[distanceSymbol]);
+			if (distance > out.size() || out.size() + length > maxOutput) {
+				return false;
+			}
+			// 겹치는 복사가 있으므로 한 바이트씩 복사한다.
+			size_t from = out.size() - distance;
+			for (size_t i = 0; i < length; i++) {
+				out.push_back(out[from + i]);
+			}
+		}
+	}
+
+	bool readDynamicTables(BitReader& reader, Huffman& literals, Huffman& distances)
+	{
+		static const unsigned char ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+		const int literalCount = reader.Bits(5) + 257;
+		const int distanceCount = reader.Bits(5) + 1;
+		const int codeCount = reader.Bits(4) + 4;
+		if (literalCount > 286 || distanceCount > 30) {
+			return false;
+		}
+
+		unsigned char lengths[320] = { 0, };
+		for (int i = 0; i < codeCount; i++) {
+			lengths[ORDER[i]] = static_cast<unsigned char>(reader.Bits(3));
+		}
+		Huffman codeLengths;
+		if (!buildHuffman(codeLengths, lengths, 19)) {
+			return false;
+		}
+
+		int index = 0;
+		while (index < literalCount + distanceCount) {
+			int symbol = decodeSymbol(reader, codeLengths);
+			if (symbol < 0 || reader.Overrun()) {
+				return false;
+			}
+			if (symbol < 16) {
+				lengths[index++] = static_cast<unsigned char>(symbol);
+				continue;
+			}
+			unsigned char value = 0;
+			int repeat = 0;
+			if (symbol == 16) {
+				if (index == 0) {
+					return false;
+				}
+				value = lengths[index - 1];
+				repeat = 3 + reader.Bits(2);
+			} else if (symbol == 17) {
+				repeat = 3 + reader.Bits(3);
+			} else {
+				repeat = 11 + reader.Bits(7);
+			}
+			if (index + repeat > literalCount + distanceCount) {
+				return false;
+			}
+			while (repeat--) {
+				lengths[index++] = value;
+			}
+		}
+
+		return buildHuffman(literals, lengths, literalCount)
+			&& buildHuffman(distances, lengths + literalCount, distanceCount);
+	}
+
+	void buildFixedTables(Huffman& literals, Huffman& distances)
+	{
+		unsigned char lengths[288];
+		for (int i = 0; i < 144; i++) {
+			lengths[i] = 8;
+		}
+		for (int i = 144; i < 256; i++) {
+			lengths[i] = 9;
+		}
+		for (int i = 256; i < 280; i++) {
+			lengths[i] = 7;
+		}
+		for (int i = 280; i < 288; i++) {
+			lengths[i] = 8;
+		}
+		buildHuffman(literals, lengths, 288);
+		for (int i = 0; i < 30; i++) {
+			lengths[i] = 5;
+		}
+		buildHuffman(distances, lengths, 30);
+	}
+
+	int paeth(int a, int b, int c)
+	{
+		const int p = a + b - c;
+		const int pa = abs(p - a);
+		const int pb = abs(p - b);
+		const int pc = abs(p - c);
+		if (pa <= pb && pa <= pc) {
+			return a;
+		}
+		return pb <= pc ? b : c;
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	bool FlateDecode(const unsigned char* data, size_t size, std::vector<unsigned char>& out, size_t maxOutput /*= 256 * 1024 * 1024*/)
+	{
+		out.clear();
+		if (!data || size < 2) {
+			return false;
+		}
+
+		BitReader reader(data, size);
+		// zlib 헤더 (CM = 8, FCHECK) 가 없으면 raw deflate 로 처리한다.
+		if ((data[0] & 0x0F) == 8 && ((data[0] << 8) | data[1]) % 31 == 0) {
+			if (data[1] & 0x20) {
+				return false; // 사전(FDICT)은 PDF 에서 사용하지 않는다.
+			}
+			reader.Skip(2);
+		}
+
+		Huffman literals;
+		Huffman distances;
+		bool last = false;
+		while (!last) {
+			last = reader.Bits(1) != 0;
+			const unsigned int type = reader.Bits(2);
+			if (reader.Overrun()) {
+				return false;
+			}
+			if (type == 0) {
+				reader.AlignToByte();
+				std::vector<unsigned char> header;
+				if (!reader.ReadBytes(header, 4)) {
+					return false;
+				}
+				const size_t length = header[0] | (header[1] << 8);
+				const size_t inverse = header[2] | (header[3] << 8);
+				if (length != (~inverse & 0xFFFF) || out.size() + length > maxOutput || !reader.ReadBytes(out, length)) {
+					return false;
+				}
+			} else if (type == 1) {
+				buildFixedTables(literals, distances);
+				if (!inflateBlock(reader, literals, distances, out, maxOutput)) {
+					return false;
+				}
+			} else if (type == 2) {
+				if (!readDynamicTables(reader, literals, distances) || !inflateBlock(reader, literals, distances, out, maxOutput)) {
+					return false;
+				}
+			} else {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool UndoPredictor(std::vector<unsigned char>& data, int predictor, int colors, int bitsPerComponent, int columns)
+	{
+		if (predictor <= 1) {
+			return true;
+		}
+		// 매개변수는 신뢰할 수 없는 파일에서 오므로 할당하기 전에 범위와 데이터 크기를 확인한다.
+		const bool validBits = bitsPerComponent == 1 || bitsPerComponent == 2 || bitsPerComponent == 4 || bitsPerComponent == 8 || bitsPerComponent == 16;
+		if (predictor < 10 || colors <= 0 || colors > MAX_PREDICTOR_COLORS || !validBits || columns <= 0) {
+			return false; // TIFF 예측자(2)는 xref/오브젝트 스트림에 쓰이지 않는다.
+		}
+		const size_t pixelBits = static_cast<size_t>(colors) * static_cast<size_t>(bitsPerComponent);
+		if (static_cast<size_t>(columns) > (SIZE_MAX - 7) / pixelBits) {
+			return false;
+		}
+		const size_t bytesPerPixel = (pixelBits + 7) / 8;
+		const size_t rowLength = (static_cast<size_t>(columns) * pixelBits + 7) / 8;
+		if (rowLength >= data.size()) {
+			return false; // 한 줄(필터 바이트 포함)도 들어있지 않다.
+		}
+		const size_t rowCount = data.size() / (rowLength + 1);
+		std::vector<unsigned char> out(rowCount * rowLength);
+		std::vector<unsigned char> previous(rowLength, 0);
+		for (size_t row = 0; row < rowCount; row++) {
+			const unsigned char filter = data[row * (rowLength + 1)];
+			const unsigned char* in = &data[row * (rowLength + 1) + 1];
+			unsigned char* current = &out[row * rowLength];
+			for (size_t i = 0; i < rowLength; i++) {
+				const int left = i >= bytesPerPixel ? current[i - bytesPerPixel] : 0;
+				const int up = previous[i];
+				const int upLeft = i >= bytesPerPixel ? previous[i - bytesPerPixel] : 0;
+				int value = in[i];
+				switch (filter) {
+				case 1: value += left; break;
+				case 2: value += up; break;
+				case 3: value += (left + up) / 2; break;
+				case 4: value += paeth(left, up, upLeft); break;
+				default: break;
+				}
+				current[i] = static_cast<unsigned char>(value);
+			}
+			previous.assign(current, current + rowLength);
+		}
+		data.swap(out);
+		return true;
+	}
+
+}} // PDF::Converter
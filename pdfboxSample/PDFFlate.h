@@ -0,0 +1,15 @@
+﻿// PDFFlate.h
+#pragma once
+#include <vector> // std::vector
+#include <stddef.h> // size_t
+
+namespace PDF { namespace Converter {
+
+	// zlib(RFC 1950) 또는 raw deflate(RFC 1951) 데이터를 푼다.
+	// 손상되어 중간에 끝나는 스트림은 그때까지 푼 결과를 남기고 false 를 반환한다.
+	bool FlateDecode(const unsigned char* data, size_t size, std::vector<unsigned char>& out, size_t maxOutput = 256 * 1024 * 1024);
+
+	// FlateDecode 의 /DecodeParms 예측자(PNG 10~15)를 되돌린다. predictor 1 은 그대로 둔다.
+	bool UndoPredictor(std::vector<unsigned char>& data, int predictor, int colors, int bitsPerComponent, int columns);
+
+}} // PDF::Converter
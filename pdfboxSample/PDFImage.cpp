@@ -0,0 +1,617 @@
+﻿// PDFImage.cpp
+#include "PDFImage.h"
+#include <algorithm> // std::min, std::max
+#include <cmath> // std::sin, std::floor, std::ceil
+#include <string.h> // memcpy
+#include "pdf_assert.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#	define PDF_IMAGE_SSE2
+#	include <emmintrin.h>
+#endif
+
+namespace {
+
+	const int WEIGHT_BITS = 14; // 고정소수점 필터 가중치 정밀도
+	const double PI = 3.14159265358979323846;
+
+	// 출력 픽셀 하나에 기여하는 원본 픽셀 범위와 가중치
+	struct Contribution
+	{
+		int first = 0;
+		int count = 0;
+		std::vector<int> weights;
+		std::vector<int16_t> packedWeights; // SIMD 용 16bit 가중치 (weights 와 같다)
+	}; // struct Contribution
+
+	double lanczos3(double x)
+	{
+		x = std::fabs(x);
+		if (x < 1e-8) {
+			return 1.0;
+		}
+		if (x >= 3.0) {
+			return 0.0;
+		}
+		const double px = PI * x;
+		return 3.0 * std::sin(px) * std::sin(px / 3.0) / (px * px);
+	}
+
+	double box(double x)
+	{
+		return (x >= -0.5 && x < 0.5) ? 1.0 : 0.0;
+	}
+
+	std::vector<Contribution> makeContributions(int srcSize, int dstSize, PDF::Converter::ResampleFilter filter)
+	{
+		const double scale = static_cast<double>(dstSize) / srcSize;
+		const double filterScale = std::min(scale, 1.0);
+		const double radius = (filter == PDF::Converter::ResampleFilter::Lanczos ? 3.0 : 0.5) / filterScale;
+
+		std::vector<Contribution> contributions(dstSize);
+		std::vector<double> weights;
+		for (int i = 0; i < dstSize; i++) {
+			const double center = (i + 0.5) / scale - 0.5;
+			const int first = std::max(static_cast<int>(std::floor(center - radius)), 0);
+			const int last = std::min(static_cast<int>(std::ceil(center + radius)), srcSize - 1);
+
+			weights.clear();
+			double total = 0.0;
+			for (int j = first; j <= last; j++) {
+				const double x = (j - center) * filterScale;
+				const double weight = filter == PDF::Converter::ResampleFilter::Lanczos ? lanczos3(x) : box(x);
+				weights.push_back(weight);
+				total += weight;
+			}
+			if (total == 0.0) {
+				// 확대 시 Box 필터가 비는 경우 가장 가까운 픽셀을 사용한다.
+				const int nearest = std::min(std::max(static_cast<int>(center + 0.5), 0), srcSize - 1);
+				contributions[i].first = nearest;
+				contributions[i].count = 1;
+				contributions[i].weights.assign(1, 1 << WEIGHT_BITS);
+				contributions[i].packedWeights.assign(1, static_cast<int16_t>(1 << WEIGHT_BITS));
+				continue;
+			}
+
+			// 가중치 합이 정확히 1 << WEIGHT_BITS 가 되도록 가장 큰 가중치에 오차를 더한다.
+			Contribution& contribution = contributions[i];
+			contribution.first = first;
+			contribution.count = static_cast<int>(weights.size());
+			contribution.weights.resize(weights.size());
+			int sum = 0;
+			size_t largest = 0;
+			for (size_t k = 0; k < weights.size(); k++) {
+				contribution.weights[k] = static_cast<int>(std::floor(weights[k] / total * (1 << WEIGHT_BITS) + 0.5));
+				sum += contribution.weights[k];
+				if (contribution.weights[k] > contribution.weights[largest]) {
+					largest = k;
+				}
+			}
+			contribution.weights[largest] += (1 << WEIGHT_BITS) - sum;
+			contribution.packedWeights.assign(contribution.weights.begin(), contribution.weights.end()); // |가중치| < 2^15
+		}
+		return contributions;
+	}
+
+	unsigned char clampToByte(int value)
+	{
+		value = (value + (1 << (WEIGHT_BITS - 1))) >> WEIGHT_BITS;
+		return static_cast<unsigned char>(value < 0 ? 0 : (value > 255 ? 255 : value));
+	}
+
+#ifdef PDF_IMAGE_SSE2
+	// 4픽셀(16byte)의 인접한 두 픽셀을 16bit 로 더한다. 결과 : [p0 + p1, p2 + p3]
+	inline __m128i sumPixelPairs(__m128i pixels)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i low = _mm_unpacklo_epi8(pixels, zero);
+		__m128i high = _mm_unpackhi_epi8(pixels, zero);
+		low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+		high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+		return _mm_unpacklo_epi64(low, high);
+	}
+
+	// 그레이 두 줄을 16 픽셀씩 축소한다. 처리한 출력 픽셀 수를 반환한다.
+	int halveRowGray(const unsigned char* row0, const unsigned char* row1, unsigned char* out, int pairs)
+	{
+		const __m128i mask = _mm_set1_epi16(0x00FF);
+		const __m128i two = _mm_set1_epi16(2);
+		int x = 0;
+		for (; x + 16 <= pairs; x += 16) {
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x + 16));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x + 16));
+			__m128i s0 = _mm_add_epi16(
+				_mm_add_epi16(_mm_and_si128(a0, mask), _mm_srli_epi16(a0, 8)),
+				_mm_add_epi16(_mm_and_si128(b0, mask), _mm_srli_epi16(b0, 8))
+			);
+			__m128i s1 = _mm_add_epi16(
+				_mm_add_epi16(_mm_and_si128(a1, mask), _mm_srli_epi16(a1, 8)),
+				_mm_add_epi16(_mm_and_si128(b1, mask), _mm_srli_epi16(b1, 8))
+			);
+			s0 = _mm_srli_epi16(_mm_add_epi16(s0, two), 2);
+			s1 = _mm_srli_epi16(_mm_add_epi16(s1, two), 2);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(s0, s1));
+		}
+		return x;
+	}
+
+	// 4byte 픽셀 두 줄을 4 픽셀씩 축소한다. 처리한 출력 픽셀 수를 반환한다.
+	int halveRowBGRA(const unsigned char* row0, const unsigned char* row1, unsigned char* out, int pairs)
+	{
+		const __m128i two = _mm_set1_epi16(2);
+		int x = 0;
+		for (; x + 4 <= pairs; x += 4) {
+			__m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x));
+			__m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 8 * x + 16));
+			__m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x));
+			__m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 8 * x + 16));
+			__m128i s0 = _mm_add_epi16(_mm_add_epi16(sumPixelPairs(a0), sumPixelPairs(b0)), two);
+			__m128i s1 = _mm_add_epi16(_mm_add_epi16(sumPixelPairs(a1), sumPixelPairs(b1)), two);
+			s0 = _mm_srli_epi16(s0, 2);
+			s1 = _mm_srli_epi16(s1, 2);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(out + 4 * x), _mm_packus_epi16(s0, s1));
+		}
+		return x;
+	}
+
+	// 세로 필터 : 원본 두 줄씩 16bit 로 섞어서 _mm_madd_epi16 한번에 두 가중치를 곱해 더한다.
+	// 8byte 단위로 처리하고 처리한 바이트 수를 반환한다.
+	int resampleColumns(const unsigned char* in, int inStride, const Contribution& contribution, unsigned char* out, int length)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i half = _mm_set1_epi32(1 << (WEIGHT_BITS - 1));
+		int i = 0;
+		for (; i + 8 <= length; i += 8) {
+			__m128i sum0 = half;
+			__m128i sum1 = half;
+			int k = 0;
+			for (; k < contribution.count; k += 2) {
+				const unsigned char* row0 = in + static_cast<size_t>(k) * inStride + i;
+				const bool pair = k + 1 < contribution.count;
+				__m128i a = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0)), zero);
+				__m128i b = pair ? _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(row0 + inStride)), zero) : zero;
+				const unsigned int weight0 = static_cast<unsigned int>(contribution.weights[k]) & 0xFFFF;
+				const unsigned int weight1 = pair ? static_cast<unsigned int>(contribution.weights[k + 1]) & 0xFFFF : 0;
+				const __m128i weights = _mm_set1_epi32(static_cast<int>(weight0 | (weight1 << 16)));
+				sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi16(a, b), weights));
+				sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi16(a, b), weights));
+			}
+			sum0 = _mm_srai_epi32(sum0, WEIGHT_BITS);
+			sum1 = _mm_srai_epi32(sum1, WEIGHT_BITS);
+			__m128i packed = _mm_packs_epi32(sum0, sum1);
+			_mm_storel_epi64(reinterpret_cast<__m128i*>(out + i), _mm_packus_epi16(packed, packed));
+		}
+		return i;
+	}
+
+	// 가로 필터 (Gray) : 출력 픽셀마다 원본 8 픽셀씩 _mm_madd_epi16 으로 가중치를 곱해 더한다.
+	// 8 픽셀보다 적게 남은 기여는 스칼라로 더한다. 처리한 출력 픽셀 수를 반환한다.
+	int resampleRowGray(const unsigned char* in, const std::vector<Contribution>& columns, unsigned char* out, int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		for (int x = 0; x < width; x++) {
+			const Contribution& contribution = columns[x];
+			const unsigned char* pixel = in + contribution.first;
+			__m128i sums = zero;
+			int k = 0;
+			for (; k + 8 <= contribution.count; k += 8) {
+				const __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel + k)), zero);
+				const __m128i weights = _mm_loadu_si128(reinterpret_cast<const __m128i*>(contribution.packedWeights.data() + k));
+				sums = _mm_add_epi32(sums, _mm_madd_epi16(pixels, weights));
+			}
+			sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 8));
+			sums = _mm_add_epi32(sums, _mm_srli_si128(sums, 4));
+			int sum = _mm_cvtsi128_si32(sums);
+			for (; k < contribution.count; k++) {
+				sum += contribution.weights[k] * pixel[k];
+			}
+			out[x] = clampToByte(sum);
+		}
+		return width;
+	}
+
+	// 가로 필터 (4byte 픽셀) : 인접한 두 픽셀을 채널별 16bit 쌍으로 섞어 _mm_madd_epi16 한번에 네 채널을 누적한다.
+	// 처리한 출력 픽셀 수를 반환한다.
+	int resampleRowBGRA(const unsigned char* in, const std::vector<Contribution>& columns, unsigned char* out, int width)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i half = _mm_set1_epi32(1 << (WEIGHT_BITS - 1));
+		for (int x = 0; x < width; x++) {
+			const Contribution& contribution = columns[x];
+			const unsigned char* pixel = in + static_cast<size_t>(contribution.first) * 4;
+			__m128i sum = half;
+			int k = 0;
+			for (; k + 2 <= contribution.count; k += 2) {
+				// [b0, g0, r0, a0, b1, g1, r1, a1] -> [b0, b1, g0, g1, r0, r1, a0, a1]
+				const __m128i pixels = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(pixel + 4 * k)), zero);
+				const __m128i pairs = _mm_unpacklo_epi16(pixels, _mm_srli_si128(pixels, 8));
+				const unsigned int weight0 = static_cast<unsigned int>(contribution.weights[k]) & 0xFFFF;
+				const unsigned int weight1 = static_cast<unsigned int>(contribution.weights[k + 1]) & 0xFFFF;
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(pairs, _mm_set1_epi32(static_cast<int>(weight0 | (weight1 << 16)))));
+			}
+			if (k < contribution.count) {
+				int last = 0;
+				memcpy(&last, pixel + 4 * k, 4);
+				const __m128i pixels = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(last), zero), zero);
+				sum = _mm_add_epi32(sum, _mm_madd_epi16(pixels, _mm_set1_epi32(contribution.weights[k] & 0xFFFF)));
+			}
+			sum = _mm_srai_epi32(sum, WEIGHT_BITS);
+			const __m128i packed = _mm_packs_epi32(sum, sum);
+			const int value = _mm_cvtsi128_si32(_mm_packus_epi16(packed, packed));
+			memcpy(out + 4 * x, &value, 4);
+		}
+		return width;
+	}
+
+	// 그레이 한 줄에서 maxInk 이하인 바이트를 16개씩 센다. 처리한 픽셀 수를 반환한다.
+	int countInkGray(const unsigned char* row, int width, unsigned char maxInk, int64_t& count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi8(1);
+		const __m128i threshold = _mm_set1_epi8(static_cast<char>(maxInk));
+		__m128i sums = zero;
+		int x = 0;
+		for (; x + 16 <= width; x += 16) {
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+			const __m128i ink = _mm_cmpeq_epi8(_mm_min_epu8(pixels, threshold), pixels); // 부호 없는 x <= maxInk
+			sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_and_si128(ink, one), zero));
+		}
+		uint64_t lanes[2];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+		count += static_cast<int64_t>(lanes[0] + lanes[1]);
+		return x;
+	}
+
+	// 4byte 픽셀 한 줄에서 B, G, R 중 maxInk 이하가 있는 픽셀을 4개씩 센다. 처리한 픽셀 수를 반환한다.
+	int countInkBGRA(const unsigned char* row, int width, unsigned char maxInk, bool alpha, int64_t& count)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i colorMask = _mm_set1_epi32(0x00FFFFFF);
+		const __m128i threshold = _mm_set1_epi8(static_cast<char>(maxInk));
+		__m128i sums = zero;
+		int x = 0;
+		for (; x + 4 <= width; x += 4) {
+			const __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + 4 * x));
+			const __m128i dark = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(pixels, threshold), pixels), colorMask);
+			__m128i ink = _mm_andnot_si128(_mm_cmpeq_epi32(dark, zero), _mm_set1_epi32(-1)); // 어두운 채널이 있으면 -1
+			if (alpha) {
+				ink = _mm_and_si128(ink, _mm_srai_epi32(pixels, 31)); // 알파 최상위 비트 : 반 이상 불투명
+			}
+			sums = _mm_sub_epi32(sums, ink);
+		}
+		uint32_t lanes[4];
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), sums);
+		count += static_cast<int64_t>(lanes[0]) + lanes[1] + lanes[2] + lanes[3];
+		return x;
+	}
+
+	// 16byte 의 잉크 마스크. Gray 는 16 픽셀, BGRA 는 4 픽셀이며 픽셀마다 1bit 이다.
+	inline int inkMaskGray(const unsigned char* pixels, __m128i threshold)
+	{
+		const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(values, threshold), values));
+	}
+
+	inline int inkMaskBGRA(const unsigned char* pixels, __m128i threshold, bool alpha)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i values = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pixels));
+		const __m128i dark = _mm_and_si128(_mm_cmpeq_epi8(_mm_min_epu8(values, threshold), values), _mm_set1_epi32(0x00FFFFFF));
+		__m128i ink = _mm_andnot_si128(_mm_cmpeq_epi32(dark, zero), _mm_set1_epi32(-1));
+		if (alpha) {
+			ink = _mm_and_si128(ink, _mm_srai_epi32(values, 31));
+		}
+		return _mm_movemask_ps(_mm_castsi128_ps(ink));
+	}
+#endif
+
+	inline bool isInkPixel(const unsigned char* row, int x, PDF::Converter::PixelFormat format, unsigned char maxInk)
+	{
+		if (format == PDF::Converter::PixelFormat::Gray) {
+			return row[x] <= maxInk;
+		}
+		if (format == PDF::Converter::PixelFormat::Mono) {
+			return ((row[x >> 3] >> (7 - (x & 7))) & 1) == 0; // 1 = 흰색
+		}
+		const unsigned char* pixel = row + 4 * x; // B, G, R, A
+		const bool dark = pixel[0] <= maxInk || pixel[1] <= maxInk || pixel[2] <= maxInk;
+		return dark && (format != PDF::Converter::PixelFormat::RGBA || pixel[3] >= 0x80);
+	}
+
+	int lowestBit(int mask)
+	{
+		int bit = 0;
+		for (; !(mask & 1); mask >>= 1) {
+			bit++;
+		}
+		return bit;
+	}
+
+	int highestBit(int mask)
+	{
+		int bit = -1;
+		for (; mask; mask >>= 1) {
+			bit++;
+		}
+		return bit;
+	}
+
+	// 줄의 [from, to) 에서 첫 잉크 픽셀. 없으면 to
+	int firstInk(const unsigned char* row, int from, int to, PDF::Converter::PixelFormat format, unsigned char maxInk)
+	{
+		int x = from;
+#ifdef PDF_IMAGE_SSE2
+		const __m128i threshold = _mm_set1_epi8(static_cast<char>(maxInk));
+		if (format == PDF::Converter::PixelFormat::Gray) {
+			for (; x + 16 <= to; x += 16) {
+				const int mask = inkMaskGray(row + x, threshold);
+				if (mask) {
+					return x + lowestBit(mask);
+				}
+			}
+		} else if (format != PDF::Converter::PixelFormat::Mono) {
+			for (; x + 4 <= to; x += 4) {
+				const int mask = inkMaskBGRA(row + 4 * x, threshold, format == PDF::Converter::PixelFormat::RGBA);
+				if (mask) {
+					return x + lowestBit(mask);
+				}
+			}
+		}
+#endif
+		if (format == PDF::Converter::PixelFormat::Mono) {
+			for (; (x & 7) == 0 && x + 8 <= to && row[x >> 3] == 0xFF; x += 8) {
+				// 흰 바이트는 한번에 건너뛴다.
+			}
+		}
+		for (; x < to; x++) {
+			if (isInkPixel(row, x, format, maxInk)) {
+				return x;
+			}
+		}
+		return to;
+	}
+
+	// 줄의 [from, to) 에서 마지막 잉크 픽셀. 없으면 from - 1
+	int lastInk(const unsigned char* row, int from, int to, PDF::Converter::PixelFormat format, unsigned char maxInk)
+	{
+		int x = to;
+#ifdef PDF_IMAGE_SSE2
+		const __m128i threshold = _mm_set1_epi8(static_cast<char>(maxInk));
+		if (format == PDF::Converter::PixelFormat::Gray) {
+			for (; x - 16 >= from; x -= 16) {
+				const int mask = inkMaskGray(row + x - 16, threshold);
+				if (mask) {
+					return x - 16 + highestBit(mask);
+				}
+			}
+		} else if (format != PDF::Converter::PixelFormat::Mono) {
+			for (; x - 4 >= from; x -= 4) {
+				const int mask = inkMaskBGRA(row + 4 * (x - 4), threshold, format == PDF::Converter::PixelFormat::RGBA);
+				if (mask) {
+					return x - 4 + highestBit(mask);
+				}
+			}
+		}
+#endif
+		for (; x > from; x--) {
+			if (isInkPixel(row, x - 1, format, maxInk)) {
+				return x - 1;
+			}
+		}
+		return from - 1;
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	int BytesPerPixel(PixelFormat format)
+	{
+		switch (format) {
+		case PixelFormat::Gray:
+			return 1;
+		case PixelFormat::Mono:
+			return 0;
+		default:
+			return 4;
+		}
+	}
+
+	bool HalveBitmap(const Bitmap& src, Bitmap& dst)
+	{
+		const int bpp = BytesPerPixel(src.format);
+		_ASSERTE(bpp > 0 && &src != &dst && "unsupported bitmap");
+		if (bpp == 0 || &src == &dst || src.width <= 0 || src.height <= 0) {
+			return false;
+		}
+
+		dst.width = (src.width + 1) / 2;
+		dst.height = (src.height + 1) / 2;
+		dst.stride = dst.width * bpp;
+		dst.format = src.format;
+		dst.pixels.resize(static_cast<size_t>(dst.stride) * dst.height);
+
+		const int pairs = src.width / 2; // 2x2 블록이 완전한 열 수
+		for (int y = 0; y < dst.height; y++) {
+			const unsigned char* row0 = src.pixels.data() + static_cast<size_t>(2 * y) * src.stride;
+			const unsigned char* row1 = (2 * y + 1 < src.height) ? row0 + src.stride : row0; // 홀수 높이는 마지막 줄 반복
+			unsigned char* out = dst.pixels.data() + static_cast<size_t>(y) * dst.stride;
+
+			int x = 0;
+#ifdef PDF_IMAGE_SSE2
+			x = (bpp == 1) ? halveRowGray(row0, row1, out, pairs) : halveRowBGRA(row0, row1, out, pairs);
+#endif
+			for (; x < pairs; x++) {
+				for (int c = 0; c < bpp; c++) {
+					const int left = 2 * x * bpp + c;
+					const int right = left + bpp;
+					out[x * bpp + c] = static_cast<unsigned char>((row0[left] + row0[right] + row1[left] + row1[right] + 2) >> 2);
+				}
+			}
+			if (src.width & 1) {
+				for (int c = 0; c < bpp; c++) {
+					const int last = 2 * pairs * bpp + c;
+					out[pairs * bpp + c] = static_cast<unsigned char>((row0[last] + row1[last] + 1) >> 1);
+				}
+			}
+		}
+		return true;
+	}
+
+	bool ResizeBitmap(const Bitmap& src, int width, int height, ResampleFilter filter, Bitmap& dst)
+	{
+		const int bpp = BytesPerPixel(src.format);
+		_ASSERTE(bpp > 0 && &src != &dst && width > 0 && height > 0 && "unsupported bitmap");
+		if (bpp == 0 || &src == &dst || width <= 0 || height <= 0 || src.width <= 0 || src.height <= 0) {
+			return false;
+		}
+
+		const std::vector<Contribution> columns = makeContributions(src.width, width, filter);
+		const std::vector<Contribution> rows = makeContributions(src.height, height, filter);
+
+		// 가로 방향 : src.height x width, 출력 픽셀마다 SIMD 로 누적한다.
+		const int tempStride = width * bpp;
+		std::vector<unsigned char> temp(static_cast<size_t>(tempStride) * src.height);
+		for (int y = 0; y < src.height; y++) {
+			const unsigned char* in = src.pixels.data() + static_cast<size_t>(y) * src.stride;
+			unsigned char* out = temp.data() + static_cast<size_t>(y) * tempStride;
+			int x = 0;
+#ifdef PDF_IMAGE_SSE2
+			x = (bpp == 1) ? resampleRowGray(in, columns, out, width) : resampleRowBGRA(in, columns, out, width);
+#endif
+			for (; x < width; x++) {
+				const Contribution& contribution = columns[x];
+				int sum[4] = { 0, };
+				const unsigned char* pixel = in + contribution.first * bpp;
+				for (int k = 0; k < contribution.count; k++, pixel += bpp) {
+					const int weight = contribution.weights[k];
+					for (int c = 0; c < bpp; c++) {
+						sum[c] += weight * pixel[c];
+					}
+				}
+				for (int c = 0; c < bpp; c++) {
+					out[x * bpp + c] = clampToByte(sum[c]);
+				}
+			}
+		}
+
+		// 세로 방향 : 출력 한 줄의 바이트를 8개씩 묶어 SIMD 로 누적한다.
+		dst.width = width;
+		dst.height = height;
+		dst.stride = tempStride;
+		dst.format = src.format;
+		dst.pixels.resize(static_cast<size_t>(dst.stride) * dst.height);
+		for (int y = 0; y < height; y++) {
+			const Contribution& contribution = rows[y];
+			const unsigned char* in = temp.data() + static_cast<size_t>(contribution.first) * tempStride;
+			unsigned char* out = dst.pixels.data() + static_cast<size_t>(y) * dst.stride;
+
+			int i = 0;
+#ifdef PDF_IMAGE_SSE2
+			i = resampleColumns(in, tempStride, contribution, out, tempStride);
+#endif
+			for (; i < tempStride; i++) {
+				int sum = 0;
+				for (int k = 0; k < contribution.count; k++) {
+					sum += contribution.weights[k] * in[static_cast<size_t>(k) * tempStride + i];
+				}
+				out[i] = clampToByte(sum);
+			}
+		}
+		return true;
+	}
+
+	int64_t CountInkPixels(const Bitmap& bitmap, int inkLevel)
+	{
+		_ASSERTE(bitmap.format != PixelFormat::Default && "unsupported bitmap");
+		if (bitmap.format == PixelFormat::Default || inkLevel <= 0 || bitmap.width <= 0 || bitmap.height <= 0) {
+			return 0;
+		}
+		const unsigned char maxInk = static_cast<unsigned char>(std::min(inkLevel, 256) - 1);
+		const bool alpha = bitmap.format == PixelFormat::RGBA;
+		int64_t count = 0;
+		for (int y = 0; y < bitmap.height; y++) {
+			const unsigned char* row = bitmap.pixels.data() + static_cast<size_t>(y) * bitmap.stride;
+			if (bitmap.format == PixelFormat::Mono) {
+				// 1 = 흰색. 마지막 바이트의 남는 비트는 세지 않는다.
+				for (int x = 0; x < bitmap.width; x += 8) {
+					const int bits = std::min(bitmap.width - x, 8);
+					unsigned int black = ~row[x >> 3] & (0xFF00u >> bits) & 0xFFu;
+					for (; black; black &= black - 1) {
+						count++;
+					}
+				}
+				continue;
+			}
+
+			int x = 0;
+			if (bitmap.format == PixelFormat::Gray) {
+#ifdef PDF_IMAGE_SSE2
+				x = countInkGray(row, bitmap.width, maxInk, count);
+#endif
+				for (; x < bitmap.width; x++) {
+					count += row[x] <= maxInk ? 1 : 0;
+				}
+				continue;
+			}
+#ifdef PDF_IMAGE_SSE2
+			x = countInkBGRA(row, bitmap.width, maxInk, alpha, count);
+#endif
+			for (; x < bitmap.width; x++) {
+				const unsigned char* pixel = row + 4 * x; // B, G, R, A
+				const bool dark = pixel[0] <= maxInk || pixel[1] <= maxInk || pixel[2] <= maxInk;
+				count += (dark && (!alpha || pixel[3] >= 0x80)) ? 1 : 0;
+			}
+		}
+		return count;
+	}
+
+	bool FindContentBounds(const Bitmap& bitmap, int inkLevel, int& x, int& y, int& width, int& height)
+	{
+		_ASSERTE(bitmap.format != PixelFormat::Default && "unsupported bitmap");
+		if (bitmap.format == PixelFormat::Default || inkLevel <= 0 || bitmap.width <= 0 || bitmap.height <= 0) {
+			return false;
+		}
+		const unsigned char maxInk = static_cast<unsigned char>(std::min(inkLevel, 256) - 1);
+		auto row = [&bitmap](int index) -> const unsigned char* {
+			return bitmap.pixels.data() + static_cast<size_t>(index) * bitmap.stride;
+		};
+
+		int top = 0;
+		int left = bitmap.width;
+		for (; top < bitmap.height; top++) {
+			left = firstInk(row(top), 0, bitmap.width, bitmap.format, maxInk);
+			if (left < bitmap.width) {
+				break;
+			}
+		}
+		if (top == bitmap.height) {
+			return false;
+		}
+		int bottom = bitmap.height - 1;
+		int right = -1;
+		for (; bottom > top; bottom--) {
+			right = lastInk(row(bottom), 0, bitmap.width, bitmap.format, maxInk);
+			if (right >= 0) {
+				break;
+			}
+		}
+		right = std::max(right, lastInk(row(top), 0, bitmap.width, bitmap.format, maxInk));
+		left = std::min(left, firstInk(row(bottom), 0, left, bitmap.format, maxInk));
+
+		// 사이 줄은 지금까지의 경계 바깥만 본다.
+		for (int index = top + 1; index < bottom; index++) {
+			const unsigned char* line = row(index);
+			left = firstInk(line, 0, left, bitmap.format, maxInk);
+			right = std::max(right, lastInk(line, right + 1, bitmap.width, bitmap.format, maxInk));
+		}
+
+		x = left;
+		y = top;
+		width = right - left + 1;
+		height = bottom - top + 1;
+		return true;
+	}
+
+}} // PDF::Converter
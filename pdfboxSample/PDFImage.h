@@ -0,0 +1,24 @@
+﻿// PDFImage.h
+#pragma once
+#include "PDFBoxConverter.h"
+
+namespace PDF { namespace Converter {
+
+	// 픽셀당 바이트 수, Mono 는 0
+	int BytesPerPixel(PixelFormat format);
+
+	// 2x2 픽셀 평균으로 가로 세로를 절반(올림)으로 줄인다. Gray, RGB, RGBA 만 지원한다.
+	bool HalveBitmap(const Bitmap& src, Bitmap& dst);
+
+	// 분리형 필터로 임의 크기로 변환한다. Gray, RGB, RGBA 만 지원한다.
+	bool ResizeBitmap(const Bitmap& src, int width, int height, ResampleFilter filter, Bitmap& dst);
+
+	// 밝기가 inkLevel 미만인 채널이 있는 (잉크) 픽셀 수. Gray, RGB, RGBA 는 SIMD 로 16byte 씩 센다.
+	// RGB 는 알파 바이트를 무시하고 RGBA 는 반 이상 불투명한 픽셀만 센다. Mono 는 검은(0) 비트 수
+	int64_t CountInkPixels(const Bitmap& bitmap, int inkLevel);
+
+	// 잉크 픽셀(CountInkPixels() 와 같은 기준)을 모두 포함하는 최소 영역. 잉크가 없으면 false
+	// 위, 아래 여백은 줄 전체를, 그 사이 줄은 이미 찾은 좌우 경계 바깥만 SIMD 로 확인한다.
+	bool FindContentBounds(const Bitmap& bitmap, int inkLevel, int& x, int& y, int& width, int& height);
+
+}} // PDF::Converter
@@ -0,0 +1,256 @@
+﻿// PDFJNIBinding.h
+#pragma once
+// C++ 함수 타입으로 JNI 메소드를 묶는다.
+// 시그니처 문자열은 컴파일 시간에 만들고, 호출은 인자 타입이 검사된 뒤 자바 예외를 확인한다.
+//   Method<Static, jboolean(jstring, jstring, jint)> convert;
+//   convert.Resolve(env, clazz, "ConvertPDFToImage");	// "(Ljava/lang/String;Ljava/lang/String;I)Z"
+//   convert(env, clazz, &result, sourceFile, targetDir, dpi);
+#include <jni.h>
+
+namespace PDF { namespace Converter {
+
+	template <char... C>
+	struct JNIChars
+	{
+		static constexpr char value[sizeof...(C) + 1] = { C..., '\0' };
+	}; // struct JNIChars
+
+	template <char... C>
+	constexpr char JNIChars<C...>::value[sizeof...(C) + 1];
+
+	template <typename... S>
+	struct JNIConcat;
+
+	template <>
+	struct JNIConcat<>
+	{
+		using type = JNIChars<>;
+	}; // struct JNIConcat
+
+	template <char... A>
+	struct JNIConcat<JNIChars<A...>>
+	{
+		using type = JNIChars<A...>;
+	}; // struct JNIConcat
+
+	template <char... A, char... B, typename... R>
+	struct JNIConcat<JNIChars<A...>, JNIChars<B...>, R...>
+	{
+		using type = typename JNIConcat<JNIChars<A..., B...>, R...>::type;
+	}; // struct JNIConcat
+
+	using JNIStringSignature = JNIChars<'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'S', 't', 'r', 'i', 'n', 'g', ';'>;
+	using JNIObjectSignature = JNIChars<'L', 'j', 'a', 'v', 'a', '/', 'l', 'a', 'n', 'g', '/', 'O', 'b', 'j', 'e', 'c', 't', ';'>;
+
+	// 타입별 시그니처와 Call<Type>Method 선택
+	template <typename T>
+	struct JNIType;
+
+	template <>
+	struct JNIType<void>
+	{
+		using signature = JNIChars<'V'>;
+		template <typename... A> static void CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { env->CallStaticVoidMethod(clazz, methodID, args...); }
+		template <typename... A> static void Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { env->CallVoidMethod(object, methodID, args...); }
+	}; // struct JNIType<void>
+
+	template <>
+	struct JNIType<jboolean>
+	{
+		using signature = JNIChars<'Z'>;
+		template <typename... A> static jboolean CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return env->CallStaticBooleanMethod(clazz, methodID, args...); }
+		template <typename... A> static jboolean Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return env->CallBooleanMethod(object, methodID, args...); }
+	}; // struct JNIType<jboolean>
+
+	template <>
+	struct JNIType<jint>
+	{
+		using signature = JNIChars<'I'>;
+		template <typename... A> static jint CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return env->CallStaticIntMethod(clazz, methodID, args...); }
+		template <typename... A> static jint Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return env->CallIntMethod(object, methodID, args...); }
+	}; // struct JNIType<jint>
+
+	template <>
+	struct JNIType<jlong>
+	{
+		using signature = JNIChars<'J'>;
+		template <typename... A> static jlong CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return env->CallStaticLongMethod(clazz, methodID, args...); }
+		template <typename... A> static jlong Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return env->CallLongMethod(object, methodID, args...); }
+	}; // struct JNIType<jlong>
+
+	template <>
+	struct JNIType<jfloat>
+	{
+		using signature = JNIChars<'F'>;
+		template <typename... A> static jfloat CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return env->CallStaticFloatMethod(clazz, methodID, args...); }
+		template <typename... A> static jfloat Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return env->CallFloatMethod(object, methodID, args...); }
+	}; // struct JNIType<jfloat>
+
+	template <>
+	struct JNIType<jobject>
+	{
+		using signature = JNIObjectSignature;
+		template <typename... A> static jobject CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return env->CallStaticObjectMethod(clazz, methodID, args...); }
+		template <typename... A> static jobject Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return env->CallObjectMethod(object, methodID, args...); }
+	}; // struct JNIType<jobject>
+
+	template <>
+	struct JNIType<jstring>
+	{
+		using signature = JNIStringSignature;
+		template <typename... A> static jstring CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return static_cast<jstring>(env->CallStaticObjectMethod(clazz, methodID, args...)); }
+		template <typename... A> static jstring Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return static_cast<jstring>(env->CallObjectMethod(object, methodID, args...)); }
+	}; // struct JNIType<jstring>
+
+	// 클래스 이름(JNIChars, "java/io/File" 형식)으로 구분하는 참조 타입. jobject 는 static_cast 로 바꿔 넘긴다.
+	template <typename Name>
+	class JObject : public _jobject {};
+
+	template <typename Name>
+	struct JNIType<JObject<Name>*>
+	{
+		using signature = typename JNIConcat<JNIChars<'L'>, Name, JNIChars<';'>>::type;
+		template <typename... A> static JObject<Name>* CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, A... args) { return static_cast<JObject<Name>*>(env->CallStaticObjectMethod(clazz, methodID, args...)); }
+		template <typename... A> static JObject<Name>* Call(JNIEnv* env, jobject object, jmethodID methodID, A... args) { return static_cast<JObject<Name>*>(env->CallObjectMethod(object, methodID, args...)); }
+	}; // struct JNIType<JObject<Name>*>
+
+	// 함수 타입 -> "(인자들)반환"
+	template <typename F>
+	struct JNISignature;
+
+	template <typename R, typename... A>
+	struct JNISignature<R(A...)>
+	{
+		using type = typename JNIConcat<JNIChars<'('>, typename JNIType<A>::signature..., JNIChars<')'>, typename JNIType<R>::signature>::type;
+		static constexpr const char* Value() { return type::value; }
+	}; // struct JNISignature
+
+	// 자바 예외가 있으면 출력하고 지운다.
+	inline bool JNISucceeded(JNIEnv* env, bool describe = true)
+	{
+		if (env->ExceptionCheck()) {
+			if (describe) {
+				env->ExceptionDescribe();
+			}
+			env->ExceptionClear();
+			return false;
+		}
+		return true;
+	}
+
+	template <typename R>
+	struct JNIInvoke
+	{
+		template <typename... A>
+		static bool CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, R* result, A... args)
+		{
+			const R value = JNIType<R>::CallStatic(env, clazz, methodID, args...);
+			return store(env, result, value);
+		}
+		template <typename... A>
+		static bool Call(JNIEnv* env, jobject object, jmethodID methodID, R* result, A... args)
+		{
+			const R value = JNIType<R>::Call(env, object, methodID, args...);
+			return store(env, result, value);
+		}
+
+	private:
+		static bool store(JNIEnv* env, R* result, R value)
+		{
+			if (!JNISucceeded(env)) {
+				return false;
+			}
+			if (result) {
+				*result = value;
+			}
+			return true;
+		}
+	}; // struct JNIInvoke
+
+	template <>
+	struct JNIInvoke<void>
+	{
+		template <typename... A>
+		static bool CallStatic(JNIEnv* env, jclass clazz, jmethodID methodID, void*, A... args)
+		{
+			JNIType<void>::CallStatic(env, clazz, methodID, args...);
+			return JNISucceeded(env);
+		}
+		template <typename... A>
+		static bool Call(JNIEnv* env, jobject object, jmethodID methodID, void*, A... args)
+		{
+			JNIType<void>::Call(env, object, methodID, args...);
+			return JNISucceeded(env);
+		}
+	}; // struct JNIInvoke<void>
+
+	struct Static {};
+	struct Instance {};
+
+	// 메소드 ID 조회와 호출. 자바 예외가 발생하면 출력하고 지운 뒤 Null, false 를 반환한다.
+	template <typename Kind, typename F>
+	struct Call;
+
+	template <typename R, typename... A>
+	struct Call<Static, R(A...)>
+	{
+		using Target = jclass;
+
+		static jmethodID Resolve(JNIEnv* env, jclass clazz, const char* name, bool optional)
+		{
+			jmethodID methodID = env->GetStaticMethodID(clazz, name, JNISignature<R(A...)>::Value());
+			return JNISucceeded(env, !optional) ? methodID : nullptr;
+		}
+		static bool Invoke(JNIEnv* env, jclass clazz, jmethodID methodID, R* result, A... args)
+		{
+			return JNIInvoke<R>::CallStatic(env, clazz, methodID, result, args...);
+		}
+	}; // struct Call<Static, R(A...)>
+
+	template <typename R, typename... A>
+	struct Call<Instance, R(A...)>
+	{
+		using Target = jobject;
+
+		static jmethodID Resolve(JNIEnv* env, jclass clazz, const char* name, bool optional)
+		{
+			jmethodID methodID = env->GetMethodID(clazz, name, JNISignature<R(A...)>::Value());
+			return JNISucceeded(env, !optional) ? methodID : nullptr;
+		}
+		static bool Invoke(JNIEnv* env, jobject object, jmethodID methodID, R* result, A... args)
+		{
+			return JNIInvoke<R>::Call(env, object, methodID, result, args...);
+		}
+	}; // struct Call<Instance, R(A...)>
+
+	// 조회한 메소드 ID 를 들고 있는 호출 객체. 메소드 ID 는 JavaVM 이 살아있는 동안 유효하다.
+	template <typename Kind, typename F>
+	class Method;
+
+	template <typename Kind, typename R, typename... A>
+	class Method<Kind, R(A...)>
+	{
+	public:
+		using Target = typename Call<Kind, R(A...)>::Target;
+
+		Method() : m_MethodID(nullptr) {}
+
+		// optional 이면 메소드가 없어도 NoSuchMethodError 를 출력하지 않는다.
+		bool Resolve(JNIEnv* env, jclass clazz, const char* name, bool optional = false)
+		{
+			m_MethodID = Call<Kind, R(A...)>::Resolve(env, clazz, name, optional);
+			return m_MethodID != nullptr;
+		}
+		void Reset() { m_MethodID = nullptr; }
+		explicit operator bool() const { return m_MethodID != nullptr; }
+
+		bool operator()(JNIEnv* env, Target target, R* result, A... args) const
+		{
+			return m_MethodID && Call<Kind, R(A...)>::Invoke(env, target, m_MethodID, result, args...);
+		}
+
+	private:
+		jmethodID m_MethodID;
+	}; // class Method
+
+}} // PDF::Converter
@@ -0,0 +1,109 @@
+﻿// PDFMappedFile.cpp
+#include "PDFMappedFile.h"
+
+#ifdef _WIN32
+#	include <windows.h> // CreateFileA, CreateFileMappingA, MapViewOfFile
+#else
+#	include <sys/mman.h> // mmap, munmap
+#	include <sys/stat.h> // fstat
+#	include <fcntl.h> // open
+#	include <unistd.h> // close
+#endif
+
+namespace PDF { namespace Converter {
+
+#ifdef _WIN32
+	MappedFile::MappedFile()
+	: m_File(INVALID_HANDLE_VALUE)
+	, m_Mapping(nullptr)
+	, m_Data(nullptr)
+	, m_Size(0)
+	{
+	}
+#else
+	MappedFile::MappedFile()
+	: m_File(-1)
+	, m_Data(nullptr)
+	, m_Size(0)
+	{
+	}
+#endif
+
+	MappedFile::~MappedFile()
+	{
+		Close();
+	}
+
+	bool MappedFile::Open(const char* path)
+	{
+		Close();
+#ifdef _WIN32
+		m_File = ::CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (m_File == INVALID_HANDLE_VALUE) {
+			return false;
+		}
+		LARGE_INTEGER size;
+		if (!::GetFileSizeEx(m_File, &size) || size.QuadPart == 0) {
+			Close();
+			return false;
+		}
+		m_Mapping = ::CreateFileMappingA(m_File, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		if (!m_Mapping) {
+			Close();
+			return false;
+		}
+		m_Data = static_cast<const unsigned char*>(::MapViewOfFile(m_Mapping, FILE_MAP_READ, 0, 0, 0));
+		if (!m_Data) {
+			Close();
+			return false;
+		}
+		m_Size = static_cast<size_t>(size.QuadPart);
+#else
+		m_File = ::open(path, O_RDONLY);
+		if (m_File < 0) {
+			return false;
+		}
+		struct stat st;
+		if (::fstat(m_File, &st) != 0 || st.st_size == 0) {
+			Close();
+			return false;
+		}
+		void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, m_File, 0);
+		if (data == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		m_Data = static_cast<const unsigned char*>(data);
+		m_Size = static_cast<size_t>(st.st_size);
+#endif
+		return true;
+	}
+
+	void MappedFile::Close()
+	{
+#ifdef _WIN32
+		if (m_Data) {
+			::UnmapViewOfFile(m_Data);
+		}
+		if (m_Mapping) {
+			::CloseHandle(m_Mapping);
+		}
+		if (m_File != INVALID_HANDLE_VALUE) {
+			::CloseHandle(m_File);
+		}
+		m_Mapping = nullptr;
+		m_File = INVALID_HANDLE_VALUE;
+#else
+		if (m_Data) {
+			::munmap(const_cast<unsigned char*>(m_Data), m_Size);
+		}
+		if (m_File >= 0) {
+			::close(m_File);
+		}
+		m_File = -1;
+#endif
+		m_Data = nullptr;
+		m_Size = 0;
+	}
+
+}} // PDF::Converter
@@ -0,0 +1,35 @@
+﻿// PDFMappedFile.h
+#pragma once
+#include <stddef.h> // size_t
+
+namespace PDF { namespace Converter {
+
+	// 읽기 전용 메모리 맵 파일 (Windows: CreateFileMapping, POSIX: mmap)
+	class MappedFile
+	{
+	public:
+		MappedFile();
+		~MappedFile();
+
+		bool Open(const char* path);
+		void Close();
+
+		const unsigned char* Data() const { return m_Data; }
+		size_t Size() const { return m_Size; }
+
+	private:
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+	private:
+#ifdef _WIN32
+		void* m_File;
+		void* m_Mapping;
+#else
+		int m_File;
+#endif
+		const unsigned char* m_Data;
+		size_t m_Size;
+	}; // class MappedFile
+
+}} // PDF::Converter
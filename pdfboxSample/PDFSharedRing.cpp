@@ -0,0 +1,460 @@
+﻿// PDFSharedRing.cpp
+#include "PDFSharedRing.h"
+#ifndef _WIN32
+#include <new> // placement new
+#include <cmath> // std::sqrt
+#include <algorithm> // std::min, std::max
+#include <chrono> // std::chrono
+#include <string.h> // memcpy, strncpy
+#include <errno.h> // errno
+#include <unistd.h> // close, ftruncate, unlink
+#include <poll.h> // poll
+#include <sys/mman.h> // memfd_create, mmap
+#include <sys/socket.h> // socket, sendmsg, recvmsg
+#include <sys/un.h> // sockaddr_un
+#include "pdf_assert.h"
+#include "pdf_utils.h"
+
+static const uint32_t SHARED_REGION_MAGIC = 0x50444252; // "PDBR"
+static const uint32_t SHARED_REGION_VERSION = 1;
+static const int POLL_INTERVAL_MS = 100; // Stop() 과 접속 종료를 확인하는 주기
+static const int MAX_TILE_SIZE = 16384;
+
+namespace {
+
+	size_t slotsOffset()
+	{
+		return (sizeof(PDF::Converter::SharedRegion) + 4095) & ~static_cast<size_t>(4095);
+	}
+
+	// 링에 넣었음을 알린다. 소켓 버퍼가 가득 차 있으면 이미 깨어날 이유가 있으므로 무시한다.
+	void ringDoorbell(int socket)
+	{
+		const char bell = 1;
+		send(socket, &bell, 1, MSG_NOSIGNAL | MSG_DONTWAIT);
+	}
+
+	// 초인종을 기다린다. 1 = 울렸다, 0 = 시간 초과, -1 = 상대가 접속을 끊었다.
+	int waitDoorbell(int socket, int timeoutMs)
+	{
+		pollfd pollSocket = { socket, POLLIN, 0 };
+		if (poll(&pollSocket, 1, timeoutMs) <= 0) {
+			return 0;
+		}
+		char bells[64];
+		const ssize_t received = recv(socket, bells, sizeof(bells), MSG_DONTWAIT);
+		if (received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR)) {
+			return -1;
+		}
+		return 1;
+	}
+
+	bool peerClosed(int socket)
+	{
+		char bell = 0;
+		const ssize_t received = recv(socket, &bell, 1, MSG_PEEK | MSG_DONTWAIT);
+		return received == 0 || (received < 0 && errno != EAGAIN && errno != EINTR);
+	}
+
+	bool sendDescriptor(int socket, int descriptor)
+	{
+		char data = 0;
+		iovec vector = { &data, 1 };
+		char control[CMSG_SPACE(sizeof(int))] = { 0, };
+		msghdr message = {};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		cmsghdr* header = CMSG_FIRSTHDR(&message);
+		header->cmsg_level = SOL_SOCKET;
+		header->cmsg_type = SCM_RIGHTS;
+		header->cmsg_len = CMSG_LEN(sizeof(int));
+		memcpy(CMSG_DATA(header), &descriptor, sizeof(int));
+		return sendmsg(socket, &message, MSG_NOSIGNAL) == 1;
+	}
+
+	int receiveDescriptor(int socket)
+	{
+		char data = 0;
+		iovec vector = { &data, 1 };
+		char control[CMSG_SPACE(sizeof(int))] = { 0, };
+		msghdr message = {};
+		message.msg_iov = &vector;
+		message.msg_iovlen = 1;
+		message.msg_control = control;
+		message.msg_controllen = sizeof(control);
+		if (recvmsg(socket, &message, MSG_CMSG_CLOEXEC) != 1) {
+			return -1;
+		}
+		cmsghdr* header = CMSG_FIRSTHDR(&message);
+		if (!header || header->cmsg_level != SOL_SOCKET || header->cmsg_type != SCM_RIGHTS) {
+			return -1;
+		}
+		int descriptor = -1;
+		memcpy(&descriptor, CMSG_DATA(header), sizeof(int));
+		return descriptor;
+	}
+
+	bool socketAddress(const std::string& socketPath, sockaddr_un& address)
+	{
+		memset(&address, 0, sizeof(address));
+		address.sun_family = AF_UNIX;
+		if (socketPath.empty() || socketPath.size() >= sizeof(address.sun_path)) {
+			return false;
+		}
+		strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+		return true;
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	SharedRingServer::SharedRingServer(PDFBox& pdfBox, const SharedRingOptions& options)
+	: m_PDFBox(pdfBox)
+	, m_Options(options)
+	, m_Stopped(false)
+	{
+		m_Options.slotCount = std::max(std::min(m_Options.slotCount, SHARED_MAX_SLOTS), 1u);
+	}
+
+	SharedRingServer::~SharedRingServer()
+	{
+		Stop();
+		for (std::thread& client : m_Clients) {
+			client.join();
+		}
+	}
+
+	bool SharedRingServer::Serve(const std::string& socketPath, const std::function<void()>& onListening /*= nullptr*/)
+	{
+		sockaddr_un address;
+		if (!socketAddress(socketPath, address)) {
+			return false;
+		}
+		int listener = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		_ASSERTE(listener >= 0 && "socket() Failed");
+		if (listener < 0) {
+			return false;
+		}
+		unlink(socketPath.c_str());
+		if (bind(listener, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0) {
+			close(listener);
+			return false;
+		}
+		if (onListening) {
+			onListening();
+		}
+
+		while (!m_Stopped) {
+			pollfd pollListener = { listener, POLLIN, 0 };
+			if (poll(&pollListener, 1, POLL_INTERVAL_MS) <= 0) {
+				joinFinishedClients();
+				continue;
+			}
+			int client = accept4(listener, nullptr, nullptr, SOCK_CLOEXEC);
+			if (client < 0) {
+				continue;
+			}
+			joinFinishedClients();
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Clients.emplace_back(&SharedRingServer::serveClient, this, client);
+		}
+
+		close(listener);
+		unlink(socketPath.c_str());
+		// 끝나는 스레드가 m_Mutex 를 잡으므로 잠그지 않고 기다린다.
+		std::vector<std::thread> clients;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			clients.swap(m_Clients);
+			m_FinishedClients.clear();
+		}
+		for (std::thread& client : clients) {
+			client.join();
+		}
+		return true;
+	}
+
+	void SharedRingServer::joinFinishedClients()
+	{
+		std::vector<std::thread> finished;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			for (const std::thread::id& id : m_FinishedClients) {
+				auto found = std::find_if(m_Clients.begin(), m_Clients.end(), [&](const std::thread& client) { return client.get_id() == id; });
+				if (found != m_Clients.end()) {
+					finished.push_back(std::move(*found));
+					m_Clients.erase(found);
+				}
+			}
+			m_FinishedClients.clear();
+		}
+		for (std::thread& client : finished) {
+			client.join();
+		}
+	}
+
+	void SharedRingServer::Stop()
+	{
+		m_Stopped = true;
+	}
+
+	void SharedRingServer::serveClient(int socket)
+	{
+		const size_t regionBytes = slotsOffset() + static_cast<size_t>(m_Options.slotCount) * m_Options.slotBytes;
+		int memfd = memfd_create("pdfbox-ring", MFD_CLOEXEC);
+		void* base = MAP_FAILED;
+		if (memfd >= 0 && ftruncate(memfd, static_cast<off_t>(regionBytes)) == 0) {
+			base = mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+		}
+		if (base == MAP_FAILED) {
+			if (memfd >= 0) {
+				close(memfd);
+			}
+			close(socket);
+			return;
+		}
+
+		SharedRegion* region = new (base) SharedRegion();
+		region->magic = SHARED_REGION_MAGIC;
+		region->version = SHARED_REGION_VERSION;
+		region->slotCount = m_Options.slotCount;
+		region->slotBytes = m_Options.slotBytes;
+		region->slotsOffset = slotsOffset();
+		region->regionBytes = regionBytes;
+		region->jobs.Init();
+		region->results.Init();
+		region->freeSlots.Init();
+		for (uint32_t slot = 0; slot < m_Options.slotCount; slot++) {
+			region->freeSlots.TryPush(slot);
+		}
+
+		// 매핑은 디스크립터를 닫아도 유지된다.
+		const bool sent = sendDescriptor(socket, memfd);
+		close(memfd);
+		while (sent && !m_Stopped) {
+			SharedJob job;
+			while (!m_Stopped && region->jobs.TryPop(job)) {
+				if (!runJob(socket, region, static_cast<unsigned char*>(base), job)) {
+					break;
+				}
+			}
+			if (waitDoorbell(socket, POLL_INTERVAL_MS) < 0) {
+				break;
+			}
+		}
+
+		munmap(base, regionBytes);
+		close(socket);
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_FinishedClients.push_back(std::this_thread::get_id());
+	}
+
+	bool SharedRingServer::runJob(int socket, SharedRegion* region, unsigned char* base, const SharedJob& job)
+	{
+		// 헤더와 빈 슬롯 링은 클라이언트도 쓸 수 있으므로 슬롯 위치는 서버가 정한 값만 사용한다.
+		const uint32_t slotCount = m_Options.slotCount;
+		const uint32_t slotBytes = m_Options.slotBytes;
+		unsigned char* slots = base + slotsOffset();
+
+		// 클라이언트가 링을 비우거나 슬롯을 돌려줄 때까지 기다린다. 접속이 끊기면 변환을 중단한다.
+		bool connected = true;
+		auto waitClient = [&]() -> bool {
+			if (m_Stopped || peerClosed(socket)) {
+				connected = false;
+				return false;
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			return true;
+		};
+		auto pushResult = [&](const SharedResult& result) -> bool {
+			while (!region->results.TryPush(result)) {
+				if (!waitClient()) {
+					return false;
+				}
+			}
+			ringDoorbell(socket);
+			return true;
+		};
+		auto acquireSlot = [&](uint32_t* slot) -> bool {
+			while (!region->freeSlots.TryPop(*slot)) {
+				if (!waitClient()) {
+					return false;
+				}
+			}
+			if (*slot >= slotCount) {
+				connected = false; // 잘못된 슬롯을 돌려준 클라이언트는 접속을 끊는다.
+				return false;
+			}
+			return true;
+		};
+
+		const std::string sourceFile(job.sourceFile, strnlen(job.sourceFile, sizeof(job.sourceFile)));
+		bool result = false;
+		if (job.type == SharedJobType::Image) {
+			ImageOptions options;
+			options.dpi = job.dpi > 0 ? job.dpi : options.dpi;
+			options.format = (job.format > 0 && job.format <= static_cast<int32_t>(PixelFormat::RGBA)) ? static_cast<PixelFormat>(job.format) : PixelFormat::RGB;
+			// 가장 큰 (RGB, RGBA) 타일이 슬롯 하나에 들어가도록 한다.
+			options.tileSize = std::min(static_cast<int>(std::sqrt(slotBytes / 4.0)), MAX_TILE_SIZE);
+			options.tileSink = [&](const ImageTile& tile, const Bitmap& bitmap) -> bool {
+				const size_t bytes = bitmap.pixels.size();
+				uint32_t slot = 0;
+				if (bytes > slotBytes || !acquireSlot(&slot)) {
+					return false;
+				}
+				memcpy(slots + static_cast<size_t>(slot) * slotBytes, bitmap.pixels.data(), bytes);
+				SharedResult tileResult = {};
+				tileResult.id = job.id;
+				tileResult.type = SharedResultType::Tile;
+				tileResult.pageIndex = tile.pageIndex;
+				tileResult.x = tile.x;
+				tileResult.y = tile.y;
+				tileResult.width = bitmap.width;
+				tileResult.height = bitmap.height;
+				tileResult.stride = bitmap.stride;
+				tileResult.pageWidth = tile.pageWidth;
+				tileResult.pageHeight = tile.pageHeight;
+				tileResult.format = static_cast<int32_t>(bitmap.format);
+				tileResult.slot = static_cast<int32_t>(slot);
+				tileResult.bytes = bytes;
+				return pushResult(tileResult);
+			};
+			result = options.tileSize > 0 && m_PDFBox.ToImage(_A2U(sourceFile).c_str(), L"", options);
+		} else if (job.type == SharedJobType::Text) {
+			TextOptions options;
+			options.textSink = [&](int pageIndex, const std::string& text) -> bool {
+				for (size_t offset = 0; offset < text.size(); offset += slotBytes) {
+					const size_t bytes = std::min<size_t>(text.size() - offset, slotBytes);
+					uint32_t slot = 0;
+					if (!acquireSlot(&slot)) {
+						return false;
+					}
+					memcpy(slots + static_cast<size_t>(slot) * slotBytes, text.data() + offset, bytes);
+					SharedResult textResult = {};
+					textResult.id = job.id;
+					textResult.type = SharedResultType::Text;
+					textResult.pageIndex = pageIndex;
+					textResult.slot = static_cast<int32_t>(slot);
+					textResult.bytes = bytes;
+					if (!pushResult(textResult)) {
+						return false;
+					}
+				}
+				return true;
+			};
+			result = m_PDFBox.ToText(_A2U(sourceFile).c_str(), L"", options);
+		}
+
+		SharedResult done = {};
+		done.id = job.id;
+		done.type = SharedResultType::Done;
+		done.status = result ? 1 : 0;
+		done.slot = -1;
+		return connected && pushResult(done);
+	}
+
+	SharedRingClient::SharedRingClient()
+	: m_Socket(-1)
+	, m_Region(nullptr)
+	, m_RegionBytes(0)
+	{
+	}
+
+	SharedRingClient::~SharedRingClient()
+	{
+		Close();
+	}
+
+	bool SharedRingClient::Connect(const std::string& socketPath)
+	{
+		sockaddr_un address;
+		if (m_Socket >= 0 || !socketAddress(socketPath, address)) {
+			return false;
+		}
+		m_Socket = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (m_Socket < 0 || connect(m_Socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) != 0) {
+			Close();
+			return false;
+		}
+
+		int memfd = receiveDescriptor(m_Socket);
+		if (memfd < 0) {
+			Close();
+			return false;
+		}
+		// 헤더만 먼저 매핑해서 전체 크기를 읽는다.
+		void* header = mmap(nullptr, sizeof(SharedRegion), PROT_READ, MAP_SHARED, memfd, 0);
+		size_t regionBytes = 0;
+		if (header != MAP_FAILED) {
+			const SharedRegion* region = static_cast<const SharedRegion*>(header);
+			if (region->magic == SHARED_REGION_MAGIC && region->version == SHARED_REGION_VERSION) {
+				regionBytes = static_cast<size_t>(region->regionBytes);
+			}
+			munmap(header, sizeof(SharedRegion));
+		}
+		void* base = regionBytes ? mmap(nullptr, regionBytes, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0) : MAP_FAILED;
+		close(memfd);
+		if (base == MAP_FAILED) {
+			Close();
+			return false;
+		}
+		m_Region = static_cast<SharedRegion*>(base);
+		m_RegionBytes = regionBytes;
+		return true;
+	}
+
+	void SharedRingClient::Close()
+	{
+		if (m_Region) {
+			munmap(m_Region, m_RegionBytes);
+			m_Region = nullptr;
+			m_RegionBytes = 0;
+		}
+		if (m_Socket >= 0) {
+			close(m_Socket);
+			m_Socket = -1;
+		}
+	}
+
+	bool SharedRingClient::Submit(const SharedJob& job)
+	{
+		if (!m_Region || !m_Region->jobs.TryPush(job)) {
+			return false;
+		}
+		ringDoorbell(m_Socket);
+		return true;
+	}
+
+	bool SharedRingClient::Poll(SharedResult& result, int timeoutMs)
+	{
+		if (!m_Region) {
+			return false;
+		}
+		if (m_Region->results.TryPop(result)) {
+			return true;
+		}
+		// 초인종이 울린 뒤에도 결과가 아직 안 보일 수 있으므로 한번 더 확인한다.
+		waitDoorbell(m_Socket, timeoutMs);
+		return m_Region->results.TryPop(result);
+	}
+
+	const unsigned char* SharedRingClient::Slot(const SharedResult& result) const
+	{
+		if (!m_Region || result.slot < 0 || static_cast<uint32_t>(result.slot) >= m_Region->slotCount) {
+			return nullptr;
+		}
+		return reinterpret_cast<const unsigned char*>(m_Region) + m_Region->slotsOffset + static_cast<size_t>(result.slot) * m_Region->slotBytes;
+	}
+
+	void SharedRingClient::Release(const SharedResult& result)
+	{
+		if (m_Region && result.slot >= 0 && static_cast<uint32_t>(result.slot) < m_Region->slotCount) {
+			m_Region->freeSlots.TryPush(static_cast<uint32_t>(result.slot));
+		}
+	}
+
+}} // PDF::Converter
+
+#endif // _WIN32
@@ -0,0 +1,204 @@
+﻿// PDFSharedRing.h
+#pragma once
+// 같은 호스트의 클라이언트용 공유 메모리 전송 (리눅스 전용)
+// 유닉스 소켓으로 접속하면 서버가 memfd 영역을 만들어 파일 디스크립터를 넘겨준다.
+// 작업 링, 결과 링, 빈 슬롯 링은 락 없는 MPMC 큐이며 렌더링된 픽셀과 텍스트는 슬롯에 바로 쓰여서
+// 클라이언트는 복사 없이 읽는다. 소켓은 링에 넣었음을 알리는 1byte 초인종으로만 쓴다.
+#ifndef _WIN32
+#include <atomic> // std::atomic
+#include <string> // std::string
+#include <thread> // std::thread
+#include <mutex> // std::mutex
+#include <vector> // std::vector
+#include <functional> // std::function
+#include <stdint.h> // uint32_t, uint64_t
+#include "PDFBoxConverter.h"
+
+namespace PDF { namespace Converter {
+
+	static_assert(ATOMIC_LLONG_LOCK_FREE == 2, "shared memory ring needs lock-free 64bit atomics");
+
+	// 프로세스 사이에서 공유하는 고정 크기 MPMC 큐 (Vyukov bounded queue)
+	template <typename T, uint32_t N>
+	struct SharedRing
+	{
+		static_assert((N & (N - 1)) == 0, "N must be power of 2");
+
+		struct Cell
+		{
+			std::atomic<uint64_t> sequence;
+			T data;
+		};
+
+		alignas(64) std::atomic<uint64_t> enqueuePos;
+		alignas(64) std::atomic<uint64_t> dequeuePos;
+		alignas(64) Cell cells[N];
+
+		void Init()
+		{
+			for (uint32_t i = 0; i < N; i++) {
+				cells[i].sequence.store(i, std::memory_order_relaxed);
+			}
+			enqueuePos.store(0, std::memory_order_relaxed);
+			dequeuePos.store(0, std::memory_order_release);
+		}
+
+		bool TryPush(const T& value)
+		{
+			uint64_t pos = enqueuePos.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell& cell = cells[pos & (N - 1)];
+				const int64_t diff = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(pos);
+				if (diff == 0) {
+					if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						cell.data = value;
+						cell.sequence.store(pos + 1, std::memory_order_release);
+						return true;
+					}
+				} else if (diff < 0) {
+					return false; // 가득 찼다.
+				} else {
+					pos = enqueuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+
+		bool TryPop(T& value)
+		{
+			uint64_t pos = dequeuePos.load(std::memory_order_relaxed);
+			for (;;) {
+				Cell& cell = cells[pos & (N - 1)];
+				const int64_t diff = static_cast<int64_t>(cell.sequence.load(std::memory_order_acquire)) - static_cast<int64_t>(pos + 1);
+				if (diff == 0) {
+					if (dequeuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+						value = cell.data;
+						cell.sequence.store(pos + N, std::memory_order_release);
+						return true;
+					}
+				} else if (diff < 0) {
+					return false; // 비었다.
+				} else {
+					pos = dequeuePos.load(std::memory_order_relaxed);
+				}
+			}
+		}
+	}; // struct SharedRing
+
+	enum class SharedJobType : uint32_t
+	{
+		Image,
+		Text
+	}; // enum class SharedJobType
+
+	struct SharedJob
+	{
+		uint64_t id;
+		SharedJobType type;
+		int32_t dpi;
+		int32_t format;			// PixelFormat (Default 는 RGB)
+		char sourceFile[1024];	// 로케일 인코딩 경로 (명령행 인자와 같다)
+	}; // struct SharedJob
+
+	enum class SharedResultType : uint32_t
+	{
+		Tile,	// 슬롯에 픽셀 (ImageTile 위치)
+		Text,	// 슬롯에 UTF-8 텍스트 (페이지가 슬롯보다 크면 여러 개로 나뉜다)
+		Done	// 작업 종료, status = 변환 결과
+	}; // enum class SharedResultType
+
+	struct SharedResult
+	{
+		uint64_t id;
+		SharedResultType type;
+		int32_t status;			// Done : 1 = 성공, 0 = 실패
+		int32_t pageIndex;
+		int32_t x;
+		int32_t y;
+		int32_t width;
+		int32_t height;
+		int32_t stride;
+		int32_t pageWidth;
+		int32_t pageHeight;
+		int32_t format;
+		int32_t slot;			// 다 읽으면 SharedRingClient::Release() 로 돌려준다. Done 은 -1
+		uint64_t bytes;
+	}; // struct SharedResult
+
+	static const uint32_t SHARED_JOB_RING_SIZE = 64;
+	static const uint32_t SHARED_RESULT_RING_SIZE = 256;
+	static const uint32_t SHARED_MAX_SLOTS = 64;
+
+	// memfd 영역 맨 앞의 헤더. 슬롯은 slotsOffset 부터 slotBytes 간격으로 놓인다.
+	struct SharedRegion
+	{
+		uint32_t magic;
+		uint32_t version;
+		uint32_t slotCount;
+		uint32_t slotBytes;
+		uint64_t slotsOffset;
+		uint64_t regionBytes;
+		SharedRing<SharedJob, SHARED_JOB_RING_SIZE> jobs;
+		SharedRing<SharedResult, SHARED_RESULT_RING_SIZE> results;
+		SharedRing<uint32_t, SHARED_MAX_SLOTS> freeSlots;
+	}; // struct SharedRegion
+
+	struct SharedRingOptions
+	{
+		uint32_t slotCount = 16;
+		uint32_t slotBytes = 8 * 1024 * 1024; // 타일 한 변은 이 크기에 들어가게 정한다.
+	}; // struct SharedRingOptions
+
+	// 접속한 클라이언트마다 공유 영역과 스레드를 하나씩 만든다.
+	class SharedRingServer
+	{
+	public:
+		SharedRingServer(PDFBox& pdfBox, const SharedRingOptions& options);
+		~SharedRingServer();
+
+	public:
+		// Stop() 할 때까지 반환하지 않는다. onListening 은 접속을 받기 시작할 때 한번 호출된다.
+		bool Serve(const std::string& socketPath, const std::function<void()>& onListening = nullptr);
+		void Stop(); // 시그널 핸들러에서 호출할 수 있다.
+
+	private:
+		void serveClient(int socket);
+		bool runJob(int socket, SharedRegion* region, unsigned char* base, const SharedJob& job);
+		void joinFinishedClients();
+
+	private:
+		PDFBox& m_PDFBox;
+		SharedRingOptions m_Options;
+		std::atomic<bool> m_Stopped;
+		std::mutex m_Mutex;
+		std::vector<std::thread> m_Clients;
+		std::vector<std::thread::id> m_FinishedClients; // 접속이 끊겨 join() 을 기다리는 스레드
+	}; // class SharedRingServer
+
+	class SharedRingClient
+	{
+	public:
+		SharedRingClient();
+		~SharedRingClient();
+
+	public:
+		bool Connect(const std::string& socketPath);
+		void Close();
+
+		bool Submit(const SharedJob& job); // 작업 링이 가득 찼으면 false
+		bool Poll(SharedResult& result, int timeoutMs); // 결과가 없으면 timeoutMs 동안 기다린다.
+		const unsigned char* Slot(const SharedResult& result) const;
+		void Release(const SharedResult& result);
+
+	private:
+		SharedRingClient(const SharedRingClient&) = delete;
+		SharedRingClient& operator=(const SharedRingClient&) = delete;
+
+	private:
+		int m_Socket;
+		SharedRegion* m_Region;
+		size_t m_RegionBytes;
+	}; // class SharedRingClient
+
+}} // PDF::Converter
+
+#endif // _WIN32
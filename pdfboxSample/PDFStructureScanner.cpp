@@ -0,0 +1,1123 @@
+﻿// PDFStructureScanner.cpp
+#include "PDFStructureScanner.h"
+#include "PDFMappedFile.h"
+#include "PDFFlate.h"
+#include "pdf_utils.h"
+#include <map> // std::map
+#include <set> // std::set
+#include <memory> // std::unique_ptr
+#include <algorithm> // std::search, std::min, std::max
+#include <string.h> // memcmp
+#include <stdlib.h> // strtod
+#include <stdint.h> // INT64_MAX, INT32_MAX
+#include <math.h> // floor
+#include <float.h> // FLT_MAX
+
+namespace {
+
+	const int MAX_NESTING = 64;             // 배열/딕셔너리 중첩 한도
+	const int MAX_PAGE_TREE_DEPTH = 64;     // 페이지 트리 깊이 한도
+	const int MAX_OBJECT_NUMBER = 8 * 1024 * 1024;
+	const size_t HEADER_SEARCH_SIZE = 1024;
+	const size_t STARTXREF_SEARCH_SIZE = 4096;
+
+	// PDF 오브젝트 (스트림은 딕셔너리 + 데이터 위치)
+	struct Object
+	{
+		enum class Type { Null, Boolean, Number, String, Name, Array, Dictionary, Reference };
+
+		Type type = Type::Null;
+		bool boolean = false;
+		double number = 0.0;
+		int objectNumber = 0;
+		int generation = 0;
+		std::string text;               // 이름, 문자열
+		std::vector<std::string> keys;  // 딕셔너리 키 (items 와 같은 순서)
+		std::vector<Object> items;      // 배열 원소, 딕셔너리 값
+		bool stream = false;
+		size_t streamOffset = 0;
+
+		const Object* Get(const char* key) const
+		{
+			if (type != Type::Dictionary) {
+				return nullptr;
+			}
+			for (size_t i = 0; i < keys.size(); i++) {
+				if (keys[i] == key) {
+					return &items[i];
+				}
+			}
+			return nullptr;
+		}
+
+		bool IsName(const char* name) const
+		{
+			return type == Type::Name && text == name;
+		}
+	}; // struct Object
+
+	// 파일의 숫자는 신뢰할 수 없으므로 정수이고 범위 안일 때만 변환한다. (NaN 은 비교에서 걸러진다.)
+	bool integerValue(const Object& object, int64_t minimum, int64_t maximum, int64_t& value)
+	{
+		if (object.type != Object::Type::Number || !(object.number >= static_cast<double>(minimum) && object.number <= static_cast<double>(maximum))
+			|| floor(object.number) != object.number) {
+			return false;
+		}
+		value = static_cast<int64_t>(object.number);
+		return true;
+	}
+
+	bool isWhite(unsigned char c)
+	{
+		return c == 0 || c == '\t' || c == '\n' || c == '\f' || c == '\r' || c == ' ';
+	}
+
+	bool isDelimiter(unsigned char c)
+	{
+		return c == '(' || c == ')' || c == '<' || c == '>' || c == '[' || c == ']' || c == '{' || c == '}' || c == '/' || c == '%';
+	}
+
+	bool isDigit(unsigned char c)
+	{
+		return c >= '0' && c <= '9';
+	}
+
+	int hexValue(unsigned char c)
+	{
+		if (c >= '0' && c <= '9') {
+			return c - '0';
+		}
+		if (c >= 'a' && c <= 'f') {
+			return c - 'a' + 10;
+		}
+		if (c >= 'A' && c <= 'F') {
+			return c - 'A' + 10;
+		}
+		return -1;
+	}
+
+	const unsigned char* findBytes(const unsigned char* begin, const unsigned char* end, const char* needle)
+	{
+		return std::search(begin, end, needle, needle + strlen(needle));
+	}
+
+	const unsigned char* findLastBytes(const unsigned char* begin, const unsigned char* end, const char* needle)
+	{
+		const size_t length = strlen(needle);
+		if (static_cast<size_t>(end - begin) < length) {
+			return nullptr;
+		}
+		for (const unsigned char* it = end - length; ; it--) {
+			if (memcmp(it, needle, length) == 0) {
+				return it;
+			}
+			if (it == begin) {
+				return nullptr;
+			}
+		}
+	}
+
+	// 토큰 단위 파서 (파일 또는 풀어낸 오브젝트 스트림 위에서 동작)
+	class Lexer
+	{
+	public:
+		Lexer(const unsigned char* data, size_t size, size_t position)
+		: m_Data(data)
+		, m_Size(size)
+		, m_Position(position)
+		{
+		}
+
+		size_t Position() const { return m_Position; }
+		bool AtEnd() const { return m_Position >= m_Size; }
+
+		void SkipWhite()
+		{
+			while (m_Position < m_Size) {
+				const unsigned char c = m_Data[m_Position];
+				if (isWhite(c)) {
+					m_Position++;
+				} else if (c == '%') {
+					while (m_Position < m_Size && m_Data[m_Position] != '\r' && m_Data[m_Position] != '\n') {
+						m_Position++;
+					}
+				} else {
+					break;
+				}
+			}
+		}
+
+		bool ReadInteger(int64_t& value)
+		{
+			SkipWhite();
+			size_t position = m_Position;
+			bool negative = false;
+			if (position < m_Size && (m_Data[position] == '+' || m_Data[position] == '-')) {
+				negative = m_Data[position] == '-';
+				position++;
+			}
+			if (position >= m_Size || !isDigit(m_Data[position])) {
+				return false;
+			}
+			value = 0;
+			while (position < m_Size && isDigit(m_Data[position])) {
+				if (value < (INT64_MAX - 9) / 10) {
+					value = value * 10 + (m_Data[position] - '0');
+				}
+				position++;
+			}
+			if (negative) {
+				value = -value;
+			}
+			m_Position = position;
+			return true;
+		}
+
+		bool MatchKeyword(const char* keyword)
+		{
+			SkipWhite();
+			const size_t length = strlen(keyword);
+			if (m_Size - m_Position < length || memcmp(m_Data + m_Position, keyword, length) != 0) {
+				return false;
+			}
+			const size_t next = m_Position + length;
+			if (next < m_Size && !isWhite(m_Data[next]) && !isDelimiter(m_Data[next])) {
+				return false;
+			}
+			m_Position = next;
+			return true;
+		}
+
+		// "stream" 키워드 다음 줄바꿈 (CRLF 또는 LF) 을 건너뛴다.
+		void SkipStreamEOL()
+		{
+			if (m_Position < m_Size && m_Data[m_Position] == '\r') {
+				m_Position++;
+			}
+			if (m_Position < m_Size && m_Data[m_Position] == '\n') {
+				m_Position++;
+			}
+		}
+
+		bool ParseObject(Object& out, int depth = 0)
+		{
+			out = Object();
+			if (depth > MAX_NESTING) {
+				return false;
+			}
+			SkipWhite();
+			if (AtEnd()) {
+				return false;
+			}
+
+			const unsigned char c = m_Data[m_Position];
+			if (c == '/') {
+				m_Position++;
+				out.type = Object::Type::Name;
+				readName(out.text);
+				return true;
+			}
+			if (c == '<' && m_Position + 1 < m_Size && m_Data[m_Position + 1] == '<') {
+				m_Position += 2;
+				out.type = Object::Type::Dictionary;
+				for (;;) {
+					SkipWhite();
+					if (AtEnd()) {
+						return false;
+					}
+					if (m_Data[m_Position] == '>') {
+						if (m_Position + 1 < m_Size && m_Data[m_Position + 1] == '>') {
+							m_Position += 2;
+							return true;
+						}
+						return false;
+					}
+					if (m_Data[m_Position] != '/') {
+						return false;
+					}
+					m_Position++;
+					std::string key;
+					readName(key);
+					Object value;
+					if (!ParseObject(value, depth + 1)) {
+						return false;
+					}
+					out.keys.push_back(key);
+					out.items.push_back(std::move(value));
+				}
+			}
+			if (c == '<') {
+				m_Position++;
+				out.type = Object::Type::String;
+				while (m_Position < m_Size && m_Data[m_Position] != '>') {
+					out.text.push_back(static_cast<char>(m_Data[m_Position++]));
+				}
+				if (AtEnd()) {
+					return false;
+				}
+				m_Position++;
+				return true;
+			}
+			if (c == '(') {
+				out.type = Object::Type::String;
+				return readLiteralString(out.text);
+			}
+			if (c == '[') {
+				m_Position++;
+				out.type = Object::Type::Array;
+				for (;;) {
+					SkipWhite();
+					if (AtEnd()) {
+						return false;
+					}
+					if (m_Data[m_Position] == ']') {
+						m_Position++;
+						return true;
+					}
+					Object item;
+					if (!ParseObject(item, depth + 1)) {
+						return false;
+					}
+					out.items.push_back(std::move(item));
+				}
+			}
+			if (isDigit(c) || c == '+' || c == '-' || c == '.') {
+				return readNumberOrReference(out);
+			}
+
+			std::string keyword;
+			while (m_Position < m_Size && !isWhite(m_Data[m_Position]) && !isDelimiter(m_Data[m_Position])) {
+				keyword.push_back(static_cast<char>(m_Data[m_Position++]));
+			}
+			if (keyword == "true" || keyword == "false") {
+				out.type = Object::Type::Boolean;
+				out.boolean = keyword == "true";
+				return true;
+			}
+			return keyword == "null";
+		}
+
+	private:
+		void readName(std::string& name)
+		{
+			while (m_Position < m_Size && !isWhite(m_Data[m_Position]) && !isDelimiter(m_Data[m_Position])) {
+				unsigned char c = m_Data[m_Position++];
+				if (c == '#' && m_Position + 1 < m_Size) {
+					const int high = hexValue(m_Data[m_Position]);
+					const int low = hexValue(m_Data[m_Position + 1]);
+					if (high >= 0 && low >= 0) {
+						c = static_cast<unsigned char>((high << 4) | low);
+						m_Position += 2;
+					}
+				}
+				name.push_back(static_cast<char>(c));
+			}
+		}
+
+		// 괄호 중첩과 이스케이프만 처리하고 원문을 그대로 둔다.
+		bool readLiteralString(std::string& text)
+		{
+			int nesting = 0;
+			while (m_Position < m_Size) {
+				const unsigned char c = m_Data[m_Position++];
+				if (c == '\\') {
+					if (m_Position < m_Size) {
+						text.push_back(static_cast<char>(m_Data[m_Position++]));
+					}
+					continue;
+				}
+				if (c == '(') {
+					if (nesting++ == 0) {
+						continue;
+					}
+				} else if (c == ')') {
+					if (--nesting == 0) {
+						return true;
+					}
+				}
+				text.push_back(static_cast<char>(c));
+			}
+			return false;
+		}
+
+		bool readNumberOrReference(Object& out)
+		{
+			std::string token;
+			bool integer = true;
+			while (m_Position < m_Size) {
+				const unsigned char c = m_Data[m_Position];
+				if (c == '.') {
+					integer = false;
+				} else if (!isDigit(c) && !((c == '+' || c == '-') && token.empty())) {
+					break;
+				}
+				token.push_back(static_cast<char>(c));
+				m_Position++;
+			}
+			out.type = Object::Type::Number;
+			out.number = strtod(token.c_str(), nullptr);
+			if (!integer || out.number < 0) {
+				return true;
+			}
+
+			// "N G R" 간접 참조인지 미리 읽어 본다.
+			const size_t saved = m_Position;
+			int64_t generation = 0;
+			if (ReadInteger(generation) && generation >= 0 && MatchKeyword("R")) {
+				out.type = Object::Type::Reference;
+				out.objectNumber = static_cast<int>(std::min(out.number, static_cast<double>(INT32_MAX)));
+				out.generation = static_cast<int>(std::min<int64_t>(generation, INT32_MAX));
+				return true;
+			}
+			m_Position = saved;
+			return true;
+		}
+
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+		size_t m_Position;
+	}; // class Lexer
+
+	struct XRefEntry
+	{
+		enum class Type : unsigned char { None, Free, InFile, Compressed };
+
+		Type type = Type::None;
+		uint64_t offset = 0;      // InFile: 파일 위치, Compressed: 오브젝트 스트림 번호
+		unsigned int index = 0;   // Compressed: 오브젝트 스트림 내 순번
+	}; // struct XRefEntry
+
+	struct ObjectStream
+	{
+		std::vector<unsigned char> data;
+		std::vector<std::pair<int, size_t>> objects; // (오브젝트 번호, First 기준 위치)
+		size_t first = 0;
+	}; // struct ObjectStream
+
+	// 페이지 트리에서 상속되는 속성
+	struct InheritedAttributes
+	{
+		float mediaBox[4] = { 0.0f, 0.0f, 612.0f, 792.0f };
+		float cropBox[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+		bool hasCropBox = false;
+		int rotate = 0;
+	}; // struct InheritedAttributes
+
+	class StructureParser
+	{
+	public:
+		StructureParser(const unsigned char* data, size_t size)
+		: m_Data(data)
+		, m_Size(size)
+		, m_ObjectLimit(static_cast<int>(std::min(size, static_cast<size_t>(MAX_OBJECT_NUMBER))))
+		, m_XRefStream(false)
+		{
+		}
+
+		bool Scan(PDF::Converter::DocumentStructure& structure)
+		{
+			structure = PDF::Converter::DocumentStructure();
+			structure.fileSize = static_cast<int64_t>(m_Size);
+
+			const unsigned char* headerEnd = m_Data + std::min(m_Size, HEADER_SEARCH_SIZE);
+			const unsigned char* header = findBytes(m_Data, headerEnd, "%PDF-");
+			if (header == headerEnd) {
+				return false;
+			}
+			for (const unsigned char* it = header + 5; it < headerEnd && !isWhite(*it) && !isDelimiter(*it); it++) {
+				structure.version.push_back(static_cast<char>(*it));
+			}
+
+			Object linearization;
+			structure.linearized = readLinearization(static_cast<size_t>(header - m_Data), linearization);
+
+			bool loaded = false;
+			const unsigned char* tailBegin = m_Data + (m_Size > STARTXREF_SEARCH_SIZE ? m_Size - STARTXREF_SEARCH_SIZE : 0);
+			const unsigned char* startxref = findLastBytes(tailBegin, m_Data + m_Size, "startxref");
+			if (startxref) {
+				Lexer lexer(m_Data, m_Size, static_cast<size_t>(startxref - m_Data) + 9);
+				int64_t offset = 0;
+				if (lexer.ReadInteger(offset) && offset >= 0) {
+					loaded = readXRefChain(static_cast<size_t>(offset));
+				}
+			}
+
+			Object root;
+			if (!loaded || !resolveEntry(m_Trailer.Get("Root"), root) || root.type != Object::Type::Dictionary) {
+				// xref 가 손상되었으면 파일 전체에서 오브젝트를 찾아 다시 구성한다.
+				reconstruct();
+				structure.repaired = true;
+				if (!resolveEntry(m_Trailer.Get("Root"), root) || root.type != Object::Type::Dictionary) {
+					return false;
+				}
+			}
+			structure.xrefStream = m_XRefStream;
+			structure.encrypted = m_Trailer.Get("Encrypt") != nullptr;
+			measureImages(structure);
+
+			const Object* pages = root.Get("Pages");
+			InheritedAttributes inherited;
+			std::set<int> visited;
+			if (pages && walkPageTree(*pages, inherited, 0, visited, structure.pages)) {
+				structure.pageCount = static_cast<int>(structure.pages.size());
+				structure.pagesComplete = true;
+				return true;
+			}
+
+			// 암호화된 오브젝트 스트림 등으로 트리를 읽지 못하면 /Count 로 대신한다.
+			structure.pages.clear();
+			Object pageTree;
+			const Object* count = nullptr;
+			if (resolveEntry(pages, pageTree)) {
+				count = pageTree.Get("Count");
+			}
+			if (!count && structure.linearized) {
+				count = linearization.Get("N");
+			}
+			int64_t pageCount = 0;
+			if (count && integerValue(*count, 0, INT32_MAX, pageCount)) {
+				structure.pageCount = static_cast<int>(pageCount);
+			}
+			return structure.pageCount >= 0;
+		}
+
+	private:
+		// 첫 오브젝트가 /Linearized 딕셔너리인지 확인한다.
+		bool readLinearization(size_t headerOffset, Object& linearization)
+		{
+			Lexer lexer(m_Data, std::min(m_Size, headerOffset + HEADER_SEARCH_SIZE), headerOffset);
+			int64_t number = 0;
+			int64_t generation = 0;
+			if (!lexer.ReadInteger(number) || !lexer.ReadInteger(generation) || !lexer.MatchKeyword("obj")) {
+				return false;
+			}
+			return lexer.ParseObject(linearization) && linearization.Get("Linearized") != nullptr;
+		}
+
+		bool readXRefChain(size_t offset)
+		{
+			std::set<size_t> visited;
+			bool loaded = false;
+			while (offset < m_Size && visited.insert(offset).second) {
+				Object trailer;
+				if (!readXRefSection(offset, trailer)) {
+					break;
+				}
+				loaded = true;
+
+				// 하이브리드 파일 : 테이블에 없는 오브젝트는 /XRefStm 에 있다.
+				const Object* xrefStm = trailer.Get("XRefStm");
+				int64_t sectionOffset = 0;
+				if (xrefStm && integerValue(*xrefStm, 0, static_cast<int64_t>(m_Size), sectionOffset)) {
+					Object unused;
+					readXRefSection(static_cast<size_t>(sectionOffset), unused);
+				}
+				mergeTrailer(trailer);
+
+				const Object* prev = trailer.Get("Prev");
+				if (!prev || !integerValue(*prev, 0, static_cast<int64_t>(m_Size), sectionOffset)) {
+					break;
+				}
+				offset = static_cast<size_t>(sectionOffset);
+			}
+			return loaded;
+		}
+
+		// 최신 섹션의 값이 우선하고 없는 키만 이전 트레일러에서 가져온다.
+		void mergeTrailer(const Object& trailer)
+		{
+			if (m_Trailer.type != Object::Type::Dictionary) {
+				m_Trailer.type = Object::Type::Dictionary;
+			}
+			for (size_t i = 0; i < trailer.keys.size(); i++) {
+				if (!m_Trailer.Get(trailer.keys[i].c_str())) {
+					m_Trailer.keys.push_back(trailer.keys[i]);
+					m_Trailer.items.push_back(trailer.items[i]);
+				}
+			}
+		}
+
+		bool readXRefSection(size_t offset, Object& trailer)
+		{
+			Lexer lexer(m_Data, m_Size, offset);
+			if (lexer.MatchKeyword("xref")) {
+				return readXRefTable(lexer, trailer);
+			}
+
+			Object stream;
+			if (!readIndirect(offset, -1, stream) || !stream.stream) {
+				return false;
+			}
+			const Object* type = stream.Get("Type");
+			if (!type || !type->IsName("XRef") || !readXRefStream(stream)) {
+				return false;
+			}
+			m_XRefStream = true;
+			trailer = std::move(stream);
+			return true;
+		}
+
+		bool readXRefTable(Lexer& lexer, Object& trailer)
+		{
+			for (;;) {
+				if (lexer.MatchKeyword("trailer")) {
+					return lexer.ParseObject(trailer) && trailer.type == Object::Type::Dictionary;
+				}
+				int64_t start = 0;
+				int64_t count = 0;
+				if (!lexer.ReadInteger(start) || !lexer.ReadInteger(count) || start < 0 || count < 0 || start + count > m_ObjectLimit) {
+					return false;
+				}
+				for (int64_t i = 0; i < count; i++) {
+					int64_t offset = 0;
+					int64_t generation = 0;
+					if (!lexer.ReadInteger(offset) || !lexer.ReadInteger(generation)) {
+						return false;
+					}
+					XRefEntry entry;
+					if (lexer.MatchKeyword("n")) {
+						entry.type = XRefEntry::Type::InFile;
+						entry.offset = static_cast<uint64_t>(offset);
+					} else if (lexer.MatchKeyword("f")) {
+						entry.type = XRefEntry::Type::Free;
+					} else {
+						return false;
+					}
+					setEntry(static_cast<int>(start + i), entry, false);
+				}
+			}
+		}
+
+		bool readXRefStream(const Object& stream)
+		{
+			std::vector<unsigned char> data;
+			const Object* widths = stream.Get("W");
+			if (!widths || widths->type != Object::Type::Array || widths->items.size() != 3 || !readStream(stream, data)) {
+				return false;
+			}
+			size_t width[3];
+			for (int i = 0; i < 3; i++) {
+				const Object& item = widths->items[i];
+				if (item.type != Object::Type::Number || item.number < 0 || item.number > 8) {
+					return false;
+				}
+				width[i] = static_cast<size_t>(item.number);
+			}
+			const size_t rowLength = width[0] + width[1] + width[2];
+			if (rowLength == 0) {
+				return false;
+			}
+
+			// /Index 가 없으면 [0 Size]
+			std::vector<int64_t> index;
+			const Object* indexArray = stream.Get("Index");
+			if (indexArray && indexArray->type == Object::Type::Array) {
+				for (size_t i = 0; i < indexArray->items.size(); i++) {
+					int64_t value = 0;
+					if (!integerValue(indexArray->items[i], 0, m_ObjectLimit, value)) {
+						return false;
+					}
+					index.push_back(value);
+				}
+			} else {
+				const Object* size = stream.Get("Size");
+				int64_t value = 0;
+				if (size && !integerValue(*size, 0, m_ObjectLimit, value)) {
+					return false;
+				}
+				index.push_back(0);
+				index.push_back(value);
+			}
+
+			auto readField = [&](size_t position, size_t length) -> uint64_t {
+				uint64_t value = 0;
+				for (size_t i = 0; i < length; i++) {
+					value = (value << 8) | data[position + i];
+				}
+				return value;
+			};
+
+			size_t position = 0;
+			for (size_t i = 0; i + 1 < index.size(); i += 2) {
+				const int64_t start = index[i];
+				const int64_t count = index[i + 1];
+				if (start + count > m_ObjectLimit) {
+					return false;
+				}
+				for (int64_t j = 0; j < count && position + rowLength <= data.size(); j++, position += rowLength) {
+					// 첫 필드 폭이 0 이면 기본값 1 (파일 내 오브젝트)
+					const uint64_t type = width[0] ? readField(position, width[0]) : 1;
+					const uint64_t field2 = readField(position + width[0], width[1]);
+					const uint64_t field3 = readField(position + width[0] + width[1], width[2]);
+					XRefEntry entry;
+					if (type == 0) {
+						entry.type = XRefEntry::Type::Free;
+					} else if (type == 1) {
+						entry.type = XRefEntry::Type::InFile;
+						entry.offset = field2;
+					} else if (type == 2) {
+						entry.type = XRefEntry::Type::Compressed;
+						entry.offset = field2;
+						entry.index = static_cast<unsigned int>(field3);
+					} else {
+						continue; // 알 수 없는 형식은 null 오브젝트로 취급한다.
+					}
+					setEntry(static_cast<int>(start + j), entry, false);
+				}
+			}
+			return true;
+		}
+
+		// 증분 갱신은 최신 섹션부터 읽으므로 이미 정해진 항목은 덮어쓰지 않는다.
+		void setEntry(int objectNumber, const XRefEntry& entry, bool overwrite)
+		{
+			if (objectNumber <= 0 || objectNumber >= m_ObjectLimit) {
+				return;
+			}
+			if (static_cast<size_t>(objectNumber) >= m_XRef.size()) {
+				m_XRef.resize(objectNumber + 1);
+			}
+			if (overwrite || m_XRef[objectNumber].type == XRefEntry::Type::None) {
+				m_XRef[objectNumber] = entry;
+			}
+		}
+
+		// 파일 전체에서 "N G obj" 를 찾아 xref 와 트레일러를 다시 만든다.
+		void reconstruct()
+		{
+			m_XRef.clear();
+			m_ObjectStreams.clear();
+			m_Trailer = Object();
+
+			std::vector<int> objectStreams;
+			int catalog = 0;
+			const unsigned char* end = m_Data + m_Size;
+			for (const unsigned char* it = findBytes(m_Data, end, "obj"); it != end; it = findBytes(it + 3, end, "obj")) {
+				if (it + 3 < end && !isWhite(it[3]) && !isDelimiter(it[3])) {
+					continue;
+				}
+				// 역방향으로 "번호 공백 세대 공백" 을 확인한다.
+				const unsigned char* p = it;
+				if (p == m_Data || !isWhite(p[-1])) {
+					continue;
+				}
+				while (p > m_Data && isWhite(p[-1])) {
+					p--;
+				}
+				const unsigned char* generationEnd = p;
+				while (p > m_Data && isDigit(p[-1])) {
+					p--;
+				}
+				if (p == generationEnd || p == m_Data || !isWhite(p[-1])) {
+					continue;
+				}
+				while (p > m_Data && isWhite(p[-1])) {
+					p--;
+				}
+				const unsigned char* numberEnd = p;
+				while (p > m_Data && isDigit(p[-1])) {
+					p--;
+				}
+				if (p == numberEnd) {
+					continue;
+				}
+
+				const size_t offset = static_cast<size_t>(p - m_Data);
+				Lexer lexer(m_Data, m_Size, offset);
+				int64_t number = 0;
+				if (!lexer.ReadInteger(number) || number <= 0 || number >= m_ObjectLimit) {
+					continue;
+				}
+				XRefEntry entry;
+				entry.type = XRefEntry::Type::InFile;
+				entry.offset = offset;
+				setEntry(static_cast<int>(number), entry, true);
+
+				Object object;
+				if (!readIndirect(offset, static_cast<int>(number), object)) {
+					continue;
+				}
+				const Object* type = object.Get("Type");
+				if (type && type->IsName("ObjStm")) {
+					objectStreams.push_back(static_cast<int>(number));
+				} else if (type && type->IsName("Catalog")) {
+					catalog = static_cast<int>(number);
+				} else if (type && type->IsName("XRef") && object.Get("Root")) {
+					m_Trailer = std::move(object);
+				}
+			}
+
+			// 오브젝트 스트림 안의 오브젝트를 등록한다.
+			for (size_t i = 0; i < objectStreams.size(); i++) {
+				const ObjectStream* objectStream = loadObjectStream(objectStreams[i]);
+				if (!objectStream) {
+					continue;
+				}
+				for (size_t j = 0; j < objectStream->objects.size(); j++) {
+					XRefEntry entry;
+					entry.type = XRefEntry::Type::Compressed;
+					entry.offset = static_cast<uint64_t>(objectStreams[i]);
+					entry.index = static_cast<unsigned int>(j);
+					setEntry(objectStream->objects[j].first, entry, false);
+				}
+			}
+
+			const unsigned char* trailer = findLastBytes(m_Data, end, "trailer");
+			if (trailer) {
+				Lexer lexer(m_Data, m_Size, static_cast<size_t>(trailer - m_Data) + 7);
+				Object dictionary;
+				if (lexer.ParseObject(dictionary) && dictionary.Get("Root")) {
+					m_Trailer = std::move(dictionary);
+				}
+			}
+			if (!m_Trailer.Get("Root") && catalog > 0) {
+				Object root;
+				root.type = Object::Type::Reference;
+				root.objectNumber = catalog;
+				m_Trailer.type = Object::Type::Dictionary;
+				m_Trailer.keys.push_back("Root");
+				m_Trailer.items.push_back(root);
+			}
+		}
+
+		// offset 위치의 "N G obj ... [stream]" 을 읽는다. expected 가 0 이상이면 번호를 확인한다.
+		bool readIndirect(size_t offset, int expected, Object& out)
+		{
+			Lexer lexer(m_Data, m_Size, offset);
+			int64_t number = 0;
+			int64_t generation = 0;
+			if (!lexer.ReadInteger(number) || !lexer.ReadInteger(generation) || !lexer.MatchKeyword("obj")) {
+				return false;
+			}
+			if (expected >= 0 && number != expected) {
+				return false;
+			}
+			if (!lexer.ParseObject(out)) {
+				return false;
+			}
+			if (out.type == Object::Type::Dictionary && lexer.MatchKeyword("stream")) {
+				lexer.SkipStreamEOL();
+				out.stream = true;
+				out.streamOffset = lexer.Position();
+			}
+			return true;
+		}
+
+		bool loadObject(int objectNumber, Object& out)
+		{
+			if (objectNumber <= 0 || static_cast<size_t>(objectNumber) >= m_XRef.size()) {
+				return false;
+			}
+			const XRefEntry entry = m_XRef[objectNumber];
+			if (entry.type == XRefEntry::Type::InFile) {
+				return entry.offset < m_Size && readIndirect(static_cast<size_t>(entry.offset), objectNumber, out);
+			}
+			if (entry.type != XRefEntry::Type::Compressed || entry.offset >= static_cast<uint64_t>(MAX_OBJECT_NUMBER)) {
+				return false;
+			}
+
+			const ObjectStream* objectStream = loadObjectStream(static_cast<int>(entry.offset));
+			if (!objectStream) {
+				return false;
+			}
+			size_t index = entry.index;
+			if (index >= objectStream->objects.size() || objectStream->objects[index].first != objectNumber) {
+				// 순번이 틀린 파일이 있어 번호로 다시 찾는다.
+				for (index = 0; index < objectStream->objects.size(); index++) {
+					if (objectStream->objects[index].first == objectNumber) {
+						break;
+					}
+				}
+				if (index == objectStream->objects.size()) {
+					return false;
+				}
+			}
+			Lexer lexer(objectStream->data.data(), objectStream->data.size(), objectStream->first + objectStream->objects[index].second);
+			return lexer.ParseObject(out);
+		}
+
+		const ObjectStream* loadObjectStream(int objectNumber)
+		{
+			auto found = m_ObjectStreams.find(objectNumber);
+			if (found != m_ObjectStreams.end()) {
+				return found->second.get(); // 실패도 nullptr 로 기억한다.
+			}
+			m_ObjectStreams[objectNumber] = nullptr;
+
+			// 오브젝트 스트림은 다른 오브젝트 스트림 안에 있을 수 없다.
+			Object stream;
+			if (static_cast<size_t>(objectNumber) >= m_XRef.size() || m_XRef[objectNumber].type != XRefEntry::Type::InFile
+				|| !loadObject(objectNumber, stream) || !stream.stream) {
+				return nullptr;
+			}
+			const Object* countEntry = stream.Get("N");
+			const Object* firstEntry = stream.Get("First");
+			int64_t count = 0;
+			int64_t first = 0;
+			if (!countEntry || !firstEntry || !integerValue(*countEntry, 0, m_ObjectLimit, count) || !integerValue(*firstEntry, 0, INT32_MAX, first)) {
+				return nullptr;
+			}
+
+			std::unique_ptr<ObjectStream> objectStream(new ObjectStream());
+			if (!readStream(stream, objectStream->data)) {
+				return nullptr;
+			}
+			objectStream->first = static_cast<size_t>(first);
+			Lexer lexer(objectStream->data.data(), std::min(objectStream->data.size(), objectStream->first), 0);
+			for (int64_t i = 0; i < count; i++) {
+				int64_t number = 0;
+				int64_t offset = 0;
+				if (!lexer.ReadInteger(number) || !lexer.ReadInteger(offset) || number <= 0 || number >= m_ObjectLimit || offset < 0) {
+					break;
+				}
+				objectStream->objects.push_back(std::make_pair(static_cast<int>(number), static_cast<size_t>(offset)));
+			}
+			ObjectStream* result = objectStream.get();
+			m_ObjectStreams[objectNumber] = std::move(objectStream);
+			return result;
+		}
+
+		// 간접 참조를 따라가 실제 값을 얻는다.
+		bool resolve(const Object& in, Object& out)
+		{
+			if (in.type != Object::Type::Reference) {
+				out = in;
+				return true;
+			}
+			int objectNumber = in.objectNumber;
+			for (int hop = 0; hop < 8; hop++) {
+				if (!loadObject(objectNumber, out)) {
+					return false;
+				}
+				if (out.type != Object::Type::Reference) {
+					return true;
+				}
+				objectNumber = out.objectNumber;
+			}
+			return false;
+		}
+
+		bool resolveEntry(const Object* in, Object& out)
+		{
+			return in && resolve(*in, out);
+		}
+
+		bool readNumber(const Object& in, double& value)
+		{
+			Object number;
+			if (!resolve(in, number) || number.type != Object::Type::Number) {
+				return false;
+			}
+			value = number.number;
+			return true;
+		}
+
+		bool readInteger(const Object& in, int64_t minimum, int64_t maximum, int64_t& value)
+		{
+			Object number;
+			return resolve(in, number) && integerValue(number, minimum, maximum, value);
+		}
+
+		bool readStream(const Object& stream, std::vector<unsigned char>& out)
+		{
+			const size_t begin = stream.streamOffset;
+			if (!stream.stream || begin > m_Size) {
+				return false;
+			}
+			// /Length 가 틀린 파일이 많아 endstream 으로 보정한다.
+			size_t length = 0;
+			int64_t declared = 0;
+			const Object* lengthEntry = stream.Get("Length");
+			if (lengthEntry && readInteger(*lengthEntry, 0, static_cast<int64_t>(m_Size - begin), declared)) {
+				length = static_cast<size_t>(declared);
+			} else {
+				const unsigned char* end = findBytes(m_Data + begin, m_Data + m_Size, "endstream");
+				length = static_cast<size_t>(end - (m_Data + begin));
+				while (length > 0 && isWhite(m_Data[begin + length - 1])) {
+					length--;
+				}
+			}
+
+			std::vector<Object> filters;
+			std::vector<Object> parameters;
+			Object filter;
+			Object decodeParms;
+			if (resolveEntry(stream.Get("Filter"), filter)) {
+				if (filter.type == Object::Type::Array) {
+					filters = filter.items;
+				} else {
+					filters.push_back(filter);
+				}
+			}
+			if (resolveEntry(stream.Get("DecodeParms"), decodeParms)) {
+				if (decodeParms.type == Object::Type::Array) {
+					parameters = decodeParms.items;
+				} else {
+					parameters.push_back(decodeParms);
+				}
+			}
+
+			out.assign(m_Data + begin, m_Data + begin + length);
+			for (size_t i = 0; i < filters.size(); i++) {
+				if (!filters[i].IsName("FlateDecode") && !filters[i].IsName("Fl")) {
+					return false; // 구조 스트림은 FlateDecode 외의 필터를 쓰지 않는다.
+				}
+				std::vector<unsigned char> decoded;
+				if (!PDF::Converter::FlateDecode(out.data(), out.size(), decoded) && decoded.empty()) {
+					return false;
+				}
+				out.swap(decoded);
+
+				Object parameter;
+				if (i < parameters.size() && resolve(parameters[i], parameter) && parameter.type == Object::Type::Dictionary) {
+					// 범위 밖의 값은 UndoPredictor 가 거부하도록 int 범위에서만 읽고 나머지는 실패로 둔다.
+					int64_t predictor = 1, colors = 1, bitsPerComponent = 8, columns = 1;
+					const Object* entry = nullptr;
+					if (((entry = parameter.Get("Predictor")) != nullptr && !readInteger(*entry, 0, INT32_MAX, predictor))
+						|| ((entry = parameter.Get("Colors")) != nullptr && !readInteger(*entry, 0, INT32_MAX, colors))
+						|| ((entry = parameter.Get("BitsPerComponent")) != nullptr && !readInteger(*entry, 0, INT32_MAX, bitsPerComponent))
+						|| ((entry = parameter.Get("Columns")) != nullptr && !readInteger(*entry, 0, INT32_MAX, columns))) {
+						return false;
+					}
+					if (!PDF::Converter::UndoPredictor(out, static_cast<int>(predictor), static_cast<int>(colors), static_cast<int>(bitsPerComponent), static_cast<int>(columns))) {
+						return false;
+					}
+				}
+			}
+			return true;
+		}
+
+		// 스트림은 오브젝트 스트림에 들어갈 수 없으므로 파일 내 오브젝트만 확인한다.
+		// 딕셔너리만 읽고 스트림 데이터는 풀지 않는다.
+		void measureImages(PDF::Converter::DocumentStructure& structure)
+		{
+			for (size_t objectNumber = 1; objectNumber < m_XRef.size(); objectNumber++) {
+				const XRefEntry& entry = m_XRef[objectNumber];
+				Object object;
+				if (entry.type != XRefEntry::Type::InFile || entry.offset >= m_Size
+					|| !readIndirect(static_cast<size_t>(entry.offset), static_cast<int>(objectNumber), object) || !object.stream) {
+					continue;
+				}
+				const Object* subtype = object.Get("Subtype");
+				int64_t length = 0;
+				const Object* lengthEntry = object.Get("Length");
+				if (subtype && subtype->IsName("Image") && lengthEntry && readInteger(*lengthEntry, 1, static_cast<int64_t>(m_Size), length)) {
+					structure.imageCount++;
+					structure.imageBytes += length;
+				}
+			}
+		}
+
+		bool readBox(const Object& node, const char* key, float box[4])
+		{
+			Object array;
+			if (!resolveEntry(node.Get(key), array) || array.type != Object::Type::Array || array.items.size() != 4) {
+				return false;
+			}
+			double values[4];
+			for (int i = 0; i < 4; i++) {
+				if (!readNumber(array.items[i], values[i]) || !(values[i] >= -FLT_MAX && values[i] <= FLT_MAX)) {
+					return false; // float 로 바꿀 수 없는 값 (무한대, NaN 포함)
+				}
+			}
+			box[0] = static_cast<float>(std::min(values[0], values[2]));
+			box[1] = static_cast<float>(std::min(values[1], values[3]));
+			box[2] = static_cast<float>(std::max(values[0], values[2]));
+			box[3] = static_cast<float>(std::max(values[1], values[3]));
+			return true;
+		}
+
+		bool walkPageTree(const Object& nodeEntry, InheritedAttributes inherited, int depth, std::set<int>& visited, std::vector<PDF::Converter::PageGeometry>& pages)
+		{
+			if (depth > MAX_PAGE_TREE_DEPTH) {
+				return false;
+			}
+			if (nodeEntry.type == Object::Type::Reference && !visited.insert(nodeEntry.objectNumber).second) {
+				return false; // 순환 참조
+			}
+			Object node;
+			if (!resolve(nodeEntry, node) || node.type != Object::Type::Dictionary) {
+				return false;
+			}
+
+			readBox(node, "MediaBox", inherited.mediaBox);
+			if (readBox(node, "CropBox", inherited.cropBox)) {
+				inherited.hasCropBox = true;
+			}
+			int64_t rotate = 0;
+			const Object* rotateEntry = node.Get("Rotate");
+			if (rotateEntry && readInteger(*rotateEntry, -360 * 1024, 360 * 1024, rotate)) {
+				inherited.rotate = static_cast<int>(rotate);
+			}
+
+			const Object* type = node.Get("Type");
+			const Object* kidsEntry = node.Get("Kids");
+			if (kidsEntry && !(type && type->IsName("Page"))) {
+				Object kids;
+				if (!resolve(*kidsEntry, kids) || kids.type != Object::Type::Array) {
+					return false;
+				}
+				for (size_t i = 0; i < kids.items.size(); i++) {
+					if (!walkPageTree(kids.items[i], inherited, depth + 1, visited, pages)) {
+						return false;
+					}
+				}
+				return true;
+			}
+
+			// PDFBox 와 같이 CropBox 는 MediaBox 로 잘라내고 회전은 90 의 배수로 맞춘다.
+			PDF::Converter::PageGeometry page;
+			for (int i = 0; i < 4; i++) {
+				page.mediaBox[i] = inherited.mediaBox[i];
+				page.cropBox[i] = inherited.mediaBox[i];
+			}
+			if (inherited.hasCropBox) {
+				page.cropBox[0] = std::max(inherited.cropBox[0], inherited.mediaBox[0]);
+				page.cropBox[1] = std::max(inherited.cropBox[1], inherited.mediaBox[1]);
+				page.cropBox[2] = std::min(inherited.cropBox[2], inherited.mediaBox[2]);
+				page.cropBox[3] = std::min(inherited.cropBox[3], inherited.mediaBox[3]);
+			}
+			page.rotate = ((inherited.rotate % 360) + 360) % 360 / 90 * 90;
+			pages.push_back(page);
+			return true;
+		}
+
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+		int m_ObjectLimit; // 오브젝트는 파일에서 1 바이트 이상을 차지하므로 번호는 파일 크기를 넘지 않는다.
+		std::vector<XRefEntry> m_XRef;
+		Object m_Trailer;
+		std::map<int, std::unique_ptr<ObjectStream>> m_ObjectStreams;
+		bool m_XRefStream;
+	}; // class StructureParser
+}
+
+namespace PDF { namespace Converter {
+
+	float PageGeometry::Width() const
+	{
+		const float width = cropBox[2] - cropBox[0];
+		const float height = cropBox[3] - cropBox[1];
+		return (rotate == 90 || rotate == 270) ? height : width;
+	}
+
+	float PageGeometry::Height() const
+	{
+		const float width = cropBox[2] - cropBox[0];
+		const float height = cropBox[3] - cropBox[1];
+		return (rotate == 90 || rotate == 270) ? width : height;
+	}
+
+	bool ScanStructure(const wchar_t* sourceFile, DocumentStructure& structure)
+	{
+		MappedFile file;
+		if (!sourceFile || !file.Open(_U2A(sourceFile).c_str())) {
+			return false;
+		}
+		StructureParser parser(file.Data(), file.Size());
+		return parser.Scan(structure);
+	}
+
+}} // PDF::Converter
@@ -0,0 +1,40 @@
+﻿// PDFStructureScanner.h
+#pragma once
+#include <string> // std::string
+#include <vector> // std::vector
+#include <stdint.h> // int64_t
+
+namespace PDF { namespace Converter {
+
+	// 페이지 박스 (PDF 포인트 단위, 상속 적용 후)
+	struct PageGeometry
+	{
+		float mediaBox[4] = { 0.0f, 0.0f, 612.0f, 792.0f };
+		float cropBox[4] = { 0.0f, 0.0f, 612.0f, 792.0f };
+		int rotate = 0;
+
+		// 렌더링 크기 (CropBox, 90/270 회전이면 가로 세로 교환)
+		float Width() const;
+		float Height() const;
+	}; // struct PageGeometry
+
+	struct DocumentStructure
+	{
+		std::string version;          // 헤더의 "1.7" 등
+		int64_t fileSize = 0;
+		int pageCount = -1;           // 알 수 없으면 -1
+		bool encrypted = false;       // 트레일러에 /Encrypt 가 있다.
+		bool linearized = false;      // 첫 오브젝트가 /Linearized 딕셔너리이다.
+		bool xrefStream = false;      // 교차 참조 스트림(PDF 1.5+)을 사용한다.
+		bool repaired = false;        // xref 가 손상되어 오브젝트를 직접 찾아 복구했다.
+		bool pagesComplete = false;   // 페이지 트리를 끝까지 읽어 pages 가 유효하다.
+		int imageCount = 0;           // 이미지 XObject 수
+		int64_t imageBytes = 0;       // 이미지 스트림 크기 합계 (압축된 크기)
+		std::vector<PageGeometry> pages;
+	}; // struct DocumentStructure
+
+	// JVM 없이 트레일러, xref(테이블/스트림), 페이지 트리만 읽어 문서 구조를 파악한다.
+	// 콘텐츠 스트림은 해석하지 않으므로 렌더링 전 분류(triage)에 쓴다.
+	bool ScanStructure(const wchar_t* sourceFile, DocumentStructure& structure);
+
+}} // PDF::Converter
@@ -0,0 +1,426 @@
+﻿// PDFStructuredText.cpp
+#include "PDFStructuredText.h"
+#include <algorithm> // std::min, std::max
+#include <cmath> // std::fabs
+#include <string.h> // memcmp, memcpy
+#include "pdf_assert.h"
+
+static const char STRUCTURED_TEXT_MAGIC[4] = { 'P', 'S', 'T', 'X' };
+static const uint32_t STRUCTURED_TEXT_VERSION = 1;
+static const float LINE_BASELINE_TOLERANCE = 0.5f;	// 글자 높이 대비 기준선 차이가 넘으면 새 줄
+static const float WORD_GAP_TOLERANCE = 0.5f;		// 공백 폭 대비 간격이 넘으면 새 단어 (PDFTextStripper 의 spacingTolerance)
+
+namespace {
+
+	size_t alignUp(size_t value, size_t alignment)
+	{
+		return (value + alignment - 1) / alignment * alignment;
+	}
+
+	// 공백, 줄바꿈, NBSP 만으로 된 글자는 단어 경계로만 쓴다.
+	bool isBlank(const std::string& text, uint32_t begin, uint32_t end)
+	{
+		for (uint32_t i = begin; i < end; i++) {
+			const char ch = text[i];
+			if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+				continue;
+			}
+			if (ch == '\xC2' && i + 1 < end && text[i + 1] == '\xA0') {
+				i++;
+				continue;
+			}
+			return false;
+		}
+		return true;
+	}
+
+	struct BoxColumns
+	{
+		std::vector<float> left;
+		std::vector<float> top;
+		std::vector<float> right;
+		std::vector<float> bottom;
+		std::vector<uint32_t> first; // 하위 항목 시작 인덱스, 마지막에 끝 인덱스를 붙인다.
+
+		void Begin(uint32_t firstChild, float l, float t, float r, float b)
+		{
+			left.push_back(l);
+			top.push_back(t);
+			right.push_back(r);
+			bottom.push_back(b);
+			first.push_back(firstChild);
+		}
+		void Extend(float l, float t, float r, float b)
+		{
+			left.back() = std::min(left.back(), l);
+			top.back() = std::min(top.back(), t);
+			right.back() = std::max(right.back(), r);
+			bottom.back() = std::max(bottom.back(), b);
+		}
+		size_t Size() const { return left.size(); }
+	}; // struct BoxColumns
+
+	// 페이지 블록의 열을 순서대로 잘라낸다. 파일 밖으로 나가면 Null
+	class ColumnCursor
+	{
+	public:
+		ColumnCursor(const unsigned char* data, size_t size, uint64_t offset)
+		: m_Data(data)
+		, m_Size(size)
+		, m_Offset(offset)
+		{
+		}
+
+		template <typename T>
+		const T* Take(size_t count)
+		{
+			const uint64_t bytes = static_cast<uint64_t>(count) * sizeof(T);
+			if (m_Offset > m_Size || bytes > m_Size - m_Offset) {
+				return nullptr;
+			}
+			const T* column = reinterpret_cast<const T*>(m_Data + m_Offset);
+			m_Offset = alignUp(static_cast<size_t>(m_Offset + bytes), 4);
+			return column;
+		}
+
+	private:
+		const unsigned char* m_Data;
+		size_t m_Size;
+		uint64_t m_Offset;
+	}; // class ColumnCursor
+
+	bool equalsIgnoreCase(const char* text, size_t length, const std::string& term)
+	{
+		if (length != term.size()) {
+			return false;
+		}
+		for (size_t i = 0; i < length; i++) {
+			char a = text[i];
+			char b = term[i];
+			a = (a >= 'A' && a <= 'Z') ? static_cast<char>(a - 'A' + 'a') : a;
+			b = (b >= 'A' && b <= 'Z') ? static_cast<char>(b - 'A' + 'a') : b;
+			if (a != b) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// 인덱스 열 (count + 1 개) 이 줄지 않고 last 에서 끝나면 모든 범위가 [0, last] 안에 있다.
+	bool validIndexColumn(const uint32_t* index, uint32_t count, uint32_t last)
+	{
+		for (uint32_t i = 0; i < count; i++) {
+			if (index[i] > index[i + 1]) {
+				return false;
+			}
+		}
+		return index[count] == last;
+	}
+}
+
+namespace PDF { namespace Converter {
+
+	StructuredTextWriter::StructuredTextWriter()
+	: m_File(nullptr)
+	, m_Offset(0)
+	{
+	}
+
+	StructuredTextWriter::~StructuredTextWriter()
+	{
+		if (m_File) {
+			fclose(m_File); // Close() 없이 끝나면 헤더가 비어 있으므로 읽을 수 없는 파일이 남는다.
+		}
+	}
+
+	bool StructuredTextWriter::Open(const std::string& targetFile)
+	{
+		_ASSERTE(!m_File && "StructuredTextWriter is already open");
+		if (m_File) {
+			return false;
+		}
+		m_File = fopen(targetFile.c_str(), "wb");
+		if (!m_File) {
+			return false;
+		}
+		m_Offset = 0;
+		m_Pages.clear();
+		m_Fonts.clear();
+		StructuredTextHeader header;
+		memset(&header, 0, sizeof(header));
+		return write(&header, sizeof(header), 8);
+	}
+
+	bool StructuredTextWriter::AddPage(float width, float height, const std::vector<TextGlyph>& glyphs, const std::string& text)
+	{
+		_ASSERTE(m_File && "StructuredTextWriter is not open");
+		if (!m_File) {
+			return false;
+		}
+
+		BoxColumns lines;
+		BoxColumns words;
+		std::vector<float> glyphLeft, glyphTop, glyphWidth, glyphHeight, glyphFontSize;
+		std::vector<uint16_t> glyphFont;
+		std::vector<uint32_t> glyphTextOffset;
+		std::string glyphText;
+		glyphLeft.reserve(glyphs.size());
+		glyphTop.reserve(glyphs.size());
+		glyphWidth.reserve(glyphs.size());
+		glyphHeight.reserve(glyphs.size());
+		glyphFontSize.reserve(glyphs.size());
+		glyphFont.reserve(glyphs.size());
+		glyphTextOffset.reserve(glyphs.size() + 1);
+
+		float lineBaseline = 0.0f;
+		float previousRight = 0.0f;
+		bool blankPending = false;
+		for (const TextGlyph& glyph : glyphs) {
+			if (glyph.textEnd < glyph.textBegin || glyph.textEnd > text.size()) {
+				return false;
+			}
+			if (isBlank(text, glyph.textBegin, glyph.textEnd)) {
+				blankPending = true;
+				continue;
+			}
+
+			const float top = glyph.baseline - glyph.height;
+			const float right = glyph.x + glyph.width;
+			const float lineTolerance = std::max(glyph.height, 1.0f) * LINE_BASELINE_TOLERANCE;
+			const float spaceWidth = glyph.spaceWidth > 0.0f ? glyph.spaceWidth : glyph.fontSize * 0.25f;
+			const bool newLine = lines.Size() == 0 || glyph.articleStart
+				|| std::fabs(glyph.baseline - lineBaseline) > lineTolerance
+				|| glyph.x < previousRight - std::max(glyph.width, spaceWidth); // 같은 기준선에서 왼쪽으로 돌아갔다.
+			const bool newWord = newLine || blankPending || glyph.x - previousRight > spaceWidth * WORD_GAP_TOLERANCE;
+
+			const uint32_t glyphIndex = static_cast<uint32_t>(glyphLeft.size());
+			if (newLine) {
+				lines.Begin(static_cast<uint32_t>(words.Size()), glyph.x, top, right, glyph.baseline);
+				lineBaseline = glyph.baseline;
+			} else {
+				lines.Extend(glyph.x, top, right, glyph.baseline);
+			}
+			if (newWord) {
+				words.Begin(glyphIndex, glyph.x, top, right, glyph.baseline);
+			} else {
+				words.Extend(glyph.x, top, right, glyph.baseline);
+			}
+
+			glyphLeft.push_back(glyph.x);
+			glyphTop.push_back(top);
+			glyphWidth.push_back(glyph.width);
+			glyphHeight.push_back(glyph.height);
+			glyphFontSize.push_back(glyph.fontSize);
+			glyphFont.push_back(glyph.fontId);
+			glyphTextOffset.push_back(static_cast<uint32_t>(glyphText.size()));
+			glyphText.append(text, glyph.textBegin, glyph.textEnd - glyph.textBegin);
+			previousRight = right;
+			blankPending = false;
+		}
+		lines.first.push_back(static_cast<uint32_t>(words.Size()));
+		words.first.push_back(static_cast<uint32_t>(glyphLeft.size()));
+		glyphTextOffset.push_back(static_cast<uint32_t>(glyphText.size()));
+
+		StructuredPageEntry entry;
+		entry.offset = m_Offset;
+		entry.width = width;
+		entry.height = height;
+		entry.lineCount = static_cast<uint32_t>(lines.Size());
+		entry.wordCount = static_cast<uint32_t>(words.Size());
+		entry.glyphCount = static_cast<uint32_t>(glyphLeft.size());
+		entry.textBytes = static_cast<uint32_t>(glyphText.size());
+
+		bool result = true;
+		for (const BoxColumns* boxes : { &lines, &words }) {
+			const size_t count = boxes->Size();
+			result = result
+				&& write(boxes->left.data(), count * sizeof(float), 4)
+				&& write(boxes->top.data(), count * sizeof(float), 4)
+				&& write(boxes->right.data(), count * sizeof(float), 4)
+				&& write(boxes->bottom.data(), count * sizeof(float), 4)
+				&& write(boxes->first.data(), (count + 1) * sizeof(uint32_t), 4);
+		}
+		const size_t glyphCount = glyphLeft.size();
+		result = result
+			&& write(glyphLeft.data(), glyphCount * sizeof(float), 4)
+			&& write(glyphTop.data(), glyphCount * sizeof(float), 4)
+			&& write(glyphWidth.data(), glyphCount * sizeof(float), 4)
+			&& write(glyphHeight.data(), glyphCount * sizeof(float), 4)
+			&& write(glyphFontSize.data(), glyphCount * sizeof(float), 4)
+			&& write(glyphFont.data(), glyphCount * sizeof(uint16_t), 4)
+			&& write(glyphTextOffset.data(), (glyphCount + 1) * sizeof(uint32_t), 4)
+			&& write(glyphText.data(), glyphText.size(), 8);
+		if (result) {
+			m_Pages.push_back(entry);
+		}
+		return result;
+	}
+
+	bool StructuredTextWriter::Close()
+	{
+		if (!m_File) {
+			return false;
+		}
+
+		StructuredTextHeader header;
+		memcpy(header.magic, STRUCTURED_TEXT_MAGIC, sizeof(header.magic));
+		header.version = STRUCTURED_TEXT_VERSION;
+		header.pageCount = static_cast<uint32_t>(m_Pages.size());
+		header.fontCount = static_cast<uint32_t>(m_Fonts.size());
+		header.pageIndexOffset = m_Offset;
+		bool result = write(m_Pages.data(), m_Pages.size() * sizeof(StructuredPageEntry), 8);
+
+		header.fontTableOffset = m_Offset;
+		std::vector<uint32_t> fontOffsets(1, 0);
+		for (const std::string& font : m_Fonts) {
+			fontOffsets.push_back(fontOffsets.back() + static_cast<uint32_t>(font.size()));
+		}
+		result = result && write(fontOffsets.data(), fontOffsets.size() * sizeof(uint32_t), 1);
+		for (const std::string& font : m_Fonts) {
+			result = result && write(font.data(), font.size(), 1);
+		}
+
+		// 모두 쓴 뒤에 헤더를 채워서 중간에 실패한 파일은 magic 이 비어 있다.
+		result = result && fseek(m_File, 0, SEEK_SET) == 0 && fwrite(&header, sizeof(header), 1, m_File) == 1;
+		result = fclose(m_File) == 0 && result;
+		m_File = nullptr;
+		return result;
+	}
+
+	bool StructuredTextWriter::write(const void* data, size_t bytes, size_t alignment)
+	{
+		static const unsigned char padding[8] = { 0, };
+		const size_t paddingBytes = alignUp(static_cast<size_t>(m_Offset + bytes), alignment) - static_cast<size_t>(m_Offset + bytes);
+		if ((bytes > 0 && fwrite(data, 1, bytes, m_File) != bytes)
+			|| (paddingBytes > 0 && fwrite(padding, 1, paddingBytes, m_File) != paddingBytes)) {
+			return false;
+		}
+		m_Offset += bytes + paddingBytes;
+		return true;
+	}
+
+	StructuredTextReader::StructuredTextReader()
+	: m_Header(nullptr)
+	, m_Pages(nullptr)
+	{
+	}
+
+	bool StructuredTextReader::Open(const char* path)
+	{
+		Close();
+		if (!m_File.Open(path)) {
+			return false;
+		}
+		const unsigned char* data = m_File.Data();
+		const size_t size = m_File.Size();
+		const StructuredTextHeader* header = reinterpret_cast<const StructuredTextHeader*>(data);
+		if (size < sizeof(StructuredTextHeader) || memcmp(header->magic, STRUCTURED_TEXT_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != STRUCTURED_TEXT_VERSION || header->pageIndexOffset % 8 != 0
+			|| header->pageIndexOffset > size || static_cast<uint64_t>(header->pageCount) * sizeof(StructuredPageEntry) > size - header->pageIndexOffset
+			|| header->fontTableOffset % 4 != 0 || header->fontTableOffset > size
+			|| (static_cast<uint64_t>(header->fontCount) + 1) * sizeof(uint32_t) > size - header->fontTableOffset) {
+			Close();
+			return false;
+		}
+		m_Header = header;
+		m_Pages = reinterpret_cast<const StructuredPageEntry*>(data + header->pageIndexOffset);
+		return true;
+	}
+
+	void StructuredTextReader::Close()
+	{
+		m_File.Close();
+		m_Header = nullptr;
+		m_Pages = nullptr;
+	}
+
+	bool StructuredTextReader::Page(int pageIndex, StructuredTextPage& page) const
+	{
+		if (!m_Header || pageIndex < 0 || static_cast<uint32_t>(pageIndex) >= m_Header->pageCount) {
+			return false;
+		}
+		const StructuredPageEntry& entry = m_Pages[pageIndex];
+		if (entry.offset % 8 != 0) {
+			return false;
+		}
+		ColumnCursor cursor(m_File.Data(), m_File.Size(), entry.offset);
+		page.width = entry.width;
+		page.height = entry.height;
+		page.lineCount = entry.lineCount;
+		page.wordCount = entry.wordCount;
+		page.glyphCount = entry.glyphCount;
+
+		page.lineLeft = cursor.Take<float>(entry.lineCount);
+		page.lineTop = cursor.Take<float>(entry.lineCount);
+		page.lineRight = cursor.Take<float>(entry.lineCount);
+		page.lineBottom = cursor.Take<float>(entry.lineCount);
+		page.lineFirstWord = cursor.Take<uint32_t>(static_cast<size_t>(entry.lineCount) + 1);
+
+		page.wordLeft = cursor.Take<float>(entry.wordCount);
+		page.wordTop = cursor.Take<float>(entry.wordCount);
+		page.wordRight = cursor.Take<float>(entry.wordCount);
+		page.wordBottom = cursor.Take<float>(entry.wordCount);
+		page.wordFirstGlyph = cursor.Take<uint32_t>(static_cast<size_t>(entry.wordCount) + 1);
+
+		page.glyphLeft = cursor.Take<float>(entry.glyphCount);
+		page.glyphTop = cursor.Take<float>(entry.glyphCount);
+		page.glyphWidth = cursor.Take<float>(entry.glyphCount);
+		page.glyphHeight = cursor.Take<float>(entry.glyphCount);
+		page.glyphFontSize = cursor.Take<float>(entry.glyphCount);
+		page.glyphFont = cursor.Take<uint16_t>(entry.glyphCount);
+		page.glyphTextOffset = cursor.Take<uint32_t>(static_cast<size_t>(entry.glyphCount) + 1);
+		page.text = cursor.Take<char>(entry.textBytes);
+
+		// 손상된 파일에서도 WordText() 등이 범위를 벗어나지 않도록 인덱스 열 전체를 확인한다.
+		return page.lineLeft && page.lineTop && page.lineRight && page.lineBottom && page.lineFirstWord
+			&& page.wordLeft && page.wordTop && page.wordRight && page.wordBottom && page.wordFirstGlyph
+			&& page.glyphLeft && page.glyphTop && page.glyphWidth && page.glyphHeight && page.glyphFontSize && page.glyphFont
+			&& page.glyphTextOffset && page.text
+			&& validIndexColumn(page.lineFirstWord, entry.lineCount, entry.wordCount)
+			&& validIndexColumn(page.wordFirstGlyph, entry.wordCount, entry.glyphCount)
+			&& validIndexColumn(page.glyphTextOffset, entry.glyphCount, entry.textBytes);
+	}
+
+	std::string StructuredTextReader::FontName(uint16_t fontId) const
+	{
+		if (!m_Header || fontId >= m_Header->fontCount) {
+			return std::string();
+		}
+		const uint32_t* offsets = reinterpret_cast<const uint32_t*>(m_File.Data() + m_Header->fontTableOffset);
+		const uint64_t names = m_Header->fontTableOffset + (static_cast<uint64_t>(m_Header->fontCount) + 1) * sizeof(uint32_t);
+		if (offsets[fontId] > offsets[fontId + 1] || names + offsets[fontId + 1] > m_File.Size()) {
+			return std::string();
+		}
+		return std::string(reinterpret_cast<const char*>(m_File.Data() + names + offsets[fontId]), offsets[fontId + 1] - offsets[fontId]);
+	}
+
+	size_t StructuredTextReader::FindWords(const std::string& term, std::vector<TextBox>& boxes, int pageIndex /*= -1*/) const
+	{
+		const size_t found = boxes.size();
+		const int firstPage = pageIndex < 0 ? 0 : pageIndex;
+		const int lastPage = pageIndex < 0 ? static_cast<int>(PageCount()) : std::min(pageIndex + 1, static_cast<int>(PageCount()));
+		StructuredTextPage page;
+		for (int index = firstPage; index < lastPage; index++) {
+			if (!Page(index, page)) {
+				continue;
+			}
+			for (uint32_t word = 0; word < page.wordCount; word++) {
+				size_t length = 0;
+				const char* text = page.WordText(word, &length);
+				if (!equalsIgnoreCase(text, length, term)) {
+					continue;
+				}
+				TextBox box;
+				box.pageIndex = index;
+				box.word = word;
+				box.left = page.wordLeft[word];
+				box.top = page.wordTop[word];
+				box.right = page.wordRight[word];
+				box.bottom = page.wordBottom[word];
+				boxes.push_back(box);
+			}
+		}
+		return boxes.size() - found;
+	}
+
+}} // PDF::Converter
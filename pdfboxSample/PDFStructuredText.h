@@ -0,0 +1,160 @@
+﻿// PDFStructuredText.h
+#pragma once
+#include <vector> // std::vector
+#include <string> // std::string
+#include <stdint.h> // uint32_t
+#include <stdio.h> // FILE
+#include "PDFMappedFile.h"
+
+namespace PDF { namespace Converter {
+
+	// PDFTextStripper 의 TextPosition 한 개. 좌표는 페이지 왼쪽 위 기준 pt (y 는 아래로 증가)
+	struct TextGlyph
+	{
+		float x = 0.0f;
+		float baseline = 0.0f;
+		float width = 0.0f;
+		float height = 0.0f;
+		float fontSize = 0.0f;		// pt
+		float spaceWidth = 0.0f;	// 폰트의 공백 폭. 단어 경계 판단에 사용한다.
+		uint32_t textBegin = 0;		// 페이지 텍스트(UTF-8) 안의 범위
+		uint32_t textEnd = 0;
+		uint16_t fontId = 0;		// StructuredTextWriter::Fonts() 의 인덱스
+		bool articleStart = false;	// 새 비드(article)의 첫 글자
+	}; // struct TextGlyph
+
+	// 구조화 텍스트 파일 (.stx)
+	// 네이티브 바이트 순서이며 페이지마다 줄, 단어, 글자의 열(column)을 배열로 저장한다.
+	//   헤더 | 페이지 블록... | 페이지 색인 StructuredPageEntry[pageCount] | 폰트 표
+	//   페이지 블록 : 줄 { left[], top[], right[], bottom[], firstWord[n+1] }
+	//                 단어 { left[], top[], right[], bottom[], firstGlyph[n+1] }
+	//                 글자 { left[], top[], width[], height[], fontSize[], fontId(uint16)[], textOffset[n+1] } | 텍스트(UTF-8)
+	//   각 열은 4byte, 페이지 블록은 8byte 단위로 정렬한다.
+	//   폰트 표 : uint32 offset[fontCount+1] | 폰트 이름(UTF-8)
+	struct StructuredTextHeader
+	{
+		char magic[4];				// "PSTX"
+		uint32_t version;
+		uint32_t pageCount;
+		uint32_t fontCount;
+		uint64_t pageIndexOffset;
+		uint64_t fontTableOffset;
+	}; // struct StructuredTextHeader
+	static_assert(sizeof(StructuredTextHeader) == 32, "StructuredTextHeader layout");
+
+	struct StructuredPageEntry
+	{
+		uint64_t offset;			// 페이지 블록 위치
+		float width;				// pt
+		float height;
+		uint32_t lineCount;
+		uint32_t wordCount;
+		uint32_t glyphCount;
+		uint32_t textBytes;
+	}; // struct StructuredPageEntry
+	static_assert(sizeof(StructuredPageEntry) == 32, "StructuredPageEntry layout");
+
+	// 한 페이지의 열. 포인터는 StructuredTextReader 의 매핑을 가리킨다.
+	struct StructuredTextPage
+	{
+		float width = 0.0f;
+		float height = 0.0f;
+		uint32_t lineCount = 0;
+		uint32_t wordCount = 0;
+		uint32_t glyphCount = 0;
+
+		const float* lineLeft = nullptr;
+		const float* lineTop = nullptr;
+		const float* lineRight = nullptr;
+		const float* lineBottom = nullptr;
+		const uint32_t* lineFirstWord = nullptr;	// lineCount + 1 개
+
+		const float* wordLeft = nullptr;
+		const float* wordTop = nullptr;
+		const float* wordRight = nullptr;
+		const float* wordBottom = nullptr;
+		const uint32_t* wordFirstGlyph = nullptr;	// wordCount + 1 개
+
+		const float* glyphLeft = nullptr;
+		const float* glyphTop = nullptr;
+		const float* glyphWidth = nullptr;
+		const float* glyphHeight = nullptr;
+		const float* glyphFontSize = nullptr;
+		const uint16_t* glyphFont = nullptr;
+		const uint32_t* glyphTextOffset = nullptr;	// glyphCount + 1 개
+
+		const char* text = nullptr;
+
+		// 단어의 UTF-8 텍스트 (복사하지 않는다)
+		const char* WordText(uint32_t word, size_t* length) const
+		{
+			const uint32_t begin = glyphTextOffset[wordFirstGlyph[word]];
+			*length = glyphTextOffset[wordFirstGlyph[word + 1]] - begin;
+			return text + begin;
+		}
+	}; // struct StructuredTextPage
+
+	struct TextBox
+	{
+		int pageIndex = 0;
+		uint32_t word = 0;
+		float left = 0.0f;
+		float top = 0.0f;
+		float right = 0.0f;
+		float bottom = 0.0f;
+	}; // struct TextBox
+
+	// 페이지를 하나씩 받아 바로 파일에 쓰므로 메모리는 한 페이지 크기만 사용한다.
+	class StructuredTextWriter
+	{
+	public:
+		StructuredTextWriter();
+		~StructuredTextWriter();
+
+		bool Open(const std::string& targetFile);
+		// 글자를 읽는 순서대로 줄과 단어로 묶는다. text 는 glyphs 의 textBegin, textEnd 가 가리키는 페이지 텍스트
+		bool AddPage(float width, float height, const std::vector<TextGlyph>& glyphs, const std::string& text);
+		bool Close(); // 페이지 색인과 폰트 표를 쓰고 헤더를 채운다.
+
+		std::vector<std::string>& Fonts() { return m_Fonts; } // 글자의 fontId 가 가리키는 폰트 이름
+
+	private:
+		StructuredTextWriter(const StructuredTextWriter&) = delete;
+		StructuredTextWriter& operator=(const StructuredTextWriter&) = delete;
+
+		bool write(const void* data, size_t bytes, size_t alignment);
+
+	private:
+		FILE* m_File;
+		uint64_t m_Offset;
+		std::vector<StructuredPageEntry> m_Pages;
+		std::vector<std::string> m_Fonts;
+	}; // class StructuredTextWriter
+
+	// .stx 파일을 메모리 맵으로 열어 복사 없이 열을 읽는다.
+	class StructuredTextReader
+	{
+	public:
+		StructuredTextReader();
+
+		bool Open(const char* path);
+		void Close();
+
+		uint32_t PageCount() const { return m_Header ? m_Header->pageCount : 0; }
+		bool Page(int pageIndex, StructuredTextPage& page) const; // 열이 파일 밖에 있거나 인덱스 열이 손상되었으면 false
+		std::string FontName(uint16_t fontId) const;
+
+		// 단어 텍스트가 term 과 같은(ASCII 대소문자 무시) 단어의 영역. pageIndex 가 음수이면 모든 페이지
+		size_t FindWords(const std::string& term, std::vector<TextBox>& boxes, int pageIndex = -1) const;
+
+	private:
+		StructuredTextReader(const StructuredTextReader&) = delete;
+		StructuredTextReader& operator=(const StructuredTextReader&) = delete;
+
+	private:
+		MappedFile m_File;
+		const StructuredTextHeader* m_Header;
+		const StructuredPageEntry* m_Pages;
+	}; // class StructuredTextReader
+
+}} // PDF::Converter
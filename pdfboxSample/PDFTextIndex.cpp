@@ -0,0 +1,787 @@
+﻿// PDFTextIndex.cpp
+#include "PDFTextIndex.h"
+#include <algorithm> // std::sort, std::unique, std::set_intersection
+#include <map> // std::map
+#include <iterator> // std::back_inserter
+#include <string.h> // memcmp, memcpy, memset
+#include <stdio.h> // fopen, rename, remove
+#include "pdf_assert.h"
+#include "pdf_utils.h"
+
+#ifdef _WIN32
+#	include <Windows.h> // FindFirstFileA
+#else
+#	include <dirent.h> // opendir
+#endif
+
+static const char INDEX_SEGMENT_MAGIC[4] = { 'P', 'I', 'D', 'X' };
+static const uint32_t INDEX_SEGMENT_VERSION = 1;
+static const char* const INDEX_SEGMENT_PREFIX = "segment_";
+static const char* const INDEX_SEGMENT_EXT = ".pidx";
+static const size_t MAX_TOKEN_BYTES = 64; // 더 긴 단어는 추출 오류로 보고 색인하지 않는다.
+
+namespace PDF { namespace Converter {
+
+	// 세그먼트 파일 : 헤더 | 문서 offset uint32[documentCount+1] | 문서 경로 | 포스팅 | IndexTermEntry[termCount] | 색인어
+	// 네이티브 바이트 순서이며 포스팅과 색인어 표는 8byte 단위로 정렬한다.
+	struct IndexSegmentHeader
+	{
+		char magic[4];				// "PIDX"
+		uint32_t version;
+		uint32_t documentCount;
+		uint32_t termCount;
+		uint64_t documentOffset;
+		uint64_t postingsOffset;
+		uint64_t termOffset;
+		uint64_t termPoolOffset;
+	}; // struct IndexSegmentHeader
+	static_assert(sizeof(IndexSegmentHeader) == 48, "IndexSegmentHeader layout");
+
+	struct IndexTermEntry
+	{
+		uint32_t termOffset;		// 색인어 풀 안의 위치
+		uint32_t termLength;
+		uint32_t documentCount;		// 포스팅의 문서 수
+		uint32_t postingsBytes;
+		uint64_t postingsOffset;
+	}; // struct IndexTermEntry
+	static_assert(sizeof(IndexTermEntry) == 24, "IndexTermEntry layout");
+
+}} // PDF::Converter
+
+namespace {
+
+	enum class TokenClass
+	{
+		Separator,
+		Word,	// 단어 단위
+		Bigram	// 두 글자씩
+	}; // enum class TokenClass
+
+	TokenClass classify(uint32_t code)
+	{
+		if ((code >= '0' && code <= '9') || (code >= 'a' && code <= 'z') || (code >= 'A' && code <= 'Z')) {
+			return TokenClass::Word;
+		}
+		if ((code >= 0x00C0 && code <= 0x024F && code != 0x00D7 && code != 0x00F7)	// 라틴 확장
+			|| (code >= 0x0370 && code <= 0x03FF)									// 그리스
+			|| (code >= 0x0400 && code <= 0x04FF)) {								// 키릴
+			return TokenClass::Word;
+		}
+		if ((code >= 0xAC00 && code <= 0xD7A3)		// 한글 음절
+			|| (code >= 0x1100 && code <= 0x11FF)	// 한글 자모
+			|| (code >= 0x3130 && code <= 0x318F)	// 한글 호환 자모
+			|| (code >= 0x3040 && code <= 0x30FF)	// 히라가나, 가타카나
+			|| (code >= 0x3400 && code <= 0x4DBF)	// 한자 확장 A
+			|| (code >= 0x4E00 && code <= 0x9FFF)	// 한자
+			|| (code >= 0xF900 && code <= 0xFAFF)) {	// 한자 호환
+			return TokenClass::Bigram;
+		}
+		return TokenClass::Separator;
+	}
+
+	uint32_t toLower(uint32_t code)
+	{
+		if ((code >= 'A' && code <= 'Z') || (code >= 0x00C0 && code <= 0x00DE && code != 0x00D7)
+			|| (code >= 0x0391 && code <= 0x03A9 && code != 0x03A2) || (code >= 0x0410 && code <= 0x042F)) {
+			return code + 0x20;
+		}
+		if (code >= 0x0400 && code <= 0x040F) {
+			return code + 0x50;
+		}
+		return code;
+	}
+
+	void appendUTF8(uint32_t code, std::string& text)
+	{
+		if (code < 0x80) {
+			text += static_cast<char>(code);
+		} else if (code < 0x800) {
+			text += static_cast<char>(0xC0 | (code >> 6));
+			text += static_cast<char>(0x80 | (code & 0x3F));
+		} else {
+			// classify() 가 색인하는 문자는 모두 BMP 안에 있다.
+			text += static_cast<char>(0xE0 | (code >> 12));
+			text += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+			text += static_cast<char>(0x80 | (code & 0x3F));
+		}
+	}
+
+	// 잘못된 UTF-8 바이트는 U+FFFD 로 읽고 한 바이트만 넘긴다.
+	uint32_t decodeUTF8(const std::string& text, size_t& index)
+	{
+		const unsigned char lead = static_cast<unsigned char>(text[index++]);
+		if (lead < 0x80) {
+			return lead;
+		}
+		const int length = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : -1;
+		if (length < 0 || index + length > text.size()) {
+			return 0xFFFD;
+		}
+		uint32_t code = lead & (0x3F >> length);
+		for (int i = 0; i < length; i++) {
+			const unsigned char next = static_cast<unsigned char>(text[index + i]);
+			if ((next & 0xC0) != 0x80) {
+				return 0xFFFD;
+			}
+			code = (code << 6) | (next & 0x3F);
+		}
+		index += length;
+		return code;
+	}
+
+	void appendVarint(uint64_t value, std::string& bytes)
+	{
+		while (value >= 0x80) {
+			bytes += static_cast<char>((value & 0x7F) | 0x80);
+			value >>= 7;
+		}
+		bytes += static_cast<char>(value);
+	}
+
+	bool readVarint(const unsigned char*& data, const unsigned char* end, uint64_t& value)
+	{
+		value = 0;
+		for (int shift = 0; data < end && shift < 64; shift += 7) {
+			const unsigned char byte = *data++;
+			value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+			if (!(byte & 0x80)) {
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// (문서 << 32 | 페이지) 증가 순서 -> { 문서 번호 차이, 페이지 수, 페이지 번호 차이... }
+	uint32_t encodePostings(const std::vector<uint64_t>& postings, std::string& bytes)
+	{
+		uint32_t documentCount = 0;
+		uint64_t previousDocument = 0;
+		for (size_t i = 0; i < postings.size();) {
+			const uint64_t document = postings[i] >> 32;
+			size_t end = i;
+			while (end < postings.size() && (postings[end] >> 32) == document) {
+				end++;
+			}
+			appendVarint(document - previousDocument, bytes);
+			appendVarint(end - i, bytes);
+			uint64_t previousPage = 0;
+			for (; i < end; i++) {
+				const uint64_t page = postings[i] & 0xFFFFFFFF;
+				appendVarint(page - previousPage, bytes);
+				previousPage = page;
+			}
+			previousDocument = document;
+			documentCount++;
+		}
+		return documentCount;
+	}
+
+	// 같은 폴더의 segment_<번호>.pidx 를 번호 순서로 찾는다.
+	std::vector<std::pair<uint64_t, std::string>> listSegments(const std::string& indexDir)
+	{
+		std::vector<std::pair<uint64_t, std::string>> segments;
+		const std::string dir = pathAddSeparator(indexDir);
+		auto addSegment = [&](const std::string& name) {
+			const size_t prefixLength = strlen(INDEX_SEGMENT_PREFIX);
+			const size_t extLength = strlen(INDEX_SEGMENT_EXT);
+			if (name.size() <= prefixLength + extLength || name.compare(0, prefixLength, INDEX_SEGMENT_PREFIX) != 0
+				|| name.compare(name.size() - extLength, extLength, INDEX_SEGMENT_EXT) != 0) {
+				return;
+			}
+			const std::string number = name.substr(prefixLength, name.size() - prefixLength - extLength);
+			if (number.find_first_not_of("0123456789") != std::string::npos) {
+				return;
+			}
+			segments.push_back(std::make_pair(std::stoull(number), dir + name));
+		};
+#ifdef _WIN32
+		WIN32_FIND_DATAA findData;
+		HANDLE find = ::FindFirstFileA((dir + "*").c_str(), &findData);
+		if (find != INVALID_HANDLE_VALUE) {
+			do {
+				if (!(findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+					addSegment(findData.cFileName);
+				}
+			} while (::FindNextFileA(find, &findData));
+			::FindClose(find);
+		}
+#else
+		DIR* directory = opendir(dir.c_str());
+		if (directory) {
+			while (dirent* entry = readdir(directory)) {
+				addSegment(entry->d_name);
+			}
+			closedir(directory);
+		}
+#endif
+		std::sort(segments.begin(), segments.end());
+		return segments;
+	}
+
+	// 임시 파일에 쓰고 Close() 에서 이름을 바꾸므로 검색은 완성된 세그먼트만 본다.
+	class SegmentWriter
+	{
+	public:
+		SegmentWriter()
+		: m_Offset(0)
+		{
+		}
+		~SegmentWriter()
+		{
+			if (m_File) {
+				m_File.reset();
+				remove(m_TempFile.c_str());
+			}
+		}
+
+		bool Open(const std::string& targetFile, const std::vector<std::string>& documents)
+		{
+			m_TargetFile = targetFile;
+			m_TempFile = targetFile + ".tmp";
+			m_File.reset(fopen(m_TempFile.c_str(), "wb"));
+			if (!m_File) {
+				return false;
+			}
+			memset(&m_Header, 0, sizeof(m_Header));
+			memcpy(m_Header.magic, INDEX_SEGMENT_MAGIC, sizeof(m_Header.magic));
+			m_Header.version = INDEX_SEGMENT_VERSION;
+			m_Header.documentCount = static_cast<uint32_t>(documents.size());
+
+			std::vector<uint32_t> documentOffsets(1, 0);
+			for (const std::string& document : documents) {
+				documentOffsets.push_back(documentOffsets.back() + static_cast<uint32_t>(document.size()));
+			}
+			bool result = write(&m_Header, sizeof(m_Header), 8);
+			m_Header.documentOffset = m_Offset;
+			result = result && write(documentOffsets.data(), documentOffsets.size() * sizeof(uint32_t), 1);
+			for (const std::string& document : documents) {
+				result = result && write(document.data(), document.size(), 1);
+			}
+			result = result && write(nullptr, 0, 8);
+			m_Header.postingsOffset = m_Offset;
+			return result;
+		}
+
+		// postings 는 정렬되어 있어야 한다.
+		bool AddTerm(const std::string& term, const std::vector<uint64_t>& postings)
+		{
+			if (postings.empty()) {
+				return true;
+			}
+			_ASSERTE((m_Terms.empty() || m_TermPool.compare(m_Terms.back().termOffset, m_Terms.back().termLength, term) < 0) && "terms are not sorted");
+			m_Buffer.clear();
+			PDF::Converter::IndexTermEntry entry;
+			entry.termOffset = static_cast<uint32_t>(m_TermPool.size());
+			entry.termLength = static_cast<uint32_t>(term.size());
+			entry.documentCount = encodePostings(postings, m_Buffer);
+			entry.postingsBytes = static_cast<uint32_t>(m_Buffer.size());
+			entry.postingsOffset = m_Offset;
+			m_Terms.push_back(entry);
+			m_TermPool += term;
+			return write(m_Buffer.data(), m_Buffer.size(), 1);
+		}
+
+		bool Close()
+		{
+			m_Header.termCount = static_cast<uint32_t>(m_Terms.size());
+			bool result = write(nullptr, 0, 8);
+			m_Header.termOffset = m_Offset;
+			result = result && write(m_Terms.data(), m_Terms.size() * sizeof(PDF::Converter::IndexTermEntry), 1);
+			m_Header.termPoolOffset = m_Offset;
+			result = result && write(m_TermPool.data(), m_TermPool.size(), 1)
+				&& fseek(m_File.get(), 0, SEEK_SET) == 0 && fwrite(&m_Header, sizeof(m_Header), 1, m_File.get()) == 1;
+			result = fclose(m_File.release()) == 0 && result;
+			if (!result || rename(m_TempFile.c_str(), m_TargetFile.c_str()) != 0) {
+				remove(m_TempFile.c_str());
+				return false;
+			}
+			return true;
+		}
+
+	private:
+		bool write(const void* data, size_t bytes, size_t alignment)
+		{
+			static const char padding[8] = { 0, };
+			const size_t paddingBytes = (alignment - (m_Offset + bytes) % alignment) % alignment;
+			if ((bytes > 0 && fwrite(data, 1, bytes, m_File.get()) != bytes)
+				|| (paddingBytes > 0 && fwrite(padding, 1, paddingBytes, m_File.get()) != paddingBytes)) {
+				return false;
+			}
+			m_Offset += bytes + paddingBytes;
+			return true;
+		}
+
+	private:
+		AutoFilePtr m_File;
+		std::string m_TargetFile;
+		std::string m_TempFile;
+		uint64_t m_Offset;
+		PDF::Converter::IndexSegmentHeader m_Header;
+		std::vector<PDF::Converter::IndexTermEntry> m_Terms;
+		std::string m_TermPool;
+		std::string m_Buffer;
+	}; // class SegmentWriter
+}
+
+namespace PDF { namespace Converter {
+
+	void TokenizeText(const std::string& text, const std::function<void(const std::string& token)>& callback)
+	{
+		std::string word;
+		std::string bigram;
+		uint32_t previous = 0;
+		size_t runLength = 0;
+		auto flushWord = [&]() {
+			if (!word.empty() && word.size() <= MAX_TOKEN_BYTES) {
+				callback(word);
+			}
+			word.clear();
+		};
+		auto flushRun = [&]() {
+			if (runLength == 1) {
+				bigram.clear();
+				appendUTF8(previous, bigram);
+				callback(bigram);
+			}
+			runLength = 0;
+		};
+
+		for (size_t index = 0; index < text.size();) {
+			const uint32_t code = decodeUTF8(text, index);
+			switch (classify(code)) {
+			case TokenClass::Word:
+				flushRun();
+				appendUTF8(toLower(code), word);
+				break;
+			case TokenClass::Bigram:
+				flushWord();
+				if (runLength > 0) {
+					bigram.clear();
+					appendUTF8(previous, bigram);
+					appendUTF8(code, bigram);
+					callback(bigram);
+				}
+				previous = code;
+				runLength++;
+				break;
+			default:
+				flushWord();
+				flushRun();
+				break;
+			}
+		}
+		flushWord();
+		flushRun();
+	}
+
+	IndexSegment::IndexSegment()
+	: m_Header(nullptr)
+	, m_Terms(nullptr)
+	, m_DocumentOffsets(nullptr)
+	{
+	}
+
+	bool IndexSegment::Open(const std::string& segmentFile)
+	{
+		m_Header = nullptr;
+		if (!m_File.Open(segmentFile.c_str())) {
+			return false;
+		}
+		const size_t size = m_File.Size();
+		const IndexSegmentHeader* header = reinterpret_cast<const IndexSegmentHeader*>(m_File.Data());
+		if (size < sizeof(IndexSegmentHeader) || memcmp(header->magic, INDEX_SEGMENT_MAGIC, sizeof(header->magic)) != 0
+			|| header->version != INDEX_SEGMENT_VERSION || header->documentOffset % 4 != 0 || header->termOffset % 8 != 0
+			|| header->documentOffset > size || (static_cast<uint64_t>(header->documentCount) + 1) * sizeof(uint32_t) > size - header->documentOffset
+			|| header->termOffset > size || static_cast<uint64_t>(header->termCount) * sizeof(IndexTermEntry) > size - header->termOffset
+			|| header->termPoolOffset > size) {
+			m_File.Close();
+			return false;
+		}
+		m_Header = header;
+		m_Terms = reinterpret_cast<const IndexTermEntry*>(m_File.Data() + header->termOffset);
+		m_DocumentOffsets = reinterpret_cast<const uint32_t*>(m_File.Data() + header->documentOffset);
+		return true;
+	}
+
+	uint32_t IndexSegment::DocumentCount() const
+	{
+		return m_Header ? m_Header->documentCount : 0;
+	}
+
+	std::string IndexSegment::DocumentPath(uint32_t document) const
+	{
+		if (document >= DocumentCount()) {
+			return std::string();
+		}
+		const uint64_t paths = m_Header->documentOffset + (static_cast<uint64_t>(m_Header->documentCount) + 1) * sizeof(uint32_t);
+		const uint32_t begin = m_DocumentOffsets[document];
+		const uint32_t end = m_DocumentOffsets[document + 1];
+		if (begin > end || paths + end > m_File.Size()) {
+			return std::string();
+		}
+		return std::string(reinterpret_cast<const char*>(m_File.Data() + paths + begin), end - begin);
+	}
+
+	uint32_t IndexSegment::TermCount() const
+	{
+		return m_Header ? m_Header->termCount : 0;
+	}
+
+	std::string IndexSegment::Term(uint32_t term) const
+	{
+		if (term >= TermCount()) {
+			return std::string();
+		}
+		const IndexTermEntry& entry = m_Terms[term];
+		if (m_Header->termPoolOffset + entry.termOffset + entry.termLength > m_File.Size()) {
+			return std::string();
+		}
+		return std::string(reinterpret_cast<const char*>(m_File.Data() + m_Header->termPoolOffset + entry.termOffset), entry.termLength);
+	}
+
+	int64_t IndexSegment::FindTerm(const std::string& term) const
+	{
+		// 색인어 표는 바이트 순서로 정렬되어 있다.
+		int64_t low = 0;
+		int64_t high = static_cast<int64_t>(TermCount()) - 1;
+		while (low <= high) {
+			const int64_t middle = low + (high - low) / 2;
+			const int compare = Term(static_cast<uint32_t>(middle)).compare(term);
+			if (compare == 0) {
+				return middle;
+			}
+			if (compare < 0) {
+				low = middle + 1;
+			} else {
+				high = middle - 1;
+			}
+		}
+		return -1;
+	}
+
+	bool IndexSegment::Postings(uint32_t term, std::vector<uint64_t>& postings) const
+	{
+		if (term >= TermCount()) {
+			return false;
+		}
+		const IndexTermEntry& entry = m_Terms[term];
+		if (entry.postingsOffset > m_File.Size() || entry.postingsBytes > m_File.Size() - entry.postingsOffset) {
+			return false;
+		}
+		const unsigned char* data = m_File.Data() + entry.postingsOffset;
+		const unsigned char* end = data + entry.postingsBytes;
+		uint64_t document = 0;
+		for (uint32_t i = 0; i < entry.documentCount; i++) {
+			uint64_t documentDelta = 0;
+			uint64_t pageCount = 0;
+			if (!readVarint(data, end, documentDelta) || !readVarint(data, end, pageCount)) {
+				return false;
+			}
+			document += documentDelta;
+			uint64_t page = 0;
+			for (uint64_t j = 0; j < pageCount; j++) {
+				uint64_t pageDelta = 0;
+				if (!readVarint(data, end, pageDelta)) {
+					return false;
+				}
+				page += pageDelta;
+				postings.push_back((document << 32) | (page & 0xFFFFFFFF));
+			}
+		}
+		return true;
+	}
+
+	TextIndexer::TextIndexer()
+	: m_PendingPages(0)
+	, m_NextSequence(1)
+	, m_Merging(false)
+	{
+	}
+
+	TextIndexer::~TextIndexer()
+	{
+		Close();
+	}
+
+	bool TextIndexer::Open(const std::string& indexDir, const TextIndexOptions& options)
+	{
+		_ASSERTE(!indexDir.empty() && "indexDir is not empty");
+		if (indexDir.empty() || !pathCreateDirectory(indexDir.c_str())) {
+			return false;
+		}
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		m_IndexDir = pathAddSeparator(indexDir);
+		m_Options = options;
+		m_Segments.clear();
+		m_NextSequence = 1;
+		for (const auto& segment : listSegments(m_IndexDir)) {
+			m_Segments.push_back(segment.second);
+			m_NextSequence = std::max(m_NextSequence, segment.first + 1);
+		}
+		return true;
+	}
+
+	bool TextIndexer::AddPage(const std::string& sourceFile, int pageIndex, const std::string& text)
+	{
+		if (pageIndex < 0) {
+			return false;
+		}
+		// 잠금 밖에서 나눈다.
+		std::vector<std::string> tokens;
+		TokenizeText(text, [&tokens](const std::string& token) { tokens.push_back(token); });
+
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_IndexDir.empty()) {
+			return false;
+		}
+		auto found = m_DocumentIDs.find(sourceFile);
+		if (found == m_DocumentIDs.end()) {
+			found = m_DocumentIDs.insert(std::make_pair(sourceFile, static_cast<uint32_t>(m_Documents.size()))).first;
+			m_Documents.push_back(sourceFile);
+		}
+		const uint64_t posting = (static_cast<uint64_t>(found->second) << 32) | static_cast<uint32_t>(pageIndex);
+		for (const std::string& token : tokens) {
+			std::vector<uint64_t>& postings = m_Postings[token];
+			if (postings.empty() || postings.back() != posting) {
+				postings.push_back(posting);
+			}
+		}
+		m_PendingPages++;
+		return m_PendingPages < m_Options.segmentPages || flush(lock);
+	}
+
+	bool TextIndexer::Flush()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		return flush(lock);
+	}
+
+	bool TextIndexer::Close()
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+		if (m_IndexDir.empty()) {
+			return true;
+		}
+		const bool result = flush(lock);
+		std::thread mergeThread = std::move(m_MergeThread);
+		m_IndexDir.clear();
+		lock.unlock();
+		if (mergeThread.joinable()) {
+			mergeThread.join();
+		}
+		return result;
+	}
+
+	bool TextIndexer::flush(std::unique_lock<std::mutex>& lock)
+	{
+		if (m_PendingPages == 0) {
+			return true;
+		}
+		// 쓰는 동안 다른 변환이 다음 세그먼트를 모을 수 있게 잠금을 푼다.
+		std::vector<std::string> documents;
+		std::unordered_map<std::string, std::vector<uint64_t>> postings;
+		documents.swap(m_Documents);
+		postings.swap(m_Postings);
+		m_DocumentIDs.clear();
+		m_PendingPages = 0;
+		const std::string segmentFile = nextSegmentFile();
+		lock.unlock();
+
+		std::vector<std::pair<const std::string*, std::vector<uint64_t>*>> terms;
+		terms.reserve(postings.size());
+		for (auto& term : postings) {
+			terms.push_back(std::make_pair(&term.first, &term.second));
+		}
+		std::sort(terms.begin(), terms.end(), [](const std::pair<const std::string*, std::vector<uint64_t>*>& a, const std::pair<const std::string*, std::vector<uint64_t>*>& b) {
+			return *a.first < *b.first;
+		});
+		SegmentWriter writer;
+		bool result = writer.Open(segmentFile, documents);
+		for (size_t i = 0; i < terms.size() && result; i++) {
+			// 여러 문서의 페이지가 섞여 들어오므로 문서, 페이지 순서로 정렬한다.
+			std::vector<uint64_t>& termPostings = *terms[i].second;
+			std::sort(termPostings.begin(), termPostings.end());
+			termPostings.erase(std::unique(termPostings.begin(), termPostings.end()), termPostings.end());
+			result = writer.AddTerm(*terms[i].first, termPostings);
+		}
+		result = result && writer.Close();
+		_ASSERTE(result && "TextIndexer::flush() Failed");
+
+		lock.lock();
+		if (!result) {
+			return false;
+		}
+		m_Segments.push_back(segmentFile);
+		if (m_Options.mergeFactor > 1 && m_Segments.size() >= m_Options.mergeFactor && !m_Merging) {
+			if (m_MergeThread.joinable()) {
+				m_MergeThread.join(); // 이전 병합은 m_Merging 을 내린 뒤 바로 끝난다.
+			}
+			m_Merging = true;
+			m_MergeThread = std::thread(&TextIndexer::mergeSegments, this, m_Segments, nextSegmentFile());
+		}
+		return true;
+	}
+
+	std::string TextIndexer::nextSegmentFile()
+	{
+		char name[32] = { 0, };
+		snprintf(name, sizeof(name), "%s%06llu%s", INDEX_SEGMENT_PREFIX, static_cast<unsigned long long>(m_NextSequence++), INDEX_SEGMENT_EXT);
+		return m_IndexDir + name;
+	}
+
+	void TextIndexer::mergeSegments(std::vector<std::string> segmentFiles, std::string targetFile)
+	{
+		bool result = true;
+		{
+			std::vector<std::unique_ptr<IndexSegment>> segments;
+			for (const std::string& segmentFile : segmentFiles) {
+				segments.emplace_back(new IndexSegment());
+				result = result && segments.back()->Open(segmentFile);
+			}
+
+			// 여러 세그먼트에 나뉜 같은 문서는 경로로 합친다.
+			std::vector<std::string> documents;
+			std::unordered_map<std::string, uint32_t> documentIDs;
+			std::vector<std::vector<uint32_t>> documentMaps(segments.size());
+			for (size_t i = 0; i < segments.size() && result; i++) {
+				for (uint32_t document = 0; document < segments[i]->DocumentCount(); document++) {
+					const std::string path = segments[i]->DocumentPath(document);
+					auto found = documentIDs.find(path);
+					if (found == documentIDs.end()) {
+						found = documentIDs.insert(std::make_pair(path, static_cast<uint32_t>(documents.size()))).first;
+						documents.push_back(path);
+					}
+					documentMaps[i].push_back(found->second);
+				}
+			}
+
+			// 정렬된 색인어 표를 동시에 훑으며 한 색인어씩 포스팅을 합친다.
+			SegmentWriter writer;
+			result = result && writer.Open(targetFile, documents);
+			std::vector<uint32_t> cursors(segments.size(), 0);
+			std::vector<std::string> heads(segments.size());
+			for (size_t i = 0; i < segments.size(); i++) {
+				heads[i] = segments[i]->Term(0);
+			}
+			std::vector<uint64_t> postings;
+			std::vector<uint64_t> segmentPostings;
+			while (result) {
+				const std::string* term = nullptr;
+				for (size_t i = 0; i < segments.size(); i++) {
+					if (cursors[i] < segments[i]->TermCount() && (!term || heads[i] < *term)) {
+						term = &heads[i];
+					}
+				}
+				if (!term) {
+					break;
+				}
+				const std::string current = *term;
+				postings.clear();
+				for (size_t i = 0; i < segments.size() && result; i++) {
+					if (cursors[i] >= segments[i]->TermCount() || heads[i] != current) {
+						continue;
+					}
+					segmentPostings.clear();
+					result = segments[i]->Postings(cursors[i], segmentPostings);
+					for (uint64_t posting : segmentPostings) {
+						const uint32_t document = static_cast<uint32_t>(posting >> 32);
+						result = result && document < documentMaps[i].size();
+						if (result) {
+							postings.push_back((static_cast<uint64_t>(documentMaps[i][document]) << 32) | (posting & 0xFFFFFFFF));
+						}
+					}
+					heads[i] = segments[i]->Term(++cursors[i]);
+				}
+				std::sort(postings.begin(), postings.end());
+				postings.erase(std::unique(postings.begin(), postings.end()), postings.end());
+				result = result && writer.AddTerm(current, postings);
+			}
+			result = result && writer.Close();
+		}
+		_ASSERTE(result && "TextIndexer::mergeSegments() Failed");
+
+		// 합친 세그먼트가 생긴 뒤에 원본을 지운다. 그 사이의 검색은 같은 페이지를 두번 찾지만 결과는 합쳐진다.
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		if (result) {
+			for (const std::string& segmentFile : segmentFiles) {
+				m_Segments.erase(std::remove(m_Segments.begin(), m_Segments.end(), segmentFile), m_Segments.end());
+				remove(segmentFile.c_str());
+			}
+			m_Segments.push_back(targetFile);
+		}
+		m_Merging = false;
+	}
+
+	bool TextIndexReader::Open(const std::string& indexDir)
+	{
+		Close();
+		if (!pathIsDirectory(indexDir.c_str())) {
+			return false;
+		}
+		for (const auto& segmentFile : listSegments(indexDir)) {
+			std::unique_ptr<IndexSegment> segment(new IndexSegment());
+			if (segment->Open(segmentFile.second)) {
+				m_Segments.push_back(std::move(segment));
+			}
+		}
+		return true;
+	}
+
+	void TextIndexReader::Close()
+	{
+		m_Segments.clear();
+	}
+
+	bool TextIndexReader::Search(const std::string& query, std::vector<SearchHit>& hits) const
+	{
+		hits.clear();
+		std::vector<std::string> tokens;
+		TokenizeText(query, [&tokens](const std::string& token) { tokens.push_back(token); });
+		std::sort(tokens.begin(), tokens.end());
+		tokens.erase(std::unique(tokens.begin(), tokens.end()), tokens.end());
+		if (tokens.empty()) {
+			return false;
+		}
+
+		std::map<std::string, std::vector<int>> pages;
+		std::vector<uint64_t> matched;
+		std::vector<uint64_t> postings;
+		std::vector<uint64_t> intersection;
+		for (const std::unique_ptr<IndexSegment>& segment : m_Segments) {
+			matched.clear();
+			for (size_t i = 0; i < tokens.size(); i++) {
+				const int64_t term = segment->FindTerm(tokens[i]);
+				postings.clear();
+				if (term < 0 || !segment->Postings(static_cast<uint32_t>(term), postings)) {
+					matched.clear();
+					break;
+				}
+				if (i == 0) {
+					matched.swap(postings);
+					continue;
+				}
+				intersection.clear();
+				std::set_intersection(matched.begin(), matched.end(), postings.begin(), postings.end(), std::back_inserter(intersection));
+				matched.swap(intersection);
+				if (matched.empty()) {
+					break;
+				}
+			}
+			for (uint64_t posting : matched) {
+				pages[segment->DocumentPath(static_cast<uint32_t>(posting >> 32))].push_back(static_cast<int>(posting & 0xFFFFFFFF));
+			}
+		}
+
+		for (auto& document : pages) {
+			SearchHit hit;
+			hit.sourceFile = document.first;
+			hit.pages.swap(document.second);
+			std::sort(hit.pages.begin(), hit.pages.end());
+			hit.pages.erase(std::unique(hit.pages.begin(), hit.pages.end()), hit.pages.end());
+			hits.push_back(hit);
+		}
+		return true;
+	}
+
+}} // PDF::Converter
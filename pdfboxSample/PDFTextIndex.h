@@ -0,0 +1,112 @@
+﻿// PDFTextIndex.h
+#pragma once
+#include <vector> // std::vector
+#include <string> // std::string
+#include <memory> // std::unique_ptr
+#include <functional> // std::function
+#include <unordered_map> // std::unordered_map
+#include <mutex> // std::mutex
+#include <thread> // std::thread
+#include <stdint.h> // uint32_t, uint64_t
+#include "PDFMappedFile.h"
+
+namespace PDF { namespace Converter {
+
+	// UTF-8 텍스트를 색인어로 나눈다.
+	// 라틴, 그리스, 키릴 문자와 숫자는 소문자로 바꾼 단어 단위, 한글, 가나, 한자는 띄어쓰기와 조사에 관계없이
+	// 찾을 수 있도록 두 글자씩 겹쳐 자른다. (한 글자만 있으면 그 글자)
+	void TokenizeText(const std::string& text, const std::function<void(const std::string& token)>& callback);
+
+	struct TextIndexOptions
+	{
+		size_t segmentPages = 4096;	// 이만큼 페이지를 모으면 세그먼트 파일로 쓴다.
+		size_t mergeFactor = 4;		// 세그먼트가 이만큼 쌓이면 백그라운드에서 하나로 합친다. (0 = 합치지 않음)
+	}; // struct TextIndexOptions
+
+	struct IndexSegmentHeader;
+	struct IndexTermEntry;
+
+	// 색인 폴더의 세그먼트 파일 (segment_<번호>.pidx) 하나를 메모리 맵으로 읽는다.
+	// 색인어는 바이트 순서로 정렬되어 있고 포스팅은 문서마다 { 문서 번호 차이, 페이지 수, 페이지 번호 차이... } 의 varint 이다.
+	class IndexSegment
+	{
+	public:
+		IndexSegment();
+
+		bool Open(const std::string& segmentFile);
+
+		uint32_t DocumentCount() const;
+		std::string DocumentPath(uint32_t document) const;
+		uint32_t TermCount() const;
+		std::string Term(uint32_t term) const;
+		int64_t FindTerm(const std::string& term) const; // 없으면 -1
+		// (문서 << 32 | 페이지) 를 증가 순서로 덧붙인다.
+		bool Postings(uint32_t term, std::vector<uint64_t>& postings) const;
+
+	private:
+		IndexSegment(const IndexSegment&) = delete;
+		IndexSegment& operator=(const IndexSegment&) = delete;
+
+	private:
+		MappedFile m_File;
+		const IndexSegmentHeader* m_Header;
+		const IndexTermEntry* m_Terms;
+		const uint32_t* m_DocumentOffsets;
+	}; // class IndexSegment
+
+	// 변환 중 추출한 페이지 텍스트로 역색인을 만든다. 여러 변환 스레드에서 동시에 AddPage() 를 호출할 수 있다.
+	class TextIndexer
+	{
+	public:
+		TextIndexer();
+		~TextIndexer(); // Close()
+
+		bool Open(const std::string& indexDir, const TextIndexOptions& options = TextIndexOptions());
+		bool AddPage(const std::string& sourceFile, int pageIndex, const std::string& text);
+		bool Flush(); // 모은 페이지를 세그먼트로 쓴다.
+		bool Close(); // Flush() 하고 진행 중인 병합을 기다린다.
+
+	private:
+		TextIndexer(const TextIndexer&) = delete;
+		TextIndexer& operator=(const TextIndexer&) = delete;
+
+		bool flush(std::unique_lock<std::mutex>& lock);
+		std::string nextSegmentFile();
+		void mergeSegments(std::vector<std::string> segmentFiles, std::string targetFile);
+
+	private:
+		std::string m_IndexDir;
+		TextIndexOptions m_Options;
+		std::mutex m_Mutex;
+		std::unordered_map<std::string, uint32_t> m_DocumentIDs;
+		std::vector<std::string> m_Documents;
+		std::unordered_map<std::string, std::vector<uint64_t>> m_Postings; // 색인어 -> (문서 << 32 | 페이지)
+		size_t m_PendingPages;
+		uint64_t m_NextSequence;
+		std::vector<std::string> m_Segments;
+		std::thread m_MergeThread;
+		bool m_Merging;
+	}; // class TextIndexer
+
+	struct SearchHit
+	{
+		std::string sourceFile;
+		std::vector<int> pages; // 0 부터 시작하는 페이지 번호, 증가 순서
+	}; // struct SearchHit
+
+	// 색인 폴더의 모든 세그먼트에서 검색한다.
+	class TextIndexReader
+	{
+	public:
+		bool Open(const std::string& indexDir);
+		void Close();
+		size_t SegmentCount() const { return m_Segments.size(); }
+
+		// 질의의 모든 색인어가 나오는 페이지 (AND). 문서 경로 순서로 정렬한다.
+		bool Search(const std::string& query, std::vector<SearchHit>& hits) const;
+
+	private:
+		std::vector<std::unique_ptr<IndexSegment>> m_Segments;
+	}; // class TextIndexReader
+
+}} // PDF::Converter
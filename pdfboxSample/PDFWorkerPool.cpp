@@ -0,0 +1,118 @@
+﻿// PDFWorkerPool.cpp
+#include "PDFWorkerPool.h"
+#include "pdf_assert.h"
+
+namespace PDF { namespace Converter {
+
+	WorkerPool::WorkerPool()
+	: m_Capacity(0)
+	, m_Running(false)
+	{
+	}
+
+	WorkerPool::~WorkerPool()
+	{
+		Stop();
+	}
+
+	bool WorkerPool::Start(int threads, size_t capacity, const ThreadHook& onStart, const ThreadHook& onStop)
+	{
+		_ASSERTE(threads > 0 && capacity > 0 && "invalid arguments");
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		_ASSERTE(!m_Running && m_Threads.empty() && "already started");
+		if (threads <= 0 || capacity == 0 || m_Running || !m_Threads.empty()) {
+			return false;
+		}
+
+		m_Capacity = capacity;
+		m_Running = true;
+		for (int i = 0; i < threads; i++) {
+			m_Threads.emplace_back(&WorkerPool::work, this, onStart, onStop);
+		}
+		return true;
+	}
+
+	void WorkerPool::Stop()
+	{
+		std::deque<Task> dropped;
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			m_Running = false;
+			dropped.swap(m_Queue);
+		}
+		m_Pushed.notify_all();
+		m_Popped.notify_all();
+		for (std::thread& thread : m_Threads) {
+			thread.join();
+		}
+		m_Threads.clear();
+
+		for (Task& task : dropped) {
+			task(false);
+		}
+	}
+
+	bool WorkerPool::TryPush(const Task& task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_Mutex);
+			if (!m_Running || m_Queue.size() >= m_Capacity) {
+				return false;
+			}
+			m_Queue.push_back(task);
+		}
+		m_Pushed.notify_one();
+		return true;
+	}
+
+	bool WorkerPool::Push(const Task& task)
+	{
+		{
+			std::unique_lock<std::mutex> lock(m_Mutex);
+			m_Popped.wait(lock, [&]() { return !m_Running || m_Queue.size() < m_Capacity; });
+			if (!m_Running) {
+				return false;
+			}
+			m_Queue.push_back(task);
+		}
+		m_Pushed.notify_one();
+		return true;
+	}
+
+	size_t WorkerPool::Pending() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Queue.size();
+	}
+
+	bool WorkerPool::Running() const
+	{
+		std::lock_guard<std::mutex> lock(m_Mutex);
+		return m_Running;
+	}
+
+	void WorkerPool::work(const ThreadHook& onStart, const ThreadHook& onStop)
+	{
+		if (onStart) {
+			onStart();
+		}
+		for (;;) {
+			Task task;
+			{
+				std::unique_lock<std::mutex> lock(m_Mutex);
+				m_Pushed.wait(lock, [&]() { return !m_Running || !m_Queue.empty(); });
+				if (!m_Running) {
+					break;
+				}
+				task = std::move(m_Queue.front());
+				m_Queue.pop_front();
+			}
+			m_Popped.notify_one();
+			task(true);
+		}
+		if (onStop) {
+			onStop();
+		}
+	}
+
+}} // PDF::Converter
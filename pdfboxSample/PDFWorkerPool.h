@@ -0,0 +1,51 @@
+﻿// PDFWorkerPool.h
+#pragma once
+#include <vector> // std::vector
+#include <deque> // std::deque
+#include <functional> // std::function
+#include <thread> // std::thread
+#include <mutex> // std::mutex
+#include <condition_variable> // std::condition_variable
+
+namespace PDF { namespace Converter {
+
+	// 크기가 정해진 대기 큐와 작업자 스레드
+	class WorkerPool
+	{
+	public:
+		using Task = std::function<void(bool run)>; // 멈출 때 실행하지 못한 작업은 run = false 로 호출된다.
+		using ThreadHook = std::function<void()>;
+
+	public:
+		WorkerPool();
+		~WorkerPool();
+
+	public:
+		// onStart, onStop 은 작업자 스레드마다 시작, 종료 시 호출된다. (JavaVM 에 붙이고 떼기)
+		bool Start(int threads, size_t capacity, const ThreadHook& onStart, const ThreadHook& onStop);
+		void Stop(); // 실행 중인 작업이 끝나길 기다리고 대기 중인 작업은 run = false 로 끝낸다.
+
+		bool TryPush(const Task& task); // 큐가 가득 찼으면 false
+		bool Push(const Task& task); // 자리가 날 때까지 기다린다. 멈춘 풀이면 false
+
+		size_t Pending() const;
+		size_t Capacity() const { return m_Capacity; }
+		bool Running() const;
+
+	private:
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+
+		void work(const ThreadHook& onStart, const ThreadHook& onStop);
+
+	private:
+		std::vector<std::thread> m_Threads;
+		std::deque<Task> m_Queue;
+		size_t m_Capacity;
+		bool m_Running;
+		mutable std::mutex m_Mutex;
+		std::condition_variable m_Pushed;
+		std::condition_variable m_Popped;
+	}; // class WorkerPool
+
+}} // PDF::Converter
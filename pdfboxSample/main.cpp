@@ -1,12 +1,24 @@
 ﻿// main.cpp
 
 #include "PDFBoxConverter.h"
+#include "PDFStructureScanner.h"
+#include "PDFBatchScheduler.h"
+#include "PDFSharedRing.h"
+#include "PDFStructuredText.h"
+#include "PDFTextIndex.h"
+#include "PDFDuplicateDetector.h"
 #include <vector> // std::vector
 #include <string> // std::string
 #include <memory> // std::unique_ptr
 #include <chrono> // std::chrono
 #include <iostream> // std::cout
 #include <algorithm> // std::transform
+#include <sstream> // std::stringstream
+#include <fstream> // std::ifstream
+#include <mutex> // std::mutex
+#include <future> // std::future
+#include <cmath> // std::lround
+#include <stdio.h> // snprintf
 #include <stdlib.h> // mbstowcs()
 #include "cmdline.h" // cmdline::parser
 #include "pdf_utils.h"
@@ -18,6 +30,18 @@
 #   include <sys/stat.h> // stat
 #   include <libgen.h> // dirname, basename
 #	include <unistd.h> // access
+#   include <signal.h> // signal
+#endif
+
+#ifndef _WIN32
+// SIGINT, SIGTERM 을 받으면 --serve 를 끝낸다.
+static PDF::Converter::SharedRingServer* s_SharedRingServer = nullptr;
+static void stopSharedRingServer(int)
+{
+	if (s_SharedRingServer) {
+		s_SharedRingServer->Stop();
+	}
+}
 #endif
 
 int main(int argc, char* argv[])
@@ -26,9 +50,47 @@ int main(int argc, char* argv[])
 	setlocale(LC_ALL, "" );
 
 	cmdline::parser parser;
-    parser.add<std::string>("source", 's', "PDF absolute file path", true, "");
-    parser.add<std::string>("result", 'r', "result absolute dir", true, "");
-    parser.add<std::string>("type", 't', "convert type", false, "png", cmdline::oneof<std::string>("png", "txt"));
+    parser.add<std::string>("source", 's', "PDF absolute file path", false, "");
+    parser.add<std::string>("result", 'r', "result absolute dir", false, "");
+    parser.add<std::string>("type", 't', "convert type (png, txt, dzi or combined outputs of one pass : png,txt[,json][,stx])", false, "png");
+    parser.add<std::string>("format", 'f', "png pixel format", false, "default", cmdline::oneof<std::string>("default", "gray", "mono", "rgb", "rgba"));
+    parser.add<int>("dpi", 'd', "png resolution", false, 96, cmdline::range(1, 2400));
+    parser.add<std::string>("tile", 0, "png tiled rendering", false, "auto", cmdline::oneof<std::string>("auto", "never", "always"));
+    parser.add<int>("tile-size", 0, "png tile size (pixel)", false, 2048, cmdline::range(64, 16384));
+    parser.add<std::string>("variants", 0, "png variants from one render (ex. 300,96,256px)", false, "");
+    parser.add<int>("preview-dpi", 0, "png progressive preview resolution (0 = off)", false, 0, cmdline::range(0, 600));
+    parser.add("blank", 0, "png : measure the ink coverage of every rendered page");
+    parser.add<int>("blank-skip", 0, "png : do not write pages whose ink coverage is below this (ppm of page pixels, ex. 500, 0 = keep)", false, 0, cmdline::range(0, 1000000));
+    parser.add("crop", 0, "png : crop white page margins (offsets are written to <name>_pages.json)");
+    parser.add<int>("crop-padding", 0, "png : margin kept around the cropped content (pixel)", false, 8, cmdline::range(0, 4096));
+    parser.add<int>("threads", 0, "dzi worker threads (0 = cpu count)", false, 0, cmdline::range(0, 256));
+    parser.add<std::string>("batch", 0, "batch list file (one PDF path per line, \"@queue\" line selects the queue of following paths)", false, "");
+    parser.add<std::string>("queues", 0, "batch queues name[:priority[:weight]] (ex. interactive:1,bulk:0:1,reindex:0:3)", false, "");
+    parser.add<std::string>("policy", 0, "batch schedule policy (sjf = shortest first, ljf = longest first)", false, "sjf", cmdline::oneof<std::string>("fifo", "sjf", "ljf"));
+    parser.add<int>("workers", 0, "batch concurrent conversions", false, 1, cmdline::range(1, 64));
+    parser.add<int>("memory-budget", 0, "memory budget for concurrent conversions (MB, 0 = unlimited)", false, 0, cmdline::range(0, 1024 * 1024));
+    parser.add<std::string>("memory-policy", 0, "where PDFBox keeps parsed document streams (png, txt)", false, "default", cmdline::oneof<std::string>("default", "main", "mixed", "temp"));
+    parser.add<int>("heap-limit", 0, "main : heap limit, mixed : heap part of document streams (MB, 0 = unlimited for main)", false, 64, cmdline::range(0, 1024 * 1024));
+    parser.add<std::string>("scratch-dir", 0, "mixed, temp : PDFBox temp file directory (default : system temp)", false, "");
+    parser.add<int>("timeout", 0, "per conversion deadline (ms, 0 = none), stops between pages and keeps finished pages", false, 0, cmdline::range(0, 24 * 60 * 60 * 1000));
+    parser.add<std::string>("report", 0, "batch report csv file (default : <result>/batch_report.csv)", false, "");
+    parser.add<int>("queue", 0, "async batch queue capacity", false, 16, cmdline::range(1, 4096));
+    parser.add<std::string>("serve", 0, "serve same-host clients through a shared memory ring on this unix socket path (linux)", false, "");
+    parser.add<std::string>("font-cache", 0, "PDFBox font cache directory (default : user home)", false, "");
+    parser.add("build-font-cache", 0, "scan system fonts and write the PDFBox font cache, then exit");
+    parser.add("warmup", 0, "repeat render and text extraction of the warm-up corpus until the iteration time is stable");
+    parser.add<std::string>("warmup-corpus", 0, "warm-up PDF files (ex. a.pdf,b.pdf, default : samples/sample01.pdf next to the executable)", false, "");
+    parser.add<std::string>("ready-file", 0, "serve : file created when warm-up is done and the socket accepts clients, removed on exit", false, "");
+    parser.add("async", 0, "batch through SubmitImage/SubmitText in list order (png, txt)");
+    parser.add("inspect", 0, "print page count, encryption, linearization and page boxes without the JVM");
+    parser.add<std::string>("find", 0, "print boxes of the word in a structured text (.stx) source without the JVM", false, "");
+    parser.add<std::string>("index", 0, "add extracted page text to the inverted index in this directory (txt, combined)", false, "");
+    parser.add<std::string>("dedup", 0, "batch : cluster near-duplicate documents by text MinHash and page hash, and write the clusters to this csv file", false, "");
+    parser.add<int>("dedup-probe", 0, "batch dedup : skip remaining pages when the first N pages match an earlier document (0 = off)", false, 0, cmdline::range(0, 1000));
+    parser.add<int>("max-pages", 0, "txt : extract only the first N pages (0 = all)", false, 0, cmdline::range(0, 1000000));
+    parser.add<int>("max-chars", 0, "txt : stop after N characters (0 = all)", false, 0, cmdline::range(0, 1000000000));
+    parser.add<int>("text-budget", 0, "txt : stop extracting after this time (ms, 0 = none), keeps extracted pages", false, 0, cmdline::range(0, 24 * 60 * 60 * 1000));
+    parser.add<std::string>("query", 0, "print pages containing all words of the query from --index without the JVM", false, "");
     parser.add("help", 0, "print this message");
     parser.set_program_name("pdfboxTester");
 
@@ -42,28 +104,310 @@ int main(int argc, char* argv[])
     std::string source = parser.get<std::string>("source");
     std::string result = parser.get<std::string>("result");
     std::string type = parser.get<std::string>("type");
+    std::string format = parser.get<std::string>("format");
+    std::string tile = parser.get<std::string>("tile");
+    const bool inspect = parser.exist("inspect");
+    const std::string find = parser.get<std::string>("find");
+    const std::string index = parser.get<std::string>("index");
+    const std::string query = parser.get<std::string>("query");
+    const std::string dedup = parser.get<std::string>("dedup");
+    const bool async = parser.exist("async");
+    std::string batch = parser.get<std::string>("batch");
+    std::string policy = parser.get<std::string>("policy");
+    const std::string serve = parser.get<std::string>("serve");
+    const bool buildFontCache = parser.exist("build-font-cache");
+    PDF::Converter::ConvertOutputs outputs; // 여러 출력을 지정했을 때
+    bool combined = false;
 
     {
-        // type 문자열 소문자로 변경
+        // type, format, tile 문자열 소문자로 변경
         std::transform(type.begin(), type.end(), type.begin(), ::tolower);
+        std::transform(format.begin(), format.end(), format.begin(), ::tolower);
+        std::transform(tile.begin(), tile.end(), tile.begin(), ::tolower);
+        std::transform(policy.begin(), policy.end(), policy.begin(), ::tolower);
 
-        // PDF 파일이 존재하는지 체크
-        if (!pathFileExists(source.c_str())) {
-            std::cerr << "source file is not valid path";
+        // png,txt 처럼 여러 출력을 지정하면 문서를 한번 열어 페이지마다 모두 만든다. (json 은 문서 정보)
+        if (type.find(',') != std::string::npos || type == "json" || type == "stx") {
+            std::stringstream types(type);
+            std::string item;
+            outputs.image = outputs.text = false;
+            while (std::getline(types, item, ',')) {
+                if (item == "png") {
+                    outputs.image = true;
+                } else if (item == "txt") {
+                    outputs.text = true;
+                } else if (item == "json") {
+                    outputs.metadata = true;
+                } else if (item == "stx") {
+                    outputs.structuredText = true;
+                } else {
+                    std::cerr << "type is not valid : " << item;
+                    return 0;
+                }
+            }
+            combined = true;
+        } else if (type != "png" && type != "txt" && type != "dzi") {
+            std::cerr << "type is not valid : " << type;
             return 0;
         }
 
-        // 결과 폴더가 존재하는지 체크
-        if (!pathIsDirectory(result.c_str())) {
-            std::cerr << "result directory is not exist";
+        // PDF 파일 또는 배치 목록 파일이 존재하는지 체크
+#ifdef _WIN32
+        if (!serve.empty()) {
+            std::cerr << "serve is only for linux";
+            return 0;
+        }
+#endif
+        if (!query.empty() && index.empty()) {
+            std::cerr << "query needs index directory";
+            return 0;
+        }
+        if (!index.empty() && query.empty() && type != "txt" && !combined) {
+            std::cerr << "index is only for txt or combined types";
             return 0;
         }
-        result = pathAddSeparator(result);
+        if (batch.empty() && serve.empty() && !buildFontCache && query.empty() && !pathFileExists(source.c_str())) {
+            std::cerr << "source file is not valid path";
+            return 0;
+        }
+        if (!batch.empty() && (inspect || !pathFileExists(batch.c_str()))) {
+            std::cerr << "batch list file is not valid path";
+            return 0;
+        }
+        if (async && (batch.empty() || type == "dzi" || combined)) {
+            std::cerr << "async is only for png, txt batch";
+            return 0;
+        }
+        if (!dedup.empty() && batch.empty()) {
+            std::cerr << "dedup is only for batch";
+            return 0;
+        }
+        if (parser.get<int>("dedup-probe") > 0 && dedup.empty()) {
+            std::cerr << "dedup-probe needs dedup report file";
+            return 0;
+        }
+
+        // 결과 폴더가 존재하는지 체크 (--inspect, --serve, --build-font-cache 는 결과 폴더가 필요 없다)
+        if (!inspect && find.empty() && query.empty() && serve.empty() && !buildFontCache) {
+            if (!pathIsDirectory(result.c_str())) {
+                std::cerr << "result directory is not exist";
+                return 0;
+            }
+            result = pathAddSeparator(result);
+        }
     }
 
 	const std::wstring samplePath = _A2U(source);
     const std::wstring resultDir= _A2U(result);
 
+    // PDF 구조 분석 (JVM 을 띄우지 않는다)
+    if (inspect) {
+        std::cout << "[Begin] : inspect " << source << std::endl;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        PDF::Converter::DocumentStructure structure;
+        if (!PDF::Converter::ScanStructure(samplePath.c_str(), structure)) {
+            std::cerr << "ScanStructure() Failed()" << std::endl;
+            return 0;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        std::cout << "    version = " << structure.version << std::endl;
+        std::cout << "    file size = " << structure.fileSize << std::endl;
+        std::cout << "    pages = " << structure.pageCount << (structure.pagesComplete ? "" : " (page tree not readable)") << std::endl;
+        std::cout << "    encrypted = " << (structure.encrypted ? "yes" : "no") << std::endl;
+        std::cout << "    linearized = " << (structure.linearized ? "yes" : "no") << std::endl;
+        std::cout << "    xref stream = " << (structure.xrefStream ? "yes" : "no") << std::endl;
+        std::cout << "    repaired = " << (structure.repaired ? "yes" : "no") << std::endl;
+        std::cout << "    images = " << structure.imageCount << " (" << structure.imageBytes << " bytes)" << std::endl;
+        for (size_t i = 0; i < structure.pages.size(); i++) {
+            const PDF::Converter::PageGeometry& page = structure.pages[i];
+            std::cout << "    page " << i + 1 << " : " << page.Width() << " x " << page.Height() << " pt, MediaBox ["
+                << page.mediaBox[0] << " " << page.mediaBox[1] << " " << page.mediaBox[2] << " " << page.mediaBox[3] << "], Rotate " << page.rotate << std::endl;
+        }
+        std::cout << "    Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]" << std::endl;
+        std::cout << "[End] : inspect " << source << std::endl;
+        return 0;
+    }
+
+    // 구조화 텍스트에서 단어 영역 찾기 (JVM 을 띄우지 않는다)
+    if (!find.empty()) {
+        std::cout << "[Begin] : find \"" << find << "\" in " << source << std::endl;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        PDF::Converter::StructuredTextReader reader;
+        if (!reader.Open(source.c_str())) {
+            std::cerr << "StructuredTextReader::Open() Failed()" << std::endl;
+            return 0;
+        }
+        std::vector<PDF::Converter::TextBox> boxes;
+        reader.FindWords(find, boxes);
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        for (const PDF::Converter::TextBox& box : boxes) {
+            std::cout << "    page " << box.pageIndex + 1 << " word " << box.word << " : [" << box.left << " " << box.top << " " << box.right << " " << box.bottom << "] pt" << std::endl;
+        }
+        std::cout << "    " << boxes.size() << " boxes in " << reader.PageCount() << " pages" << std::endl;
+        std::cout << "    Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]" << std::endl;
+        std::cout << "[End] : find " << source << std::endl;
+        return 0;
+    }
+
+    // 역색인 검색 (JVM 을 띄우지 않는다)
+    if (!query.empty()) {
+        std::cout << "[Begin] : query \"" << query << "\" in " << index << std::endl;
+        std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+        PDF::Converter::TextIndexReader reader;
+        std::vector<PDF::Converter::SearchHit> hits;
+        if (!reader.Open(index) || !reader.Search(query, hits)) {
+            std::cerr << "TextIndexReader Search() Failed()" << std::endl;
+            return 0;
+        }
+        std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+        for (const PDF::Converter::SearchHit& hit : hits) {
+            std::cout << "    " << hit.sourceFile << " : pages";
+            for (int page : hit.pages) {
+                std::cout << " " << page + 1;
+            }
+            std::cout << std::endl;
+        }
+        std::cout << "    " << hits.size() << " documents in " << reader.SegmentCount() << " segments" << std::endl;
+        std::cout << "    Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]" << std::endl;
+        std::cout << "[End] : query " << index << std::endl;
+        return 0;
+    }
+
+    PDF::Converter::ImageOptions imageOptions;
+    imageOptions.dpi = parser.get<int>("dpi");
+    imageOptions.tileSize = parser.get<int>("tile-size");
+    if (format == "gray") {
+        imageOptions.format = PDF::Converter::PixelFormat::Gray;
+    } else if (format == "mono") {
+        imageOptions.format = PDF::Converter::PixelFormat::Mono;
+    } else if (format == "rgb") {
+        imageOptions.format = PDF::Converter::PixelFormat::RGB;
+    } else if (format == "rgba") {
+        imageOptions.format = PDF::Converter::PixelFormat::RGBA;
+    }
+    // 해상도 변형 목록 : 숫자는 DPI, px 로 끝나면 긴 변의 픽셀 수
+    {
+        std::stringstream variants(parser.get<std::string>("variants"));
+        std::string item;
+        while (std::getline(variants, item, ',')) {
+            PDF::Converter::ImageVariant variant;
+            int value = atoi(item.c_str());
+            if (value <= 0) {
+                std::cerr << "variants is not valid : " << item;
+                return 0;
+            }
+            if (item.size() > 2 && item.compare(item.size() - 2, 2, "px") == 0) {
+                variant.maxSize = value;
+            } else {
+                variant.dpi = value;
+            }
+            imageOptions.variants.push_back(variant);
+        }
+    }
+    // 빈 페이지 검출
+    imageOptions.blankPages.skipBelow = parser.get<int>("blank-skip") / 1000000.0;
+    imageOptions.blankPages.detect = parser.exist("blank") || imageOptions.blankPages.skipBelow > 0.0;
+    // 여백 자르기
+    imageOptions.autoCrop.enabled = parser.exist("crop");
+    imageOptions.autoCrop.padding = parser.get<int>("crop-padding");
+
+    PDF::Converter::PyramidOptions pyramidOptions;
+    pyramidOptions.dpi = imageOptions.dpi;
+    pyramidOptions.threads = parser.get<int>("threads");
+    if (imageOptions.format != PDF::Converter::PixelFormat::Default) {
+        pyramidOptions.format = imageOptions.format;
+    }
+
+    PDF::Converter::ProgressiveOptions progressiveOptions;
+    progressiveOptions.previewDPI = parser.get<int>("preview-dpi");
+    progressiveOptions.dpi = imageOptions.dpi;
+    if (imageOptions.format != PDF::Converter::PixelFormat::Default) {
+        progressiveOptions.format = imageOptions.format;
+    }
+
+    PDF::Converter::BatchOptions batchOptions;
+    batchOptions.workers = parser.get<int>("workers");
+    batchOptions.dpi = (type == "txt" || (combined && !outputs.image)) ? 0 : imageOptions.dpi;
+    if (policy == "fifo") {
+        batchOptions.policy = PDF::Converter::SchedulePolicy::FIFO;
+    } else if (policy == "ljf") {
+        batchOptions.policy = PDF::Converter::SchedulePolicy::LongestFirst;
+    }
+    std::string report = parser.get<std::string>("report");
+    if (report.empty()) {
+        report = result + "batch_report.csv";
+    }
+
+    // 변환마다 새 기한을 정한다.
+    const int timeout = parser.get<int>("timeout");
+    auto newCancelToken = [timeout]() -> std::shared_ptr<PDF::Converter::CancelToken> {
+        if (timeout <= 0) {
+            return nullptr;
+        }
+        std::shared_ptr<PDF::Converter::CancelToken> cancelToken = std::make_shared<PDF::Converter::CancelToken>();
+        cancelToken->SetTimeout(std::chrono::milliseconds(timeout));
+        return cancelToken;
+    };
+    auto cancelledText = [](const PDF::Converter::ConvertResult& convertResult) -> std::string {
+        if (convertResult.truncated) {
+            return std::string(convertResult.duplicate ? " Duplicate" : " Truncated") + " (" + std::to_string(convertResult.completedPages) + "/" + std::to_string(convertResult.pageCount) + " pages)";
+        }
+        if (!convertResult.cancelled) {
+            return "";
+        }
+        return std::string(convertResult.deadlineExceeded ? " Timeout" : " Cancelled") + " (" + std::to_string(convertResult.completedPages)
+            + "/" + std::to_string(convertResult.pageCount) + " pages)";
+    };
+
+    // 문서 스트림 메모리 설정
+    {
+        std::string memoryPolicy = parser.get<std::string>("memory-policy");
+        std::transform(memoryPolicy.begin(), memoryPolicy.end(), memoryPolicy.begin(), ::tolower);
+        if (memoryPolicy == "main") {
+            imageOptions.memory.policy = PDF::Converter::MemoryPolicy::MainMemory;
+        } else if (memoryPolicy == "mixed") {
+            imageOptions.memory.policy = PDF::Converter::MemoryPolicy::Mixed;
+        } else if (memoryPolicy == "temp") {
+            imageOptions.memory.policy = PDF::Converter::MemoryPolicy::TempFile;
+        }
+        imageOptions.memory.mainMemoryBytes = static_cast<int64_t>(parser.get<int>("heap-limit")) * 1024 * 1024;
+        imageOptions.memory.scratchDir = _A2U(parser.get<std::string>("scratch-dir"));
+    }
+    // 미리보기, 분류용 텍스트 추출 한도
+    PDF::Converter::TextBudget textBudget;
+    textBudget.maxPages = parser.get<int>("max-pages");
+    textBudget.maxCharacters = static_cast<size_t>(parser.get<int>("max-chars"));
+    textBudget.timeBudget = std::chrono::milliseconds(parser.get<int>("text-budget"));
+
+    // 페이지별 잉크 비율 (main() 이 로케일을 바꾸므로 정수로 소수점을 쓴다.)
+    auto blankText = [](const PDF::Converter::ConvertResult& convertResult) -> std::string {
+        if (convertResult.inkCoverage.empty()) {
+            return "";
+        }
+        std::string text = " (ink";
+        for (size_t i = 0; i < convertResult.inkCoverage.size(); i++) {
+            const long basisPoints = std::lround(std::max(convertResult.inkCoverage[i], 0.0f) * 10000.0f);
+            char coverage[32] = { 0, };
+            snprintf(coverage, sizeof(coverage), " %d:%ld.%02ld%%", static_cast<int>(i + 1), basisPoints / 100, basisPoints % 100);
+            text += coverage;
+        }
+        return text + ", skipped " + std::to_string(convertResult.blankPages) + " blank pages)";
+    };
+
+    auto memoryText = [](const PDF::Converter::ConvertResult& convertResult) -> std::string {
+        if (convertResult.heapLimitBytes < 0 && convertResult.scratchBytes == 0) {
+            return "";
+        }
+        return " (heap limit " + (convertResult.heapLimitBytes < 0 ? std::string("none") : std::to_string(convertResult.heapLimitBytes / (1024 * 1024)) + "MB")
+            + ", scratch " + std::to_string(convertResult.scratchBytes / 1024) + "KB)";
+    };
+
+    if (tile == "never") {
+        imageOptions.tileMode = PDF::Converter::TileMode::Never;
+    } else if (tile == "always") {
+        imageOptions.tileMode = PDF::Converter::TileMode::Always;
+    }
+
 #ifdef _WIN32
 	// 환경변수 설정
 	{
@@ -88,26 +432,291 @@ int main(int argc, char* argv[])
 	// PDF -> PNG, PDF -> TXT 변환
 	{
 		PDF::Converter::PDFBox pdfConverter;
-		bool result  = pdfConverter.Init();
+		PDF::Converter::InitOptions initOptions;
+		initOptions.fontCacheDir = _A2U(parser.get<std::string>("font-cache"));
+		bool result  = pdfConverter.Init(initOptions);
 		if (!result) {
 			std::cerr << "PDFBox Init() Failed()";
 			return 0;
 		}
+		// 캐시가 없으면 첫 변환이 시스템 폰트를 검색하느라 느리다.
+		std::cout << "    font cache : " << (pdfConverter.FontCacheWarm() ? "warm" : "cold") << " (" << _U2A(pdfConverter.FontCacheFile()) << ")" << std::endl;
+		if (buildFontCache) {
+			std::chrono::steady_clock::time_point fontBegin = std::chrono::steady_clock::now();
+			result = pdfConverter.BuildFontCache();
+			std::cout << "    build font cache : " << (result ? "done" : "Failed") << " ("
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - fontBegin).count() << "[ms])" << std::endl;
+			pdfConverter.Fini();
+			return 0;
+		}
+		if (parser.exist("warmup")) {
+			// JIT 컴파일이 끝나기 전의 변환은 안정 상태보다 몇 배 느리다.
+			PDF::Converter::WarmupOptions warmupOptions;
+			warmupOptions.dpi = imageOptions.dpi;
+			std::stringstream corpus(parser.get<std::string>("warmup-corpus"));
+			std::string item;
+			while (std::getline(corpus, item, ',')) {
+				warmupOptions.corpus.push_back(_A2U(item));
+			}
+			PDF::Converter::WarmupResult warmupResult;
+			const bool warmed = pdfConverter.WarmUp(warmupOptions, &warmupResult);
+			std::cout << "    warm-up : " << warmupResult.iterations << " iterations, " << warmupResult.seconds << "[s], first "
+				<< warmupResult.firstIterationSeconds << "[s] -> steady " << warmupResult.steadyIterationSeconds << "[s]"
+				<< (warmupResult.stabilized ? "" : " (not stabilized)") << (warmed ? "" : " Failed") << std::endl;
+		}
+
+		pdfConverter.SetMemoryBudget(static_cast<int64_t>(parser.get<int>("memory-budget")) * 1024 * 1024);
+
+#ifndef _WIN32
+		if (!serve.empty()) {
+			// 클라이언트가 작업 링에 넣은 변환을 실행하고 결과를 공유 메모리 슬롯으로 돌려준다.
+			PDF::Converter::SharedRingServer server(pdfConverter, PDF::Converter::SharedRingOptions());
+			s_SharedRingServer = &server;
+			signal(SIGINT, stopSharedRingServer);
+			signal(SIGTERM, stopSharedRingServer);
+			std::cout << "[Begin] : serve " << serve << std::endl;
+			// 워밍업이 끝난 뒤에 소켓을 열기 때문에 준비 파일이 생기면 바로 요청을 받을 수 있다.
+			const std::string readyFile = parser.get<std::string>("ready-file");
+			result = server.Serve(serve, [&readyFile]() {
+				std::cout << "[Ready] : serve" << std::endl;
+				if (!readyFile.empty()) {
+					std::ofstream(readyFile.c_str()) << getpid() << std::endl;
+				}
+			});
+			if (!readyFile.empty()) {
+				unlink(readyFile.c_str());
+			}
+			s_SharedRingServer = nullptr;
+			if (!result) {
+				std::cerr << "SharedRingServer Serve() Failed()" << std::endl;
+			}
+			std::cout << "[End] : serve " << serve << std::endl;
+			return 0;
+		}
+#endif
+
+        // 변환 스레드들이 추출한 페이지 텍스트를 하나의 색인에 모은다.
+        std::shared_ptr<PDF::Converter::TextIndexer> indexer;
+        if (!index.empty()) {
+            indexer = std::make_shared<PDF::Converter::TextIndexer>();
+            if (!indexer->Open(index)) {
+                std::cerr << "TextIndexer Open() Failed()" << std::endl;
+                pdfConverter.Fini();
+                return 0;
+            }
+        }
+
+        // 일괄 변환한 문서들의 텍스트와 페이지 해시로 거의 같은 문서를 묶는다.
+        std::shared_ptr<PDF::Converter::DuplicateDetector> duplicates;
+        if (!dedup.empty()) {
+            PDF::Converter::DuplicateOptions duplicateOptions;
+            duplicateOptions.probePages = parser.get<int>("dedup-probe");
+            duplicates = std::make_shared<PDF::Converter::DuplicateDetector>(duplicateOptions);
+        }
 
         std::cout << "[Begin] : PDFBox pdf to " << type << std::endl;
 		std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
-		{
-			if (type == "png") {
-				result = pdfConverter.ToImage(samplePath.c_str(), resultDir.c_str());
+		std::vector<std::wstring> batchSources;
+		std::vector<std::string> batchQueues; // batchSources 의 큐 이름
+		if (!batch.empty()) {
+			std::string queue;
+			std::ifstream list(batch.c_str());
+			std::string line;
+			while (std::getline(list, line)) {
+				if (!line.empty() && line.back() == '\r') {
+					line.pop_back();
+				}
+				if (line.empty() || line[0] == '#') {
+					continue;
+				}
+				if (line[0] == '@') {
+					queue = line.substr(1);
+					continue;
+				}
+				if (!pathFileExists(line.c_str())) {
+					std::cerr << "batch source is not valid path : " << line << std::endl;
+					continue;
+				}
+				batchSources.push_back(_A2U(line));
+				batchQueues.push_back(queue);
+			}
+		}
+
+		if (async) {
+			// 목록 순서대로 제출하고 큐가 가득 차면 자리가 날 때까지 기다린다.
+			result = pdfConverter.StartWorkers(batchOptions.workers, static_cast<size_t>(parser.get<int>("queue")));
+			std::mutex coutMutex;
+			std::vector<std::future<PDF::Converter::ConvertResult>> futures;
+			for (size_t i = 0; i < batchSources.size() && result; i++) {
+				PDF::Converter::AsyncOptions asyncOptions;
+				asyncOptions.blockWhenFull = true;
+				asyncOptions.callback = [&, i](const PDF::Converter::ConvertResult& convertResult) {
+					std::lock_guard<std::mutex> lock(coutMutex);
+					std::cout << "    [" << i + 1 << "] " << _U2A(batchSources[i]) << " : "
+						<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count() << "[ms]"
+						<< (convertResult.succeeded ? "" : " Failed") << cancelledText(convertResult) << memoryText(convertResult) << blankText(convertResult) << std::endl;
+				};
+				if (type == "png") {
+					PDF::Converter::ImageOptions jobOptions = imageOptions;
+					jobOptions.duplicates = duplicates;
+					jobOptions.cancelToken = newCancelToken();
+					futures.push_back(pdfConverter.SubmitImage(batchSources[i], resultDir, jobOptions, asyncOptions));
+				} else {
+					PDF::Converter::TextOptions jobOptions;
+					jobOptions.memory = imageOptions.memory;
+					jobOptions.indexer = indexer;
+					jobOptions.budget = textBudget;
+					jobOptions.duplicates = duplicates;
+					jobOptions.cancelToken = newCancelToken();
+					futures.push_back(pdfConverter.SubmitText(batchSources[i], resultDir, jobOptions, asyncOptions));
+				}
+			}
+			for (std::future<PDF::Converter::ConvertResult>& future : futures) {
+				result = future.valid() && future.get().succeeded && result;
+			}
+			pdfConverter.StopWorkers();
+			if (!result) {
+				std::cerr << "PDFBox async batch Failed()" << std::endl;
+			}
+		} else if (!batch.empty()) {
+			// 구조 분석으로 비용을 추정하고 정책에 따라 순서를 정해 실행한다.
+			PDF::Converter::BatchScheduler scheduler(batchOptions);
+			std::stringstream queues(parser.get<std::string>("queues"));
+			std::string item;
+			while (std::getline(queues, item, ',')) {
+				// name[:priority[:weight]]
+				PDF::Converter::BatchQueue queue;
+				std::stringstream fields(item);
+				std::string field;
+				for (int i = 0; std::getline(fields, field, ':'); i++) {
+					if (i == 0) {
+						queue.name = field;
+					} else if (i == 1) {
+						queue.priority = atoi(field.c_str());
+					} else if (i == 2) {
+						queue.weight = atof(field.c_str());
+					}
+				}
+				scheduler.AddQueue(queue);
+			}
+			for (size_t i = 0; i < batchSources.size(); i++) {
+				scheduler.Add(batchSources[i], batchQueues[i]);
+			}
+
+			std::mutex coutMutex;
+			result = scheduler.Run([&](const PDF::Converter::BatchJob& job) -> bool {
+				bool jobResult = false;
+				PDF::Converter::ConvertResult convertResult;
+				if (combined) {
+					PDF::Converter::ConvertOptions jobOptions;
+					jobOptions.outputs = outputs;
+					jobOptions.image = imageOptions;
+					jobOptions.indexer = indexer;
+					jobOptions.duplicates = duplicates;
+					jobOptions.image.cancelToken = newCancelToken();
+					jobResult = pdfConverter.Convert(job.sourceFile.c_str(), resultDir.c_str(), jobOptions, &convertResult);
+				} else if (type == "png") {
+					PDF::Converter::ImageOptions jobOptions = imageOptions;
+					jobOptions.duplicates = duplicates;
+					jobOptions.cancelToken = newCancelToken();
+					jobResult = pdfConverter.ToImage(job.sourceFile.c_str(), resultDir.c_str(), jobOptions, &convertResult);
+				} else if (type == "dzi") {
+					PDF::Converter::PyramidOptions jobOptions = pyramidOptions;
+					jobOptions.cancelToken = newCancelToken();
+					jobResult = pdfConverter.ToPyramid(job.sourceFile.c_str(), resultDir.c_str(), jobOptions, &convertResult);
+				} else if (type == "txt") {
+					PDF::Converter::TextOptions jobOptions;
+					jobOptions.memory = imageOptions.memory;
+					jobOptions.indexer = indexer;
+					jobOptions.budget = textBudget;
+					jobOptions.duplicates = duplicates;
+					jobOptions.cancelToken = newCancelToken();
+					jobResult = pdfConverter.ToText(job.sourceFile.c_str(), resultDir.c_str(), jobOptions, &convertResult);
+				}
+				std::lock_guard<std::mutex> lock(coutMutex);
+				std::cout << "    [" << job.order + 1 << "] " << _U2A(job.sourceFile) << " : predicted " << job.predictedSeconds << "[s]"
+					<< (jobResult ? "" : " Failed") << cancelledText(convertResult) << memoryText(convertResult) << blankText(convertResult) << std::endl;
+				return jobResult;
+			});
+			if (!result) {
+				std::cerr << "PDFBox batch Failed()" << std::endl;
+			}
+			if (scheduler.WriteReport(report)) {
+				std::cout << "    batch report : " << report << " (makespan " << scheduler.Makespan() << "[s])" << std::endl;
+			}
+			for (const PDF::Converter::QueueStats& stats : scheduler.Statistics()) {
+				std::cout << "    queue \"" << stats.queue.name << "\" : " << stats.jobs << " jobs, mean wait " << stats.meanWaitSeconds
+					<< "[s], p95 latency " << stats.p95LatencySeconds << "[s], " << stats.pagesPerSecond << " pages/s" << std::endl;
+			}
+			if (pdfConverter.PeakAdmittedMemory() > 0) {
+				std::cout << "    peak admitted memory : " << pdfConverter.PeakAdmittedMemory() / (1024 * 1024) << "[MB]" << std::endl;
+			}
+		} else {
+			PDF::Converter::ConvertResult convertResult;
+			PDF::Converter::TextOptions textOptions;
+			textOptions.memory = imageOptions.memory;
+			textOptions.indexer = indexer;
+			textOptions.budget = textBudget;
+			imageOptions.cancelToken = newCancelToken();
+			pyramidOptions.cancelToken = imageOptions.cancelToken;
+			progressiveOptions.cancelToken = imageOptions.cancelToken;
+			textOptions.cancelToken = imageOptions.cancelToken;
+			if (combined) {
+				PDF::Converter::ConvertOptions convertOptions;
+				convertOptions.outputs = outputs;
+				convertOptions.image = imageOptions;
+				convertOptions.indexer = indexer;
+				result = pdfConverter.Convert(samplePath.c_str(), resultDir.c_str(), convertOptions, &convertResult);
+				if (!result) {
+					std::cerr << "PDFBox Convert() Failed()" << std::endl;
+				}
+			} else if (type == "png" && progressiveOptions.previewDPI > 0) {
+				std::mutex coutMutex;
+				progressiveOptions.callback = [&](PDF::Converter::RenderStage stage, int pageIndex, const std::wstring& imageFile) {
+					std::lock_guard<std::mutex> lock(coutMutex);
+					std::cout << "    " << (stage == PDF::Converter::RenderStage::Preview ? "[Preview] " : "[Final] ")
+						<< "page " << pageIndex + 1 << " : " << _U2A(imageFile) << " ("
+						<< std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - begin).count() << "[ms])" << std::endl;
+				};
+				result = pdfConverter.ToImageProgressive(samplePath.c_str(), resultDir.c_str(), progressiveOptions, &convertResult);
+				if (!result) {
+					std::cerr << "PDFBox ToImageProgressive() Failed()" << std::endl;
+				}
+			} else if (type == "png") {
+				result = pdfConverter.ToImage(samplePath.c_str(), resultDir.c_str(), imageOptions, &convertResult);
 				if (!result) {
 					std::cout << "PDFBox ToImage() Failed()" << std::endl;
 				}	
+			} else if (type == "dzi") {
+				result = pdfConverter.ToPyramid(samplePath.c_str(), resultDir.c_str(), pyramidOptions, &convertResult);
+				if (!result) {
+					std::cerr << "PDFBox ToPyramid() Failed()" << std::endl;
+				}
 			} else if (type == "txt") {
-				result = pdfConverter.ToText(samplePath.c_str(), resultDir.c_str());
+				result = pdfConverter.ToText(samplePath.c_str(), resultDir.c_str(), textOptions, &convertResult);
 				if (!result) {
 					std::cerr << "PDFBox ToText() Failed()" << std::endl;
 				}
 			}
+			if (convertResult.cancelled || convertResult.truncated) {
+				std::cout << "   " << cancelledText(convertResult) << std::endl;
+			}
+			if (!memoryText(convertResult).empty()) {
+				std::cout << "   " << memoryText(convertResult) << std::endl;
+			}
+			if (!blankText(convertResult).empty()) {
+				std::cout << "   " << blankText(convertResult) << std::endl;
+			}
+		}
+		if (indexer && !indexer->Close()) {
+			std::cerr << "TextIndexer Close() Failed()" << std::endl;
+		}
+		if (duplicates) {
+			if (duplicates->WriteReport(dedup)) {
+				std::cout << "    duplicate report : " << dedup << " (" << duplicates->Clusters().size() << " clusters)" << std::endl;
+			} else {
+				std::cerr << "DuplicateDetector WriteReport() Failed()" << std::endl;
+			}
 		}
 		std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
         std::cout << "    Time difference = " << std::chrono::duration_cast<std::chrono::microseconds>(end - begin).count() << "[µs]" << std::endl;
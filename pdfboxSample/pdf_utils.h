@@ -4,9 +4,11 @@
 #include <string> // std::string
 #include <vector> // std::vector
 #include <stdlib.h> // wcstombs, mbstowcs
+#include <errno.h> // errno
 
 #ifdef _WIN32
 #	include <Shlwapi.h> // PathFileExistsA, PathIsDirectoryA, PathFindFileNameA
+#	include <direct.h> // _mkdir
 #else
 #   include <sys/stat.h> // stat
 #	include <unistd.h> // access
@@ -131,6 +133,14 @@ namespace {
 		return false;
 	};
 
+	auto pathCreateDirectory = [](const char* const pszPath) -> bool {
+#ifdef _WIN32
+		return _mkdir(pszPath) == 0 || errno == EEXIST;
+#else
+		return mkdir(pszPath, 0755) == 0 || errno == EEXIST;
+#endif
+	};
+
 	auto pathAddSeparator = [](const std::string& dirPath) -> std::string {
 #ifdef _WIN32
 		const char PATH_SEPARATOR = '\\';